@@ -20,24 +20,17 @@ enum Commands : uint8_t
 	ToggleLED // Add any commands you wish
 };
 
-void commandReceivedCallback(const uint8_t commands[], const float throttles[], size_t length)
+/* One handler per command, called with the throttle of the received command. Commands without a handler (e.g. ToggleLED) are dropped. */
+void goForward(float throttle)
 {
-	// Do something with the received commands
-	for (size_t i = 0; i < length; i++)
-	{
-		if (commands[i] == GoForward)
-		{
-			// Go Forward
-			Serial.print("GoForward with throttle: ");
-			Serial.println(throttles[i]);
-		}
-		else if (commands[i] == GoBackward)
-		{
-			// Go Forward
-			Serial.print("GoBackward with throttle: ");
-			Serial.println(throttles[i]);
-		}
-	}
+	Serial.print("GoForward with throttle: ");
+	Serial.println(throttle);
+}
+
+void goBackward(float throttle)
+{
+	Serial.print("GoBackward with throttle: ");
+	Serial.println(throttle);
 }
 
 /* This second callback function is optional to receive binary payloads send via RemoteController::sendPayload(). */
@@ -52,7 +45,10 @@ unsigned long previousMillis = 0;
 void setup()
 {
 	Serial.begin(115200);
-	if (!rc.begin(commandReceivedCallback, payloadReceivedCallback))
+	// The commands are dispatched to their handlers, no command callback needed
+	rc.setCommandHandler(GoForward, goForward);
+	rc.setCommandHandler(GoBackward, goBackward);
+	if (!rc.begin(nullptr, payloadReceivedCallback))
 	{
 		// Failed to begin
 		Serial.println(rc.getErrorDescription());
@@ -14,6 +14,38 @@
 #define _String String
 #endif
 
+// Stream implementation (SerialConnection)
+#if defined(ARDUINO_ARCH_NATIVE)
+#include "NativeStream.h" // The subset of the Arduino Stream interface SerialConnection uses, FdStream implements it over a file descriptor (e.g. a pseudo-terminal)
+#define _Stream NativeStream
+#else
+#define _Stream Stream // Any Arduino Stream, e.g. HardwareSerial (Stream comes with Arduino.h)
+#endif
+
+// Time implementation (microseconds, overflows like Arduino micros())
+#if defined(ARDUINO_ARCH_NATIVE)
+#include <chrono>
+// Native tests can replace the steady clock with a virtual clock (see SimulatedConnection::useVirtualClock()), nullptr = steady clock
+typedef uint32_t (*rcmicros_source_t)();
+inline rcmicros_source_t &rcmicrosSource()
+{
+	static rcmicros_source_t source = nullptr;
+	return source;
+}
+inline uint32_t rcmicros()
+{
+	if (rcmicrosSource())
+		return rcmicrosSource()();
+	return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#else
+#include <Arduino.h>
+#define rcmicros() micros()
+#endif
+
+// Keeps the stack buffers of a rarely used path out of the frame of its caller (all supported toolchains are GCC based)
+#define RC_NOINLINE __attribute__((noinline))
+
 // Min & Max method implementation
 #define rcmin(a, b)((a) < (b) ? (a) : (b))
 #define rcmax(a, b) ((a) > (b) ? (a) : (b))
@@ -27,4 +59,63 @@
 // Arduino AVR boards such as Uno, Nano, Mega, etc. will use function pointers and
 #endif
 
+// Command handler table (RemoteController::setCommandHandler())
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_NATIVE)
+// Flat 256 entry lookup table, one byte per command id
+#define RC_ARCH_FLAT_COMMAND_HANDLER_TABLE
+#else
+// AVR has too little RAM for the 256 byte table, the few registered commands are searched instead
+#endif
+
+// CRC implementation (RemoteController::setFrameCheck())
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_NATIVE)
+// 256 entry lookup tables, one lookup per byte
+#define RC_ARCH_CRC_TABLE
+#else
+// AVR has too little RAM for the 768 bytes of tables, 16 entry nibble tables (two lookups per byte) instead
+#endif
+
+// Constant tables in flash (Crc nibble tables)
+#if defined(ARDUINO_ARCH_AVR)
+// AVR copies plain const data into SRAM at startup, PROGMEM tables stay in flash and are read with the pgm_read functions
+#include <avr/pgmspace.h>
+#define RC_PROGMEM PROGMEM
+#define rc_read_byte(address) pgm_read_byte(address)
+#define rc_read_word(address) pgm_read_word(address)
+#else
+// ESP32 & Native read const data directly
+#define RC_PROGMEM
+#define rc_read_byte(address) (*(address))
+#define rc_read_word(address) (*(address))
+#endif
+
+// Atomic implementation (state shared between an interrupt/thread and the main loop)
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_NATIVE)
+// ESP32 (dual core) & Native (threads) need real atomics
+#include <atomic>
+#define RC_ARCH_USE_ATOMIC
+#define rc_atomic(T) std::atomic<T>
+#else
+// AVR is single core and an interrupt runs to completion, volatile 8-bit variables are sufficient
+#define rc_atomic(T) volatile T
+#endif
+
+// Placement new implementation (MultiPeerRemoteController constructs one RemoteController per peer in place)
+#if defined(ARDUINO_ARCH_AVR)
+#include <new.h> // Arduino AVR core 1.8.3 and newer
+#else
+#include <new>
+#endif
+
+// Thread implementation (RemoteController::startPump())
+#if defined(RC_ARCH_USE_FUNCTIONAL) && defined(RC_ARCH_USE_ATOMIC)
+// ESP32 (FreeRTOS tasks behind std::thread) & Native run the pump in a std::thread
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#define RC_ARCH_USE_THREADS
+#else
+// AVR has no threads, RemoteController::run() is called from the loop
+#endif
+
 #endif
\ No newline at end of file
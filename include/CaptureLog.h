@@ -0,0 +1,90 @@
+#ifndef REMOTECONTROLLER_CAPTURELOG_H_
+#define REMOTECONTROLLER_CAPTURELOG_H_
+
+#include "ArchConfig.h"
+
+/**
+ * @brief Binary log format of CaptureConnection and ReplayConnection. The log is a sequence of records, new records are only appended:
+ *
+ * | Bytes | Content                                                                                        |
+ * |-------|------------------------------------------------------------------------------------------------|
+ * | 1     | type: CaptureLog::RecordKind (bits 0-1), CaptureLog::Failed (bit 6), CaptureLog::HasPeer (bit 7)|
+ * | 1-5   | microseconds since the previous record (unsigned LEB128 varint)                                |
+ * | 1-5   | payload length (unsigned LEB128 varint)                                                        |
+ * | 0-1   | peer id, only with CaptureLog::HasPeer                                                         |
+ * | n     | payload: the packet, or the session description of a CaptureLog::Session record              |
+ *
+ * Every CaptureConnection::begin() starts a session record: "RCLG", CaptureLog::Version, the Connection::Capability flags, the peer count and the maximum package size (2 bytes, little endian). A command packet with 6 commands (32 bytes) takes 35 to 37 bytes in the log.
+ *
+ */
+class CaptureLog
+{
+public:
+	enum RecordKind : uint8_t
+	{
+		Session = 0 /** CaptureConnection::begin() */,
+		Read = 1 /** Packet read from the Connection */,
+		Write = 2 /** Packet written with Connection::write(), Connection::writeBatch() or Connection::startWrite() */,
+		AckPayload = 3 /** Packet queued with Connection::writeAckPayload() */
+	};
+
+	enum Format : uint8_t
+	{
+		Version = 1,
+		KindMask = 0x03,
+		Failed = 0x40 /** The write failed */,
+		HasPeer = 0x80 /** A peer id follows the length (Connection::MultiPeer, peers other than 0) */,
+		SessionSize = 9 /** Payload of a CaptureLog::Session record */,
+		MaxRecordHeaderSize = 12 /** Type, two varints and the peer id */
+	};
+
+	/**
+	 * @brief A record decoded with CaptureLog::decodeRecord(), the payload points into the log
+	 *
+	 */
+	struct Record
+	{
+		RecordKind kind;
+		bool failed;
+		uint8_t peer;
+		uint32_t deltaMicros;
+		const uint8_t *payload;
+		size_t length;
+	};
+
+	/**
+	 * @brief Encodes everything of a record but its payload
+	 *
+	 * @param output room for CaptureLog::MaxRecordHeaderSize bytes
+	 * @return size_t bytes written to output
+	 */
+	static size_t encodeRecordHeader(uint8_t *output, RecordKind kind, bool failed, uint8_t peer, uint32_t deltaMicros, size_t length);
+
+	/**
+	 * @brief Encodes the payload of a CaptureLog::Session record
+	 *
+	 * @param output room for CaptureLog::SessionSize bytes
+	 */
+	static void encodeSession(uint8_t *output, uint8_t capabilities, uint8_t peerCount, size_t maxPackageSize);
+
+	/**
+	 * @brief Decodes the record at position and moves position to the next record
+	 *
+	 * @return true a complete record was decoded
+	 * @return false the log ends (or is cut off) at position
+	 */
+	static bool decodeRecord(const uint8_t *log, size_t length, size_t &position, Record &record);
+
+	/**
+	 * @brief Checks the payload of a CaptureLog::Session record and decodes it
+	 *
+	 * @return true the session was written by a CaptureConnection of this version
+	 */
+	static bool decodeSession(const Record &record, uint8_t &capabilities, uint8_t &peerCount, size_t &maxPackageSize);
+
+private:
+	static size_t encodeVarint(uint8_t *output, uint32_t value);
+	static bool decodeVarint(const uint8_t *log, size_t length, size_t &position, uint32_t &value);
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef CAPTURECONNECTION_H_
+#define CAPTURECONNECTION_H_
+
+#include "ArchConfig.h"
+#include "Connection.h"
+#include "../CaptureLog.h"
+
+/**
+ * @brief Records the traffic of any Connection: every packet that is read, written or queued as ack payload is appended to a binary log (see CaptureLog) with the time since the previous record. ReplayConnection feeds a log back into a RemoteController to reproduce a field issue.
+ *
+ * @code
+ * RF24Connection radio(CE_PIN, CSN_PIN);
+ * File log = SD.open("rc.log", FILE_WRITE); // Any Stream: a file, a second UART, ...
+ * CaptureConnection connection(radio, log);
+ * RemoteController rc(connection);
+ * @endcode
+ * @note The log is written from within RemoteController::run(), a slow Stream slows it down. On native the Stream is a NativeStream, e.g. an FdStream on a file opened with O_APPEND.
+ *
+ */
+class CaptureConnection : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Forwarded to the wrapped Connection, the packets are logged
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+	size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count);
+	bool writeAckPayload(const void *buffer, size_t length);
+	bool startWrite(const void *buffer, size_t length);
+	WriteStatus pollWrite();
+	uint8_t getPeerCount();
+	bool setWritePeer(uint8_t peer);
+	uint8_t getReadPeer();
+
+	/**@}*/
+	/**
+	 * @name CaptureConnection Specific Functions
+	 *
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct a new CaptureConnection
+	 *
+	 * @param connection the Connection to record, it reports the same capabilities (set them, e.g. RF24Connection::setAsyncWrites(), before constructing the CaptureConnection)
+	 * @param log where the records are appended to
+	 */
+	CaptureConnection(Connection &connection, _Stream &log);
+
+	uint32_t recordsWritten = 0; // Records appended to the log
+	uint32_t logErrors = 0;		 // Records the Stream did not take completely, the log is broken from there on
+
+	/**@}*/
+private:
+	Connection &connection;
+	_Stream &log;
+	uint32_t lastMicros = 0; // Time of the previous record
+	uint8_t writePeer = 0;
+	const void *pendingBuffer = nullptr; // Packet of the write started with CaptureConnection::startWrite(), logged once its result is known
+	size_t pendingLength = 0;
+
+	void record(CaptureLog::RecordKind kind, bool failed, uint8_t peer, const void *payload, size_t length);
+};
+
+#endif
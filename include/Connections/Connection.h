@@ -1,6 +1,7 @@
 #ifndef REMOTECONTROLLERCONNECTION_H_
 #define REMOTECONTROLLERCONNECTION_H_
 #include <stddef.h>
+#include <stdint.h>
 
 /**
  * @brief This abstract class interfaces between the RemoteController and any way of transmitting the data for the RemoteController. E.g. WiFi and RF24.
@@ -9,6 +10,41 @@
 class Connection
 {
 public:
+	/**
+	 * @brief Optional features a Connection implementation supports on top of the required methods. The RemoteController only uses a feature if the Connection reports it with Connection::hasCapability().
+	 *
+	 */
+	enum Capability : uint8_t
+	{
+		BatchWrite = 1 << 0 /** Connection::writeBatch() transmits multiple packets faster than single Connection::write() calls */,
+		AckPayload = 1 << 1 /** Connection::writeAckPayload() attaches packets to the acknowledgement of the next received packet */,
+		AsyncWrite = 1 << 2 /** Connection::startWrite() returns before the packet is transmitted, the result is polled with Connection::pollWrite() */,
+		MultiPeer = 1 << 3 /** The Connection talks to several peers: Connection::setWritePeer() selects the destination of the following writes and Connection::getReadPeer() tells the sender of the available packet */
+	};
+
+	/**
+	 * @brief State of the write started with Connection::startWrite()
+	 *
+	 */
+	enum WriteStatus : uint8_t
+	{
+		WriteIdle /** No write was started */,
+		WritePending /** The packet is still being transmitted */,
+		WriteSucceeded /** Succesfull transmission (ack received) */,
+		WriteFailed /** Failed to transmit */
+	};
+
+	/**
+	 * @brief Check if the Connection supports an optional feature
+	 *
+	 * @param capability the feature, see Connection::Capability
+	 * @return true if the feature is supported
+	 */
+	bool hasCapability(Capability capability) const
+	{
+		return capabilities & capability;
+	}
+
 	/**
 	 * @brief Connects to and configures any modules needed by the Connection to transceive/receive
 	 *
@@ -61,6 +97,100 @@ public:
 	 * 
 	 */
 	virtual size_t getMaxPackageSize() = 0;
+
+	/**
+	 * @brief Writes multiple packets back to back to the other RemoteController. Only used if the Connection reports Capability::BatchWrite, the default implementation calls Connection::write() for every packet.
+	 *
+	 * @param buffers the packets to transmit
+	 * @param lengths length/size of each packet
+	 * @param count number of packets
+	 * @return size_t number of packets that were transmitted succesfully (ack received), counted from the first packet. Packets after a failed packet are not transmitted.
+	 */
+	virtual size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!write(buffers[i], lengths[i]))
+				return i;
+		}
+		return count;
+	}
+
+	/**
+	 * @brief Queues a packet that is sent back to the other RemoteController with the acknowledgement of the next packet received from it (e.g. NRF24L01 ack payloads). The other end receives it like any other packet via Connection::available() and Connection::read(). Only used if the Connection reports Capability::AckPayload.
+	 *
+	 * @param buffer where the data to transmit is stored
+	 * @param length length/size of the payload/buffer
+	 * @return true the packet was queued and is sent with the next acknowledgement
+	 * @return false failed to queue the packet (e.g. the ack payload queue is full)
+	 */
+	virtual bool writeAckPayload(const void *buffer, size_t length)
+	{
+		(void)buffer;
+		(void)length;
+		return false;
+	}
+
+	/**
+	 * @brief Starts writing a packet to the other RemoteController without waiting for the transmission (or the ack). Only used if the Connection reports Capability::AsyncWrite, the default implementation is an adapter for blocking connections: it calls Connection::write() and the result is ready right away.
+	 * @warning The buffer is not copied, it has to stay valid until Connection::pollWrite() no longer returns WriteStatus::WritePending. Only one write can be pending at a time.
+	 *
+	 * @param buffer where the data to transmit is stored
+	 * @param length length/size of the payload/buffer
+	 * @return true the write was started, poll the result with Connection::pollWrite()
+	 * @return false failed to start the write (e.g. the packet is too big)
+	 */
+	virtual bool startWrite(const void *buffer, size_t length)
+	{
+		writeStatus = write(buffer, length) ? WriteSucceeded : WriteFailed;
+		return true;
+	}
+
+	/**
+	 * @brief Checks the write started with Connection::startWrite(), must not block.
+	 *
+	 * @return WriteStatus WriteStatus::WritePending until the transmission finished, then the result (until the next Connection::startWrite() call)
+	 */
+	virtual WriteStatus pollWrite()
+	{
+		return writeStatus;
+	}
+
+	/**
+	 * @brief Number of peers the Connection can talk to. Only used if the Connection reports Capability::MultiPeer.
+	 *
+	 * @return uint8_t peers, the peer ids are 0 to getPeerCount() - 1
+	 */
+	virtual uint8_t getPeerCount()
+	{
+		return 1;
+	}
+
+	/**
+	 * @brief Selects the peer the following Connection::write(), Connection::writeBatch(), Connection::writeAckPayload() and Connection::startWrite() calls go to. Only used if the Connection reports Capability::MultiPeer.
+	 *
+	 * @param peer id of the peer
+	 * @return true the peer is selected
+	 * @return false unknown peer or the peer cannot be changed right now (e.g. a write is pending)
+	 */
+	virtual bool setWritePeer(uint8_t peer)
+	{
+		return peer == 0;
+	}
+
+	/**
+	 * @brief Tells which peer sent the packet that is read with the next Connection::read() call, only valid while Connection::available() returns true. Only used if the Connection reports Capability::MultiPeer.
+	 *
+	 * @return uint8_t id of the peer
+	 */
+	virtual uint8_t getReadPeer()
+	{
+		return 0;
+	}
+
+protected:
+	uint8_t capabilities = 0; // Connection::Capability flags, set by the implementation
+	WriteStatus writeStatus = WriteIdle; // Result of the last Connection::startWrite()
 };
 
 #endif
\ No newline at end of file
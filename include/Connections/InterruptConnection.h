@@ -0,0 +1,98 @@
+#ifndef INTERRUPTCONNECTION_H_
+#define INTERRUPTCONNECTION_H_
+
+#include "Connection.h"
+#include "../PacketRing.h"
+
+/**
+ * @brief Interrupt driven receive for any Connection. InterruptConnection::handleInterrupt() (called from the radio IRQ pin or a background thread) moves the received packets of the wrapped Connection into a lock-free ring buffer, RemoteController::run() then only drains the ring and never misses packets while the main loop is busy.
+ *
+ * @code
+ * RF24Connection radio(CE_PIN, CSN_PIN);
+ * InterruptConnection connection(radio);
+ * RemoteController rc(connection);
+ *
+ * void setup() {
+ *     rc.begin(commandsReceivedCallback);
+ *     attachInterrupt(digitalPinToInterrupt(IRQ_PIN), [] { connection.handleInterrupt(); }, FALLING);
+ * }
+ * @endcode
+ * @note The wrapped Connection is only accessed by one side at a time: while the main loop writes, an interrupt only flags the pending packets and InterruptConnection::handleInterrupt() is run again once the write finished.
+ * @note On ESP32 the wrapped Connection (SPI) should not be accessed from an ISR, call InterruptConnection::handleInterrupt() from a task that is woken up by the ISR instead.
+ * @note The ring slots hold REMOTECONTROLLER_INCOMING_BUFFER_SIZE bytes, InterruptConnection::getMaxPackageSize() reports at most that. The other end has to send packets of that size as well (e.g. by wrapping its Connection too), longer packets are cut.
+ *
+ */
+class InterruptConnection : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Receive from the ring buffer, everything else is forwarded to the wrapped Connection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+	size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count);
+	bool writeAckPayload(const void *buffer, size_t length);
+	bool startWrite(const void *buffer, size_t length);
+	WriteStatus pollWrite();
+
+	/**@}*/
+	/**
+	 * @name InterruptConnection Specific Functions
+	 *
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct a new InterruptConnection
+	 *
+	 * @param connection the Connection that receives the packets, it reports the same capabilities (set them, e.g. RF24Connection::setAsyncWrites(), before constructing the InterruptConnection)
+	 */
+	InterruptConnection(Connection &connection);
+
+	/**
+	 * @brief Reads all available packets of the wrapped Connection into the ring buffer. ISR safe, call it from the radio IRQ or a background thread (the only producer).
+	 *
+	 */
+	void handleInterrupt();
+
+	/**
+	 * @brief Highest number of packets that were waiting in the ring buffer at once
+	 *
+	 */
+	uint8_t getHighWatermark() const;
+
+	/**
+	 * @brief Number of packets dropped because the ring buffer was full
+	 *
+	 */
+	uint32_t getOverflowDrops() const;
+
+	/**
+	 * @brief Resets the high-watermark and the overflow drop counter
+	 *
+	 */
+	void resetStatistics();
+
+	/**@}*/
+private:
+	Connection &connection;
+	PacketRing ring;
+	rc_atomic(bool) busy{false};	// The wrapped Connection is in use
+	rc_atomic(bool) pending{false}; // An interrupt occured while the wrapped Connection was in use
+
+	bool tryLock();
+	void lock();
+	void unlock();
+};
+
+#endif
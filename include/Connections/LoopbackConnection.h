@@ -0,0 +1,141 @@
+#ifndef LOOPBACKCONNECTION_H_
+#define LOOPBACKCONNECTION_H_
+
+#include "Connection.h"
+#include <stdint.h>
+
+#ifndef REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH
+#define REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH 8 // packets that can wait in the receive queue of one LoopbackConnection
+#endif
+#ifndef REMOTECONTROLLER_LOOPBACK_PACKET_SIZE
+#define REMOTECONTROLLER_LOOPBACK_PACKET_SIZE 32 // bytes, upper bound for LoopbackConnection::setMaxPackageSize()
+#endif
+#ifndef REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH
+#define REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH 3 // ack payloads that can wait for the next received packet (like the NRF24L01 TX FIFO)
+#endif
+#ifndef REMOTECONTROLLER_LOOPBACK_PEERS
+#define REMOTECONTROLLER_LOOPBACK_PEERS 8 // peers one LoopbackConnection can be connected to with LoopbackConnection::addPeer()
+#endif
+
+/**
+ * @brief An in-memory Connection Implementation. Two LoopbackConnection objects are paired and every Connection::write() on one end is queued for reception on the other end.
+ *
+ * Useful to run two RemoteControllers in one process (e.g. native tests and benchmarks) without any radio hardware. Reports Connection::BatchWrite (using the default Connection::writeBatch()) and Connection::AckPayload so the batched transmit and ack payload paths are exercised as well.
+ *
+ * With LoopbackConnection::addPeer() one LoopbackConnection (e.g. a base station) is connected to several others and reports Connection::MultiPeer, like a radio with one reading pipe per remote.
+ *
+ */
+class LoopbackConnection : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Loopback implementation of the required methods to conform to @ref Connection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+	bool writeAckPayload(const void *buffer, size_t length);
+	uint8_t getPeerCount();
+	bool setWritePeer(uint8_t peer);
+	uint8_t getReadPeer();
+
+	/**@}*/
+	/**
+	 * @name LoopbackConnection Specific Functions
+	 *
+	 * Pairing, settings and traffic counters
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct an unpaired LoopbackConnection, pair it later with LoopbackConnection::pair()
+	 *
+	 */
+	LoopbackConnection();
+
+	/**
+	 * @brief Construct a LoopbackConnection and pair it with peer
+	 *
+	 * @param peer the other end of the loopback, writes on one end are received on the other end
+	 */
+	LoopbackConnection(LoopbackConnection &peer);
+
+	/**
+	 * @brief Pair this LoopbackConnection with peer (in both directions)
+	 *
+	 */
+	void pair(LoopbackConnection &peer);
+
+	/**
+	 * @brief Connect one more peer to this LoopbackConnection. The peer is paired with this end only, so a LoopbackConnection with several peers is the star point (base station) and every peer a single remote.
+	 *
+	 * @param peer the remote end, its writes are received here with LoopbackConnection::getReadPeer() returning the returned id
+	 * @return int id of the peer (the first peer, also the one of LoopbackConnection::pair(), is 0) or -1 if REMOTECONTROLLER_LOOPBACK_PEERS are connected already
+	 */
+	int addPeer(LoopbackConnection &peer);
+
+	/**
+	 * @brief Set the maximum package size reported by LoopbackConnection::getMaxPackageSize()
+	 *
+	 * @param size package size in bytes, capped to REMOTECONTROLLER_LOOPBACK_PACKET_SIZE
+	 */
+	void setMaxPackageSize(size_t size);
+
+	/**
+	 * @brief Number of packets queued for reception on this end
+	 *
+	 */
+	size_t queuedPackets() const;
+
+	/**
+	 * @brief Number of ack payloads waiting for the next packet from the peer
+	 *
+	 */
+	size_t queuedAckPayloads() const;
+
+	/**
+	 * @brief Resets the traffic counters
+	 *
+	 */
+	void resetCounters();
+
+	uint32_t packetsWritten = 0; // Packets succesfully written to the peer
+	uint32_t bytesWritten = 0;	 // Bytes succesfully written to the peer ("on the air")
+	uint32_t writeFailures = 0;	 // Writes that failed because the peer was not ready or its queue was full
+
+	/**@}*/
+private:
+	LoopbackConnection *peers[REMOTECONTROLLER_LOOPBACK_PEERS] = {};
+	uint8_t peerCount = 0;
+	uint8_t writePeer = 0; // LoopbackConnection::setWritePeer()
+	bool isBegun = false;
+	size_t maxPackageSize = REMOTECONTROLLER_LOOPBACK_PACKET_SIZE;
+
+	// Receive queue (ring buffer) filled by the peer
+	uint8_t packets[REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH][REMOTECONTROLLER_LOOPBACK_PACKET_SIZE];
+	size_t packetLengths[REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH];
+	const LoopbackConnection *packetSources[REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH]; // Writer of each packet
+	size_t head = 0;  // Index of the oldest queued packet
+	size_t count = 0; // Number of queued packets
+
+	// Ack payloads (ring buffer) sent to the peer with the acknowledgement of the next packet received from it
+	uint8_t ackPayloads[REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH][REMOTECONTROLLER_LOOPBACK_PACKET_SIZE];
+	size_t ackPayloadLengths[REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH];
+	LoopbackConnection *ackPayloadTargets[REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH]; // Peer selected when the ack payload was queued
+	size_t ackHead = 0;
+	size_t ackCount = 0;
+
+	bool enqueue(const LoopbackConnection *source, const void *buffer, size_t length);
+	void sendAckPayload(LoopbackConnection *writer);
+};
+
+#endif
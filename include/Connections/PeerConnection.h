@@ -0,0 +1,110 @@
+#ifndef PEERCONNECTION_H_
+#define PEERCONNECTION_H_
+
+#include "Connection.h"
+
+/**
+ * @brief Shares one Connection with Connection::MultiPeer between several PeerConnections, one per peer. The packets of the Connection are handed out one at a time: the oldest packet waits in a staging buffer until the PeerConnection of its sender reads it.
+ *
+ * Used by MultiPeerRemoteController, which owns the staging buffer and runs the RemoteControllers of all peers in turn, so a staged packet never waits longer than one MultiPeerRemoteController::run() call.
+ *
+ */
+class PeerMux
+{
+public:
+	/**
+	 * @brief Construct a new PeerMux
+	 *
+	 * @param connection the shared Connection, it has to report Connection::MultiPeer unless there is only one peer
+	 * @param stagingBuffer buffer for the oldest received packet, as large as the largest packet
+	 * @param stagingBufferSize size of stagingBuffer in bytes
+	 * @param peers number of peers, packets from peers with a higher id are dropped
+	 */
+	PeerMux(Connection &connection, uint8_t *stagingBuffer, size_t stagingBufferSize, uint8_t peers);
+
+	bool begin();
+	void end();
+	bool isBegun() const;
+	bool available(uint8_t peer);
+	void read(uint8_t peer, void *buffer, size_t length);
+	size_t getPayloadSize(uint8_t peer);
+
+	/**
+	 * @brief Selects the peer of the following writes on the shared Connection
+	 *
+	 */
+	bool select(uint8_t peer);
+
+	/**
+	 * @brief Number of packets dropped because they came from a peer without a PeerConnection
+	 *
+	 */
+	uint32_t getUnknownPeerDrops() const;
+
+	Connection &connection;
+
+private:
+	uint8_t *const stagingBuffer;
+	const size_t stagingBufferSize;
+	const uint8_t peers;
+	bool begun = false;
+	bool staged = false; // stagingBuffer holds a packet of stagedPeer
+	uint8_t stagedPeer = 0;
+	size_t stagedLength = 0;
+	uint32_t unknownPeerDrops = 0;
+
+	bool stage();
+};
+
+/**
+ * @brief The Connection of one peer of a PeerMux: receives only the packets of the peer and writes only to the peer. Reports the Connection::BatchWrite and Connection::AckPayload capabilities of the shared Connection, but not Connection::AsyncWrite (the radio has only one write in flight, for all peers).
+ * @note final, so a RemoteControllerT bound to PeerConnection calls it without the vtable.
+ *
+ */
+class PeerConnection final : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Forwarded to the PeerMux, with the peer of this PeerConnection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+	size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count);
+	bool writeAckPayload(const void *buffer, size_t length);
+
+	/**@}*/
+
+	/**
+	 * @brief Construct a PeerConnection that is not attached yet, see PeerConnection::attach()
+	 *
+	 */
+	PeerConnection() {}
+
+	/**
+	 * @brief Bind the PeerConnection to a peer of mux, before PeerConnection::begin()
+	 *
+	 */
+	void attach(PeerMux &mux, uint8_t peer);
+
+	/**
+	 * @brief The id of the peer on the shared Connection
+	 *
+	 */
+	uint8_t getPeer() const;
+
+private:
+	PeerMux *mux = nullptr;
+	uint8_t peer = 0;
+};
+
+#endif
@@ -5,12 +5,15 @@
 #include <RF24.h>
 
 #define REMOTECONTROLLER_RF24CONNECTION_DEFAULT_ADDRESS "RF000"
+#define REMOTECONTROLLER_RF24CONNECTION_TX_FIFO_SIZE 3 // packets
+#define REMOTECONTROLLER_RF24CONNECTION_MAX_PEERS 5 // reading pipes 1-5, pipe 0 receives the acks of the own writes
 
 /**
  * @brief A Connection Implementation for the common NRF24L01 modules uses the nrf24/RF24 library internally!
+ * @note final, so a RemoteControllerT bound to RF24Connection calls it without the vtable.
  * 
  */
-class RF24Connection : public Connection
+class RF24Connection final : public Connection
 {
 public:
 	/**
@@ -27,7 +30,47 @@ public:
 	void read(void *buffer, size_t length);
 	size_t getPayloadSize();
 	bool write(const void *buffer, size_t length);
-	size_t getMaxPackageSize();
+	size_t getMaxPackageSize() { return maxPackageSize; }
+
+	/**
+	 * @brief Switches to TX mode once for the whole batch, fills the 3 packet TX FIFO with writeFast() and waits with txStandBy() before returning to RX mode.
+	 * @note If the retry limit is reached while the TX FIFO is emptied, the radio cannot tell which of the last (up to 3) packets were acked. Those are reported as not transmitted, so they are sent again (at least once delivery).
+	 *
+	 */
+	size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count);
+
+	/**
+	 * @brief Loads the packet as ack payload for the reading pipe of the selected peer (RF24Connection::setWritePeer()), the NRF24L01 holds up to 3 ack payloads. Only used after RF24Connection::setAckPayloads(true). Ack payloads are lost when RF24Connection::write() or RF24Connection::writeBatch() is called (the RF24 library flushes the TX FIFO when switching to TX mode).
+	 *
+	 */
+	bool writeAckPayload(const void *buffer, size_t length);
+
+	/**
+	 * @brief Switches to TX mode and loads the packet with startFastWrite(), the NRF24L01 handles the auto-ack and the retries on its own. Only used after RF24Connection::setAsyncWrites(true).
+	 *
+	 */
+	bool startWrite(const void *buffer, size_t length);
+
+	/**
+	 * @brief Reads (and clears) the TX_DS and MAX_RT flags of the NRF24L01 with whatHappened() and returns to RX mode once the packet was acked or the retry limit was reached.
+	 * @warning whatHappened() also clears the RX_DR flag, do not combine with code that relies on the IRQ pin for received packets.
+	 *
+	 */
+	WriteStatus pollWrite();
+
+	uint8_t getPeerCount() { return peerCount; }
+
+	/**
+	 * @brief Points the writing pipe to the address of the peer (only touches the radio if the peer changes). Fails while an asynchronous write is pending.
+	 *
+	 */
+	bool setWritePeer(uint8_t peer);
+
+	/**
+	 * @brief The peer is the reading pipe the available packet arrived on (pipe 1 = peer 0). Ack payloads arrive on pipe 0 and belong to the peer of the last RF24Connection::setWritePeer().
+	 *
+	 */
+	uint8_t getReadPeer();
 	
 	/**@}*/
 	/**
@@ -70,6 +113,32 @@ public:
 	 */
 	void useSpecificSPIBus(_SPI *spiBus);
 
+	/**
+	 * @brief Report Connection::AsyncWrite (Default: false): RemoteController::run() starts a packet and checks the result with the next run() calls instead of waiting up to the whole auto retransmit time (15 retries with a 1.5ms delay by default) for the ack.
+	 *
+	 * @param enable true to write asynchronously
+	 */
+	void setAsyncWrites(bool enable);
+
+	/**
+	 * @brief Enable the ack payloads of the NRF24L01 and report Connection::AckPayload (Default: false), see RemoteController::setUseAckPayloads(). Ack payloads change how the radio uses its RX and TX FIFOs, so they are off unless they are needed.
+	 * @warning Call before RF24Connection::begin() on both ends: the RemoteController that receives the ack payloads needs them enabled as well.
+	 *
+	 * @param enable true to enable ack payloads
+	 */
+	void setAckPayloads(bool enable);
+
+	/**
+	 * @brief Listen to one more remote on its own reading pipe, e.g. a base station controlling a fleet (see MultiPeerRemoteController). The address passed to the constructor is peer 0, every remote uses its own address as the only (default) address.
+	 *
+	 * @warning Call before RF24Connection::begin()
+	 * @note The NRF24L01 compares only the first byte (the least significant byte) of the addresses of pipes 2-5, the other 4 bytes are the ones of pipe 1. So the addresses of all peers have to share the last 4 bytes, e.g. "1Node", "2Node", "3Node".
+	 *
+	 * @param address the 5 byte address of the remote
+	 * @return int id of the peer or -1 if all REMOTECONTROLLER_RF24CONNECTION_MAX_PEERS reading pipes are in use
+	 */
+	int addPeer(const uint8_t *address);
+
 	/**
 	 * @brief The NRF24L01 module supports packages of size 4 bytes to 32 bytes.
 	 * 
@@ -81,7 +150,9 @@ private:
 	RF24 rf24;
 	_SPI *nonDefaultSPI = nullptr;
 	bool isRF24Initialized = false; // To not call rf24.begin if true
-	uint8_t rf24_address[5];
+	uint8_t rf24_addresses[REMOTECONTROLLER_RF24CONNECTION_MAX_PEERS][5]; // Address of peer n, received on reading pipe n + 1
+	uint8_t peerCount = 1;
+	uint8_t writePeer = 0;
 };
 
 #endif
\ No newline at end of file
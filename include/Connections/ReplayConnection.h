@@ -0,0 +1,99 @@
+#ifndef REPLAYCONNECTION_H_
+#define REPLAYCONNECTION_H_
+
+#include "ArchConfig.h"
+#include "Connection.h"
+#include "../CaptureLog.h"
+
+/**
+ * @brief Feeds a log recorded by CaptureConnection back into a RemoteController. The recorded packets are read again and the writes of the RemoteController get the recorded results, so the RemoteController takes the same decisions (retransmissions, fragment acknowledgements, ...) as in the field.
+ *
+ * @code
+ * ReplayConnection connection(log, logLength); // The log in memory
+ * RemoteController rc(connection);
+ * rc.begin(commandsReceivedCallback);
+ * while (!connection.finished()) {
+ *     rc.run();
+ * }
+ * @endcode
+ *
+ * At maximum speed (the default) every recorded packet is available right away, the replay only costs the decoding in RemoteController::run(): the benchmark bench_replay uses this to measure the receive path with a recorded traffic mix. With ReplayConnection::setOriginalSpeed() a packet is available once as much time (rcmicros()) passed since ReplayConnection::begin() as when it was recorded.
+ *
+ * The ReplayConnection reports the capabilities, the peer count and the maximum package size of the recorded Connection. The packets recorded after a write are only available once the RemoteController made the write, so every run() call reads the same packets as the recorded one. Writes that differ from the recorded ones (or are not made) are counted in ReplayConnection::writeMismatches, a replay of the same log with the same settings gives the same result every time.
+ *
+ */
+class ReplayConnection : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Replay implementation of the required methods to conform to @ref Connection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+	bool writeAckPayload(const void *buffer, size_t length);
+	uint8_t getPeerCount();
+	bool setWritePeer(uint8_t peer);
+	uint8_t getReadPeer();
+
+	/**@}*/
+	/**
+	 * @name ReplayConnection Specific Functions
+	 *
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct a new ReplayConnection
+	 *
+	 * @param log the records of a CaptureConnection, has to stay valid while the ReplayConnection is used
+	 * @param length size of the log in bytes
+	 */
+	ReplayConnection(const uint8_t *log, size_t length);
+
+	/**
+	 * @brief Replay at the recorded speed instead of as fast as possible. Call before ReplayConnection::begin().
+	 *
+	 */
+	void setOriginalSpeed(bool enable);
+
+	/**
+	 * @brief All recorded packets were read
+	 *
+	 */
+	bool finished();
+
+	uint32_t packetsReplayed = 0; // Recorded packets that were read
+	uint32_t writeMismatches = 0; // Writes that differ from the recorded write at the same position (or came after the last recorded write)
+
+	/**@}*/
+private:
+	const uint8_t *log;
+	size_t logLength;
+	bool originalSpeed = false;
+	size_t maxPackageSize = 0;
+	uint8_t peerCount = 1;
+	uint8_t writePeer = 0;
+	uint32_t startMicros = 0;
+
+	// Reads and writes are replayed with separate cursors through the log
+	size_t readPosition = 0;
+	uint32_t readMicros = 0; // Recorded time (since the start of the log) of the record before readPosition
+	CaptureLog::Record nextRead;
+	bool readPending = false;	 // nextRead holds the next recorded packet
+	bool blockedOnWrite = false; // The last ReplayConnection::available() call waited for a recorded write, no write was made since
+	size_t writePosition = 0;
+
+	bool nextWrite(CaptureLog::RecordKind kind, const void *buffer, size_t length);
+};
+
+#endif
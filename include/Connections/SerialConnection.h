@@ -0,0 +1,103 @@
+#ifndef SERIALCONNECTION_H_
+#define SERIALCONNECTION_H_
+
+#include "ArchConfig.h"
+#include "Connection.h"
+
+#ifndef REMOTECONTROLLER_SERIAL_PACKET_SIZE
+#define REMOTECONTROLLER_SERIAL_PACKET_SIZE 128 // bytes, upper bound for SerialConnection::setMaxPackageSize() (the receive and the transmit buffer take about this much RAM each)
+#endif
+
+#define REMOTECONTROLLER_SERIAL_FRAME_SIZE (REMOTECONTROLLER_SERIAL_PACKET_SIZE + REMOTECONTROLLER_SERIAL_PACKET_SIZE / 254 + 2) // COBS encoded packet: one code byte per 254 bytes (at least one) and the delimiter
+
+/**
+ * @brief A Connection Implementation for wired links over any Arduino Stream (HardwareSerial, SoftwareSerial, USB CDC, ...), e.g. a tether at 1-2 Mbaud. Every packet is COBS encoded and terminated with a 0x00 byte, so the receiver finds the start of the next packet after any garbage or a lost byte.
+ *
+ * SerialConnection::available() parses the bytes the Stream received so far and never waits for the rest of a packet. Packets can be much larger than the 32 bytes of the NRF24L01 (SerialConnection::setMaxPackageSize()), size the RemoteController accordingly:
+ *
+ * @code
+ * SerialConnection connection(Serial1);
+ * RemoteControllerT<RemoteControllerPackageConfig<128>> rc(connection);
+ *
+ * void setup() {
+ *     Serial1.begin(2000000);
+ *     rc.setFrameCheck(RemoteController::Crc16); // A UART has no CRC
+ *     rc.begin(commandsReceivedCallback);
+ * }
+ * @endcode
+ * @note A write succeeds once the packet was handed to the Stream, there is no acknowledgement on a serial link. Use RemoteController::setFrameCheck() on both ends, COBS finds the packets but does not detect bit errors.
+ * @note On native the Stream is a NativeStream, FdStream::openPtyPair() connects two SerialConnections through a pseudo-terminal.
+ *
+ */
+class SerialConnection : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Serial implementation of the required methods to conform to @ref Connection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+
+	/**@}*/
+	/**
+	 * @name SerialConnection Specific Functions
+	 *
+	 * Settings and counters
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct a new SerialConnection
+	 *
+	 * @param stream the Stream to transmit over, it has to be started (e.g. Serial1.begin(baud)) before SerialConnection::begin()
+	 */
+	SerialConnection(_Stream &stream);
+
+	/**
+	 * @brief Set the maximum package size reported by SerialConnection::getMaxPackageSize(), received packets above it are dropped. Has to be the same on both ends.
+	 *
+	 * @param size package size in bytes, capped to REMOTECONTROLLER_SERIAL_PACKET_SIZE
+	 */
+	void setMaxPackageSize(size_t size);
+
+	/**
+	 * @brief COBS encodes length bytes, the encoded packet contains no 0x00 byte
+	 *
+	 * @param output room for at least length + length / 254 + 1 bytes
+	 * @return size_t size of the encoded packet (without the delimiter)
+	 */
+	static size_t encode(const uint8_t *input, size_t length, uint8_t *output);
+
+	uint32_t packetsReceived = 0; // Complete packets
+	uint32_t framingErrors = 0;	  // Frames that were dropped: malformed (e.g. a lost byte) or larger than the maximum package size
+
+	/**@}*/
+private:
+	_Stream &stream;
+	size_t maxPackageSize = REMOTECONTROLLER_SERIAL_PACKET_SIZE;
+	uint8_t txBuffer[REMOTECONTROLLER_SERIAL_FRAME_SIZE];
+
+	// Incremental COBS decoder, the packet is decoded into rxBuffer while its bytes arrive
+	uint8_t rxBuffer[REMOTECONTROLLER_SERIAL_PACKET_SIZE];
+	size_t rxLength = 0;
+	uint8_t rxRemaining = 0;	// Data bytes left in the current COBS block, 0 = the next byte is a code byte
+	bool rxZeroPending = false; // The current block ends with a (not encoded) 0x00 unless it is the last one
+	bool rxStarted = false;		// A code byte was received since the last delimiter
+	bool rxDiscarding = false;	// The frame is dropped, wait for the next delimiter
+	bool packetReady = false;	// rxBuffer holds a complete packet of rxLength bytes
+
+	void resetDecoder();
+	bool appendReceived(uint8_t byte);
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef SIMULATEDCONNECTION_H_
+#define SIMULATEDCONNECTION_H_
+
+#include "ArchConfig.h"
+
+#if defined(ARDUINO_ARCH_NATIVE)
+
+#include "Connection.h"
+#include <stdint.h>
+
+#ifndef REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH
+#define REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH 32 // packets that can be in flight towards one SimulatedConnection, further packets are dropped like on a full radio RX FIFO
+#endif
+#ifndef REMOTECONTROLLER_SIMULATED_PACKET_SIZE
+#define REMOTECONTROLLER_SIMULATED_PACKET_SIZE 32 // bytes, upper bound for SimulatedConnection::setMaxPackageSize()
+#endif
+
+/**
+ * @brief A deterministic lossy channel for native tests and benchmarks. Two SimulatedConnection objects are paired like LoopbackConnection, but every packet written on one end goes through a simulated channel (SimulatedConnection::Channel) before it can be read on the other end.
+ *
+ * The channel models packet loss, ack loss, latency, jitter, duplicate delivery and a bandwidth limit. Packets overtake each other when the jitter is larger than the time between them. A write succeeds like on a radio with auto-ack: only if the packet and its acknowledgement arrived. A lost ack therefore leads to a retransmission and a duplicate on the other end.
+ *
+ * With SimulatedConnection::setAsyncWrites() the connection reports Connection::AsyncWrite: SimulatedConnection::startWrite() returns right away and SimulatedConnection::pollWrite() reports the result once the airtime passed on the virtual clock.
+ *
+ * All randomness comes from a seeded xorshift generator and all times from a virtual clock (SimulatedConnection::advance()), so a test gives the same result on every run and does not wait for real time. With SimulatedConnection::useVirtualClock() rcmicros() (and therefore the RemoteController timeouts) runs on the same clock.
+ *
+ */
+class SimulatedConnection : public Connection
+{
+public:
+	/**
+	 * @brief Properties of one direction of the simulated channel
+	 *
+	 */
+	struct Channel
+	{
+		float loss = 0;				 // Probability (0.0-1.0) that a packet is lost, the write fails
+		float ackLoss = 0;			 // Probability that the acknowledgement of a delivered packet is lost, the write fails although the packet arrives
+		float duplicate = 0;		 // Probability that a delivered packet arrives twice
+		uint32_t latencyMicros = 0;	 // Time from the end of the transmission until the packet can be read
+		uint32_t jitterMicros = 0;	 // Random additional latency from 0 up to jitterMicros
+		uint32_t bytesPerSecond = 0; // Bandwidth, a write blocks (advances the virtual clock) for the airtime of the packet. 0 = unlimited
+	};
+
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * Simulated implementation of the required methods to conform to @ref Connection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+	bool startWrite(const void *buffer, size_t length);
+	WriteStatus pollWrite();
+
+	/**@}*/
+	/**
+	 * @name SimulatedConnection Specific Functions
+	 *
+	 * Pairing, channel settings, virtual clock and traffic counters
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct an unpaired SimulatedConnection, pair it later with SimulatedConnection::pair()
+	 *
+	 * @param seed seed of the random generator of the channel from this end to the peer
+	 */
+	SimulatedConnection(uint32_t seed = 1);
+
+	/**
+	 * @brief Construct a SimulatedConnection and pair it with peer
+	 *
+	 * @param peer the other end of the channel
+	 * @param seed seed of the random generator of the channel from this end to the peer
+	 */
+	SimulatedConnection(SimulatedConnection &peer, uint32_t seed = 2);
+
+	/**
+	 * @brief Pair this SimulatedConnection with peer (in both directions)
+	 *
+	 */
+	void pair(SimulatedConnection &peer);
+
+	/**
+	 * @brief Set the properties of the channel from this end to the peer
+	 *
+	 */
+	void setChannel(const Channel &channel);
+
+	/**
+	 * @brief Set the maximum package size reported by SimulatedConnection::getMaxPackageSize()
+	 *
+	 * @param size package size in bytes, capped to REMOTECONTROLLER_SIMULATED_PACKET_SIZE
+	 */
+	void setMaxPackageSize(size_t size);
+
+	/**
+	 * @brief Report Connection::AsyncWrite, so the RemoteController does not wait for the airtime of a packet (Default: false)
+	 *
+	 */
+	void setAsyncWrites(bool enable);
+
+	/**
+	 * @brief Number of packets on the way to this end, including the ones that can not be read yet
+	 *
+	 */
+	size_t queuedPackets() const;
+
+	/**
+	 * @brief Resets the traffic counters
+	 *
+	 */
+	void resetCounters();
+
+	/**
+	 * @brief The virtual clock shared by all SimulatedConnections
+	 *
+	 * @return uint32_t virtual time in microseconds, overflows like rcmicros()
+	 */
+	static uint32_t now();
+
+	/**
+	 * @brief Advance the virtual clock
+	 *
+	 * @param micros time in microseconds
+	 */
+	static void advance(uint32_t micros);
+
+	/**
+	 * @brief Let rcmicros() return the virtual clock instead of the steady clock, so the RemoteController timeouts run on simulated time
+	 *
+	 * @param enable false switches back to the steady clock (do this at the end of every test)
+	 */
+	static void useVirtualClock(bool enable);
+
+	uint32_t packetsWritten = 0;	// Writes, including the failed ones
+	uint32_t packetsLost = 0;		// Packets lost on the channel
+	uint32_t acksLost = 0;			// Packets that arrived but the write failed because the ack was lost
+	uint32_t packetsDuplicated = 0; // Packets that arrived twice
+	uint32_t packetsDropped = 0;	// Packets that arrived while the queue of the peer was full
+	uint32_t packetsRead = 0;		// Packets read on this end
+	uint32_t bytesRead = 0;			// Bytes read on this end
+
+	/**@}*/
+private:
+	SimulatedConnection *peer = nullptr;
+	Channel channel;
+	uint32_t randomState; // xorshift32 state
+	WriteStatus writeResult = WriteIdle; // Result of the write in flight, reported once writeDone passed
+	uint32_t writeDone = 0;
+	bool isBegun = false;
+	size_t maxPackageSize = REMOTECONTROLLER_SIMULATED_PACKET_SIZE;
+
+	// Packets on the way to this end, read in order of arrival
+	struct Packet
+	{
+		uint8_t data[REMOTECONTROLLER_SIMULATED_PACKET_SIZE];
+		size_t length;
+		uint32_t arrival;  // Virtual time from which on the packet can be read
+		uint32_t sequence; // Order of packets with the same arrival time
+		bool used;
+	};
+	Packet packets[REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH];
+	uint32_t sequence = 0;
+
+	static uint32_t clock;
+
+	float nextRandom();
+	uint32_t airtime(size_t length);
+	bool transmit(const void *buffer, size_t length, uint32_t sent); // sent: virtual time the transmission ended
+	bool deliver(const void *buffer, size_t length, uint32_t arrival);
+	Packet *nextPacket();
+};
+
+#endif
+
+#endif
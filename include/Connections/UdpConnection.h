@@ -0,0 +1,126 @@
+#ifndef UDPCONNECTION_H_
+#define UDPCONNECTION_H_
+
+#include "ArchConfig.h"
+
+#if defined(ARDUINO_ARCH_NATIVE) && (defined(__unix__) || defined(__APPLE__))
+
+#include "Connection.h"
+#include <stdint.h>
+#include <netinet/in.h>
+
+#ifndef REMOTECONTROLLER_UDP_PACKET_SIZE
+#define REMOTECONTROLLER_UDP_PACKET_SIZE 1472 // bytes, upper bound for UdpConnection::setMaxPackageSize(): an Ethernet MTU of 1500 bytes without the IPv4 and UDP headers
+#endif
+
+/**
+ * @brief A Connection Implementation over UDP sockets for the native environment, so a PC process can be the controller (or the vehicle) and two processes can run RemoteControllers against each other on one machine or in a LAN, e.g. for soak tests.
+ *
+ * Every packet is one datagram. The socket is non-blocking: UdpConnection::available() returns right away and UdpConnection::write() only waits while the kernel send buffer is full. Without UdpConnection::setRemote() the connection answers the sender of the last received datagram, so one end can be a server on a known port:
+ *
+ * @code
+ * UdpConnection vehicleConnection(5005);                  // Listens on port 5005, replies to whoever sent the last packet
+ * UdpConnection remoteConnection;                         // Any free port
+ * remoteConnection.setRemote("127.0.0.1", 5005);
+ * RemoteControllerT<RemoteControllerPackageConfig<512>> rc(remoteConnection);
+ *
+ * while (running) {
+ *     remoteConnection.waitForPacket(10); // Sleep instead of spinning
+ *     rc.run();
+ * }
+ * @endcode
+ * @note A write succeeds once the datagram was handed to the kernel, UDP has no acknowledgement: lost datagrams are not retransmitted. UDP has a checksum, RemoteController::setFrameCheck() is not needed.
+ *
+ */
+class UdpConnection : public Connection
+{
+public:
+	/**
+	 * @name Implementations of Connection Class Functions
+	 *
+	 * UDP implementation of the required methods to conform to @ref Connection
+	 *
+	 */
+	/**@{*/
+
+	bool begin();
+	void end();
+	bool available();
+	void read(void *buffer, size_t length);
+	size_t getPayloadSize();
+	bool write(const void *buffer, size_t length);
+	size_t getMaxPackageSize();
+
+	/**
+	 * @brief Sends all packets with one system call (sendmmsg()) where available
+	 *
+	 */
+	size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count);
+
+	/**@}*/
+	/**
+	 * @name UdpConnection Specific Functions
+	 *
+	 * Addresses, settings and counters
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Construct a new UdpConnection
+	 *
+	 * @param localPort the port UdpConnection::begin() binds to (all interfaces), 0 = any free port (see UdpConnection::getLocalPort())
+	 */
+	UdpConnection(uint16_t localPort = 0);
+	~UdpConnection();
+
+	/**
+	 * @brief Set the address packets are written to, only datagrams from this address are read
+	 *
+	 * @param host IPv4 address or host name, e.g. "127.0.0.1"
+	 * @param port UDP port of the other end
+	 * @return true the address was resolved
+	 */
+	bool setRemote(const char *host, uint16_t port);
+
+	/**
+	 * @brief The port the socket is bound to, only valid after UdpConnection::begin()
+	 *
+	 */
+	uint16_t getLocalPort() const;
+
+	/**
+	 * @brief Set the maximum package size reported by UdpConnection::getMaxPackageSize(), received datagrams above it are dropped. Has to be the same on both ends.
+	 *
+	 * @param size package size in bytes, capped to REMOTECONTROLLER_UDP_PACKET_SIZE
+	 */
+	void setMaxPackageSize(size_t size);
+
+	/**
+	 * @brief Waits until a datagram arrived, so a host-side loop does not spin on RemoteController::run()
+	 *
+	 * @param timeoutMillis longest wait in milliseconds
+	 * @return true a datagram can be read
+	 */
+	bool waitForPacket(int timeoutMillis);
+
+	uint32_t packetsReceived = 0;  // Datagrams handed to the RemoteController
+	uint32_t datagramsDropped = 0; // Received datagrams that were dropped: larger than the maximum package size or from another address than the remote
+
+	/**@}*/
+private:
+	uint16_t localPort;
+	int socketFd = -1;
+	sockaddr_in remote;
+	bool remoteFixed = false; // Set with UdpConnection::setRemote(), otherwise remote is the sender of the last datagram
+	bool remoteKnown = false;
+	size_t maxPackageSize = REMOTECONTROLLER_UDP_PACKET_SIZE;
+	uint8_t rxBuffer[REMOTECONTROLLER_UDP_PACKET_SIZE + 1]; // One extra byte to detect datagrams above the maximum size
+	size_t rxLength = 0;
+	bool packetReady = false;
+
+	bool waitWritable();
+};
+
+#endif
+
+#endif
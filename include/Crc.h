@@ -0,0 +1,26 @@
+#ifndef REMOTECONTROLLER_CRC_H_
+#define REMOTECONTROLLER_CRC_H_
+
+#include "ArchConfig.h"
+
+/**
+ * @brief Checksums of the RemoteController frame check (RemoteController::setFrameCheck()): CRC-8 (polynomial 0x07, init 0x00) and CRC-16/CCITT-FALSE (polynomial 0x1021, init 0xFFFF).
+ *
+ * Crc::crc8() and Crc::crc16() use the variant of the architecture: 256 entry tables (256 bytes for CRC-8, 512 bytes for CRC-16) on ESP32 and native, 16 entry nibble tables (16 and 32 bytes of flash, two lookups per byte) on AVR. The variants give the same results, the benchmark bench_crc compares their cost per packet.
+ *
+ */
+class Crc
+{
+public:
+	static uint8_t crc8(const uint8_t *data, size_t length);
+	static uint16_t crc16(const uint8_t *data, size_t length);
+
+#if defined(RC_ARCH_CRC_TABLE)
+	static uint8_t crc8ByteTable(const uint8_t *data, size_t length);
+	static uint16_t crc16ByteTable(const uint8_t *data, size_t length);
+#endif
+	static uint8_t crc8Nibbles(const uint8_t *data, size_t length);
+	static uint16_t crc16Nibbles(const uint8_t *data, size_t length);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef REMOTECONTROLLER_MPSCRING_H_
+#define REMOTECONTROLLER_MPSCRING_H_
+
+#include "ArchConfig.h"
+
+#if defined(RC_ARCH_USE_ATOMIC)
+
+/**
+ * @brief Lock-free bounded multi-producer/single-consumer queue (Dmitry Vyukov's bounded queue: every slot carries a sequence number that tells producers and the consumer whose turn it is). Any number of threads push with MpscRing::push(), one thread pops with MpscRing::pop().
+ * @note Values are copied in and out, T should be small and trivially copyable. A producer that is preempted between claiming and publishing a slot delays the consumer (not the other producers) until it continues.
+ *
+ * @tparam T type of the values
+ * @tparam Length number of slots, a power of two
+ */
+template <class T, size_t Length>
+class MpscRing
+{
+	static_assert(Length >= 2 && (Length & (Length - 1)) == 0, "The length of an MpscRing has to be a power of two");
+
+public:
+	MpscRing()
+	{
+		for (size_t i = 0; i < Length; i++)
+		{
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Append a value, callable from any number of threads at once
+	 *
+	 * @return true the value was queued
+	 * @return false the ring is full, the value counts as overflow drop
+	 */
+	bool push(const T &value)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		while (true)
+		{
+			Slot &slot = slots[position & (Length - 1)];
+			const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			const ptrdiff_t difference = (ptrdiff_t)(sequence - position);
+			if (difference == 0)
+			{
+				// The slot is free in this lap, claim it (a failed exchange reloads position)
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					slot.value = value;
+					slot.sequence.store(position + 1, std::memory_order_release); // Publishes the value
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer did not free the slot of the previous lap yet
+				drops.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				position = tail.load(std::memory_order_relaxed); // Another producer claimed the slot
+			}
+		}
+	}
+
+	/**
+	 * @brief Remove the oldest value, only called by the consumer thread
+	 *
+	 * @return true value holds the oldest value
+	 * @return false the ring is empty (or its oldest slot is claimed but not yet published)
+	 */
+	bool pop(T &value)
+	{
+		Slot &slot = slots[head & (Length - 1)];
+		if ((ptrdiff_t)(slot.sequence.load(std::memory_order_acquire) - (head + 1)) < 0)
+		{
+			return false;
+		}
+		value = slot.value;
+		slot.sequence.store(head + Length, std::memory_order_release); // Frees the slot for the next lap
+		head++;
+		return true;
+	}
+
+	/**
+	 * @brief Number of values dropped because the ring was full since the last call, resets the counter
+	 *
+	 */
+	uint32_t takeDrops()
+	{
+		return drops.exchange(0, std::memory_order_relaxed);
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence; // position + 1: published, position + Length: free for the next lap
+		T value;
+	};
+	Slot slots[Length];
+	std::atomic<size_t> tail{0}; // Next position to claim, shared by the producers
+	size_t head = 0;			 // Next position to pop, only used by the consumer
+	std::atomic<uint32_t> drops{0};
+};
+
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef MULTIPEERREMOTECONTROLLER_H_
+#define MULTIPEERREMOTECONTROLLER_H_
+
+#include "RemoteController.h"
+#include "Connections/PeerConnection.h"
+
+/**
+ * @brief One RemoteController serving several remotes over one Connection with Connection::MultiPeer (e.g. an RF24Connection with RF24Connection::addPeer()). Every peer has its own RemoteController (command queue, sequence numbers, large payload transfer, settings), the callbacks tell which peer the commands and payloads came from.
+ *
+ * @code
+ * RF24Connection radio(CE_PIN, CSN_PIN, (const uint8_t *)"0Node");
+ * MultiPeerRemoteController<3> rc(radio);
+ *
+ * void commandsReceived(uint8_t peer, const uint8_t commands[], const float throttles[], size_t length) { ... }
+ *
+ * void setup() {
+ *     radio.addPeer((const uint8_t *)"1Node");
+ *     radio.addPeer((const uint8_t *)"2Node");
+ *     rc.begin(commandsReceived);
+ * }
+ *
+ * void loop() {
+ *     rc.peer(2).sendCommand(COMMAND_BLINK);
+ *     rc.run();
+ * }
+ * @endcode
+ * @note MultiPeerRemoteController::run() runs the RemoteControllers of all peers one after another and starts with the next peer on every call (round robin), so no peer is always served first. A received packet waits until the RemoteController of its sender runs, at most until the next MultiPeerRemoteController::run() call.
+ *
+ * @tparam Peers number of peers (the peer ids are 0 to Peers - 1), at most Connection::getPeerCount() of the Connection
+ * @tparam Config configuration of the RemoteController of every peer, see RemoteControllerT
+ */
+template <size_t Peers, class Config = RemoteControllerDefaultConfig>
+class MultiPeerRemoteController
+{
+public:
+	typedef RemoteControllerT<Config, PeerConnection> PeerController;
+
+	static_assert(Peers >= 1 && Peers <= 255, "Peers has to be between 1 and 255");
+	static_assert(!(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::Pump), "The peers share one Connection, run them with MultiPeerRemoteController::run() instead of RemoteController::Pump");
+
+#if defined(RC_ARCH_USE_FUNCTIONAL)
+	typedef std::function<void(uint8_t peer, const uint8_t commands[], const float throttles[], size_t length)> CommandCallback;
+	typedef std::function<void(uint8_t peer, const void *buffer, size_t length)> PayloadCallback;
+#else
+	typedef void (*CommandCallback)(uint8_t peer, const uint8_t commands[], const float throttles[], size_t length);
+	typedef void (*PayloadCallback)(uint8_t peer, const void *buffer, size_t length);
+#endif
+
+	/**
+	 * @brief Construct a new MultiPeerRemoteController
+	 *
+	 * @param connection the Connection shared by all peers
+	 */
+	MultiPeerRemoteController(Connection &connection) : mux(connection, stagingBuffer, sizeof stagingBuffer, Peers)
+	{
+		for (uint8_t peer = 0; peer < Peers; peer++)
+		{
+			connections[peer].attach(mux, peer);
+			new (controllerStorage[peer]) PeerController(connections[peer]);
+		}
+	}
+
+	~MultiPeerRemoteController()
+	{
+		for (uint8_t peer = 0; peer < Peers; peer++)
+		{
+			controller(peer).~PeerController();
+		}
+	}
+
+	/**
+	 * @brief Starts the Connection and the RemoteControllers of all peers
+	 *
+	 * @param cmdClb called with the peer id and the received commands
+	 * @param pldClb called with the peer id and a received payload
+	 * @return true all RemoteControllers were started
+	 * @return false the Connection does not have Peers peers or failed to start, or the RemoteController of MultiPeerRemoteController::getErrorPeer() failed to start
+	 */
+	bool begin(CommandCallback cmdClb, PayloadCallback pldClb = nullptr)
+	{
+		commandCallback = cmdClb;
+		payloadCallback = pldClb;
+		errorPeer = 0;
+		if (Peers > 1 && (!mux.connection.hasCapability(Connection::MultiPeer) || mux.connection.getPeerCount() < Peers))
+			return false;
+		if (!mux.begin())
+			return false;
+		for (uint8_t peer = 0; peer < Peers; peer++)
+		{
+#if defined(RC_ARCH_USE_FUNCTIONAL)
+			const bool begun = controller(peer).begin([this, peer](const uint8_t commands[], const float throttles[], size_t length)
+													   { if (commandCallback) commandCallback(peer, commands, throttles, length); },
+													   [this, peer](const void *buffer, size_t length)
+													   { if (payloadCallback) payloadCallback(peer, buffer, length); });
+#else
+			const bool begun = controller(peer).begin(forwardCommands, forwardPayload);
+#endif
+			if (!begun)
+			{
+				errorPeer = peer;
+				end();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Stops the RemoteControllers of all peers and the Connection
+	 *
+	 */
+	void end()
+	{
+		for (uint8_t peer = 0; peer < Peers; peer++)
+		{
+			controller(peer).end();
+		}
+		mux.end();
+	}
+
+	/**
+	 * @brief Runs the RemoteControllers of all peers, starting with the next peer on every call
+	 *
+	 * @return true Success
+	 * @return false An Error occured at one of the peers, get it with MultiPeerRemoteController::getErrorPeer()
+	 */
+	bool run()
+	{
+		bool success = true;
+#if !defined(RC_ARCH_USE_FUNCTIONAL)
+		running = this;
+#endif
+		for (size_t i = 0; i < Peers; i++)
+		{
+			runningPeer = (uint8_t)((firstPeer + i) % Peers);
+			if (!controller(runningPeer).run())
+			{
+				success = false;
+				errorPeer = runningPeer;
+			}
+		}
+		firstPeer = (uint8_t)((firstPeer + 1) % Peers);
+		return success;
+	}
+
+	/**
+	 * @brief The RemoteController of one peer, to send commands and payloads to the peer and to change its settings
+	 * @note The peers have no pump (RemoteController::startPump()), all of them are run by MultiPeerRemoteController::run() on one thread.
+	 *
+	 * @param peer id of the peer (0 to Peers - 1)
+	 */
+	PeerController &peer(uint8_t peer)
+	{
+		return controller(peer);
+	}
+
+	/**
+	 * @brief The peer of the last error reported by MultiPeerRemoteController::run() or MultiPeerRemoteController::begin(), get the error with peer(getErrorPeer()).getErrorCode()
+	 *
+	 */
+	uint8_t getErrorPeer() const
+	{
+		return errorPeer;
+	}
+
+	/**
+	 * @brief Number of packets dropped because they came from a peer id of Peers or higher
+	 *
+	 */
+	uint32_t getUnknownPeerDrops() const
+	{
+		return mux.getUnknownPeerDrops();
+	}
+
+#ifndef UNIT_TEST
+private:
+#endif
+	uint8_t stagingBuffer[Config::MaxPackageSize];
+	PeerMux mux;
+	PeerConnection connections[Peers];
+	// The RemoteControllers are constructed in place: each one needs the PeerConnection of its peer
+	alignas(PeerController) uint8_t controllerStorage[Peers][sizeof(PeerController)];
+	CommandCallback commandCallback = nullptr;
+	PayloadCallback payloadCallback = nullptr;
+	uint8_t firstPeer = 0;	 // Peer that runs first in the next MultiPeerRemoteController::run() call
+	uint8_t runningPeer = 0; // Peer whose RemoteController runs right now
+	uint8_t errorPeer = 0;
+
+	PeerController &controller(uint8_t peer)
+	{
+		return *reinterpret_cast<PeerController *>(controllerStorage[peer]);
+	}
+
+#if !defined(RC_ARCH_USE_FUNCTIONAL)
+	// Function pointers cannot carry the peer, the callbacks are only called from within run() and take it from there
+	static MultiPeerRemoteController *running;
+
+	static void forwardCommands(const uint8_t commands[], const float throttles[], size_t length)
+	{
+		if (running->commandCallback)
+			running->commandCallback(running->runningPeer, commands, throttles, length);
+	}
+
+	static void forwardPayload(const void *buffer, size_t length)
+	{
+		if (running->payloadCallback)
+			running->payloadCallback(running->runningPeer, buffer, length);
+	}
+#endif
+};
+
+#if !defined(RC_ARCH_USE_FUNCTIONAL)
+template <size_t Peers, class Config>
+MultiPeerRemoteController<Peers, Config> *MultiPeerRemoteController<Peers, Config>::running = nullptr;
+#endif
+
+#endif
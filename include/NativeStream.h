@@ -0,0 +1,95 @@
+#ifndef REMOTECONTROLLER_NATIVESTREAM_H_
+#define REMOTECONTROLLER_NATIVESTREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_NATIVE)
+
+/**
+ * @brief The part of the Arduino Stream interface SerialConnection uses, for the native environment where the Arduino core is not available
+ *
+ */
+class NativeStream
+{
+public:
+	virtual ~NativeStream() {}
+
+	/**
+	 * @brief Number of bytes that can be read without blocking
+	 *
+	 */
+	virtual int available() = 0;
+
+	/**
+	 * @brief Reads one byte
+	 *
+	 * @return int the byte or -1 if none is available
+	 */
+	virtual int read() = 0;
+
+	/**
+	 * @brief Writes the bytes
+	 *
+	 * @return size_t number of bytes written
+	 */
+	virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#ifndef REMOTECONTROLLER_FDSTREAM_BUFFER_SIZE
+#define REMOTECONTROLLER_FDSTREAM_BUFFER_SIZE 256 // bytes read from the file descriptor at once
+#endif
+
+/**
+ * @brief NativeStream over a non-blocking file descriptor, e.g. a serial port or a pseudo-terminal (FdStream::openPtyPair()) to test SerialConnection on Linux without hardware
+ *
+ */
+class FdStream : public NativeStream
+{
+public:
+	/**
+	 * @brief Construct a FdStream
+	 *
+	 * @param fd the file descriptor (switched to non-blocking mode), it is closed with the FdStream. -1 = not open yet
+	 */
+	FdStream(int fd = -1);
+	~FdStream();
+
+	/**
+	 * @brief Opens a pseudo-terminal in raw mode: bytes written to one end are read on the other end, like two UARTs connected with a cable
+	 *
+	 * @param master receives the master end of the pseudo-terminal
+	 * @param slave receives the slave end (the terminal device)
+	 * @return true both ends are open
+	 */
+	static bool openPtyPair(FdStream &master, FdStream &slave);
+
+	int available();
+	int read();
+
+	/**
+	 * @brief Writes all bytes, waits (up to 100ms at a time) while the kernel buffer is full
+	 *
+	 */
+	size_t write(const uint8_t *buffer, size_t size);
+
+	void close();
+	int getFd() const;
+
+private:
+	int fd;
+	uint8_t buffer[REMOTECONTROLLER_FDSTREAM_BUFFER_SIZE];
+	size_t head = 0;
+	size_t count = 0;
+
+	void open(int fd);
+	bool fill();
+};
+
+#endif
+
+#endif
+
+#endif
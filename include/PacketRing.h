@@ -0,0 +1,113 @@
+#ifndef REMOTECONTROLLER_PACKETRING_H_
+#define REMOTECONTROLLER_PACKETRING_H_
+
+#include "ArchConfig.h"
+#include "RemoteControllerConfig.h"
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer of packets. One side (e.g. an interrupt or a background thread) produces with PacketRing::reserve() and PacketRing::commit(), the other side (the main loop) consumes with PacketRing::front() and PacketRing::pop().
+ * @note Packets are written straight into their slot and read straight from it, nothing is copied by the ring itself.
+ *
+ */
+class PacketRing
+{
+public:
+	static const uint8_t Length = REMOTECONTROLLER_RECEIVE_RING_LENGTH;		 // Number of packet slots
+	static const size_t PacketSize = REMOTECONTROLLER_INCOMING_BUFFER_SIZE; // Bytes per packet slot
+
+	/**
+	 * @name Producer
+	 *
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Get the next free slot to write a packet of up to PacketRing::PacketSize bytes into
+	 *
+	 * @return uint8_t* the slot, publish it with PacketRing::commit(). nullptr if the ring is full, the packet counts as overflow drop.
+	 */
+	uint8_t *reserve();
+
+	/**
+	 * @brief Publish the slot returned by PacketRing::reserve() to the consumer
+	 *
+	 * @param length number of bytes written into the slot
+	 */
+	void commit(size_t length);
+
+	/**@}*/
+	/**
+	 * @name Consumer
+	 *
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Check if no packet is waiting
+	 *
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief The oldest packet, only valid if the ring is not empty
+	 *
+	 */
+	const uint8_t *front() const;
+
+	/**
+	 * @brief Length of the oldest packet, only valid if the ring is not empty
+	 *
+	 */
+	size_t frontLength() const;
+
+	/**
+	 * @brief Remove the oldest packet and free its slot for the producer
+	 *
+	 */
+	void pop();
+
+	/**@}*/
+	/**
+	 * @name Statistics
+	 *
+	 * Can be read from any side (on AVR the 32-bit drop counter may be read torn while an interrupt updates it)
+	 */
+	/**@{*/
+
+	/**
+	 * @brief Number of packets waiting
+	 *
+	 */
+	uint8_t size() const;
+
+	/**
+	 * @brief Highest number of packets that were waiting at once since the last PacketRing::resetStatistics()
+	 *
+	 */
+	uint8_t highWatermark() const;
+
+	/**
+	 * @brief Number of packets dropped because the ring was full since the last PacketRing::resetStatistics()
+	 *
+	 */
+	uint32_t overflowDrops() const;
+
+	/**
+	 * @brief Resets the high-watermark and the overflow drop counter
+	 *
+	 */
+	void resetStatistics();
+
+	/**@}*/
+private:
+	uint8_t packets[Length][PacketSize];
+	uint8_t lengths[Length];
+
+	// Free running indices, head is only written by the consumer and tail only by the producer
+	rc_atomic(uint8_t) head{0};
+	rc_atomic(uint8_t) tail{0};
+	rc_atomic(uint8_t) watermark{0};
+	rc_atomic(uint32_t) drops{0};
+};
+
+#endif
@@ -5,37 +5,475 @@
 #include "RemoteControllerConfig.h" // RemoteController preprocessor configuration (e.g. Buffer sizes, etc.). To use custom config define REMOTECONTROLLER_CUSTOM_CONFIG
 
 #include "Connections/Connection.h"
+#include "MpscRing.h"
+#include "Crc.h"
 
 /**
- * @brief The RemoteController Class provides a simple and easy to use API for RemoteControllers in Embedded Projects.
+ * @brief Types and RemoteController-Protocol decoding shared by all RemoteControllers, independent of the Connection type and the buffer configuration.
  *
  */
-class RemoteController
+class RemoteControllerTypes
 {
 public:
 	/**
 	 * @brief Priority with which the Command should be sent
 	 *
 	 */
-	enum Priority
+	enum Priority : uint8_t
 	{
-		Normal /** the command is sent as a batch when RemoteController::run() is called */,
-		High /** the command is sent immediately with the RemoteController::sendCommand() function call */
+		Normal = 0 /** the command is sent as a batch when RemoteController::run() is called */,
+		High = 1 /** the command is sent immediately with the RemoteController::sendCommand() function call */,
+		Low = 2 /** the command is sent as a batch when RemoteController::run() is called, after all more urgent queued commands */,
+		Urgent = 3 /** the command is sent as a batch when RemoteController::run() is called, before all less urgent queued commands */
 	};
 
 	/**
-	 * @brief Construct a new Remote Controller object
+	 * @brief What happens when a command is queued (Priority::Normal) while the same command is still waiting in the command queue
+	 *
+	 */
+	enum QueuePolicy : uint8_t
+	{
+		Append /** the command is appended to the queue, every queued command is transmitted (Default) */,
+		Coalesce /** latest value wins: the throttle of the already queued command is overwritten in place, e.g. for analog controls */
+	};
+
+	/**
+	 * @brief What happens to a command whose packet could not be transmitted
+	 *
+	 */
+	enum DeliveryMode : uint8_t
+	{
+		AtLeastOnce /** the command stays queued and is sent again until its packet was acknowledged (Default). With RemoteController::setUseSequenceNumbers() the receiver drops the packets it already got, e.g. for one-shot toggles */,
+		AtMostOnce /** the command is dropped if its packet was not acknowledged, it is never sent twice, e.g. for throttle streams where the next value follows anyway */
+	};
+
+	/**
+	 * @brief The RemoteController-Protocol version used to encode outgoing commands. Incoming commands are always decoded in both versions.
+	 *
+	 */
+	enum ProtocolVersion : uint8_t
+	{
+		ProtocolV1 = 1 /** 5 bytes per command: 8-bit instruction and 32-bit float throttle */,
+		ProtocolV2 = 2 /** 2 to 6 bytes per command: 8-bit instruction, 8-bit throttle encoding and the throttle in the smallest fitting encoding (none, uint8, uint16, 0.0-1.0 as 16-bit fixed point or float) */
+	};
+
+	/**
+	 * @brief Checksum appended to every packet (RemoteController::setFrameCheck()), see Crc
+	 *
+	 */
+	enum FrameCheck : uint8_t
+	{
+		NoFrameCheck /** the Connection is trusted to deliver intact packets, e.g. the NRF24L01 has a hardware CRC (Default) */,
+		Crc8 /** 1 byte CRC-8, detects all 1 and 2 bit errors in a 32 byte packet */,
+		Crc16 /** 2 byte CRC-16/CCITT-FALSE, for noisier links and longer packets */
+	};
+
+	/**
+	 * @brief Optional features of a RemoteControllerT configuration (Config::Features, see RemoteControllerFeatureConfig). Their state only takes RAM in the RemoteControllers that enable them.
 	 *
-	 * @param connection a reference to a Connection object
 	 */
-	RemoteController(Connection &connection);
-	~RemoteController();
+	enum Feature : uint8_t
+	{
+		LargePayloads = 1 /** RemoteController::sendLargePayload() and RemoteController::setLargePayloadBuffer() */,
+		SequenceNumbers = 2 /** RemoteController::setUseSequenceNumbers() and RemoteController::setDeliveryMode(), without it every command is DeliveryMode::AtLeastOnce. Receiving sequence numbers needs no feature. */,
+		Pump = 4 /** RemoteController::startPump(), only on ESP32 and native */
+	};
+
+	/**
+	 * @brief A received command
+	 *
+	 */
+	struct Command
+	{
+		uint8_t command;
+		float throttle;
+	};
+
+	/**
+	 * @brief Handler of one command registered with RemoteController::setCommandHandler(), it is called with the throttle of the received command
+	 *
+	 */
+#ifdef RC_ARCH_USE_FUNCTIONAL
+	typedef std::function<void(float throttle)> CommandHandler;
+#else
+	typedef void (*CommandHandler)(float throttle);
+#endif
+
+	/**
+	 * @brief Statistics of the last payload sent with RemoteController::sendLargePayload()
+	 *
+	 */
+	struct TransferStats
+	{
+		uint32_t bytes;			  // Size of the payload
+		uint32_t micros;		  // Time from RemoteController::sendLargePayload() until every fragment was acknowledged (0 while the transfer is running)
+		uint16_t fragments;		  // Fragment writes including retransmissions and failed writes
+		uint16_t retransmissions; // Writes of fragments that were written before (lost, not acknowledged or the write failed)
+
+		/**
+		 * @brief Throughput of the completed transfer in payload bytes per second
+		 *
+		 */
+		float bytesPerSecond() const { return micros ? bytes * 1000000.0f / micros : 0; }
+	};
+
+	/**
+	 * @brief Runtime statistics of a RemoteController, see RemoteController::getStatistics(). Only collected if REMOTECONTROLLER_STATISTICS is defined.
+	 *
+	 */
+	struct Statistics
+	{
+		uint32_t packetsSent;				 // Packets written to the connection (commands, payloads, fragments and fragment acknowledgements)
+		uint32_t bytesSent;					 // Bytes of the packets written to the connection
+		uint32_t packetsReceived;			 // Packets read from the connection
+		uint32_t bytesReceived;				 // Bytes of the packets read from the connection
+		uint32_t writeFailures;				 // Packets whose write failed (they are written again by the next run() call), the packets of a batch behind them are not attempted and not counted
+		uint32_t writeRetries;				 // Packets written again after their write failed
+		uint32_t commandsDropped;			 // Commands dropped because the command queue was full (RemoteController::CommandQueueFull)
+		uint32_t commandsExpired;			 // Queued commands dropped because their time to live passed before they were sent
+		uint32_t corruptPackets;			 // Received packets that could not be decoded (RemoteController::ReceivedCorruptPacket)
+		uint32_t duplicatePackets;			 // Received command packets dropped because their sequence number was already received
+		uint16_t commandQueueHighWatermark; // Most commands waiting in the command queue at once
+		uint16_t runMicros[REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS];	 // Histogram of the RemoteController::run() execution time, see Statistics::bucketMinMicros()
+		uint16_t writeMicros[REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS]; // Histogram of the time the connection blocked in write(), writeBatch() or writeAckPayload()
+
+		/**
+		 * @brief Histogram bucket a duration is counted in
+		 *
+		 * @param micros duration in microseconds
+		 * @return uint8_t bucket index: 0 below 16us, bucket n from 8 * 2^n us up to twice that
+		 */
+		static uint8_t bucket(uint32_t micros)
+		{
+			uint8_t bucket = 0;
+			for (micros >>= 4; micros && bucket < REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS - 1; micros >>= 1)
+			{
+				bucket++;
+			}
+			return bucket;
+		}
+
+		/**
+		 * @brief Shortest duration counted in a histogram bucket
+		 *
+		 * @param bucket bucket index
+		 * @return uint32_t lower bound of the bucket in microseconds
+		 */
+		static uint32_t bucketMinMicros(uint8_t bucket) { return bucket ? 8UL << bucket : 0; }
+	};
+
+	/**
+	 * @brief Read-only view of the commands of one received packet. The commands are decoded lazily straight from the receive buffer while iterating, nothing is copied.
+	 * @warning The view is only valid during the callback it is passed to!
+	 *
+	 * @code
+	 * void commandViewCallback(const RemoteController::CommandView &commands) {
+	 *     for (RemoteController::Command command : commands) {
+	 *         // command.command, command.throttle
+	 *     }
+	 * }
+	 * @endcode
+	 */
+	class CommandView
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(const uint8_t *position, size_t remaining, uint16_t identifier) : position(position), remaining(remaining), identifier(identifier) {}
+			Command operator*() const
+			{
+				Command command = {0, 0}; // Stays zero for an unknown throttle encoding
+				RemoteControllerTypes::decodeCommand(position, (size_t)-1, identifier, command.command, command.throttle);
+				return command;
+			}
+			Iterator &operator++()
+			{
+				position += RemoteControllerTypes::encodedCommandSize(position, identifier);
+				remaining--;
+				return *this;
+			}
+			bool operator!=(const Iterator &other) const { return remaining != other.remaining; }
+
+		private:
+			const uint8_t *position;
+			size_t remaining; // Commands left until the end of the view
+			uint16_t identifier;
+		};
+
+		CommandView(const uint8_t *commands, size_t length, uint16_t identifier) : commands(commands), length(length), identifier(identifier) {}
+
+		/**
+		 * @brief The number of commands in the view
+		 *
+		 */
+		size_t size() const { return length; }
+		Iterator begin() const { return Iterator(commands, length, identifier); }
+		Iterator end() const { return Iterator(nullptr, 0, identifier); }
+
+	private:
+		const uint8_t *commands; // First encoded command in the packet (after the identifier)
+		size_t length;			 // Number of commands
+		uint16_t identifier;	 // RemoteController-Protocol identifier of the packet, defines the encoding
+	};
+
+	/**
+	 * @brief An implementation of standard commands. WARNING if additonal commands want to be used implement an enum conforming to uint8_t holding ALL nedded Commands. IGNORE the StandardCommands enum. Only one enum of Commands can be used!!
+	 *
+	 */
+	enum StandardCommands : uint8_t
+	{
+		GoForward,
+		GoBackward,
+		GoLeft,
+		GoRight
+	};
+	/**
+	 * @brief Errors that can occur in the RemoteController, these are handled to the best ability by the RemoteControllerClass itself
+	 *
+	 */
+	enum Error : uint8_t
+	{
+		NoError /** No Error, RC is running fine*/,
+		CannotBeginConnection /** Remote Controller begin failed because it cannot begin its connection, probably because it failes to connect*/,
+		FailedToTransmitCommands /** The RemoteController failed to transmit the commands because the Connection didn't succesfully transmit the data*/,
+		CommandQueueFull /** The Command Queue is full. Too many commands where added and not transmitted. CAUSES UNDEFINED BEHAVIOR until a connection is established and commands are succesfully transmitted!*/,
+		CustomPayloadTooBig /** Buffer overflow prevented: The payload that was tried to be send with RemoteController::sendPayload() was too big for the Connection package buffer*/,
+		FailedToTransmitCustomPayload /** The Connection::write() failed to transmit the payload (No ack received)*/,
+		ReceivedCorruptPacket /** The packet that was received and triggered Connection::available() is corrupt and cannot be read! */,
+		ReceivedPayloadTooBig /** A payload sent with RemoteController::sendLargePayload() does not fit into the buffer set with RemoteController::setLargePayloadBuffer() */,
+		TransferInProgress /** RemoteController::sendLargePayload() was called while the previous payload is still being transmitted */,
+		WriteInProgress /** RemoteController::sendPayload() was called while the Connection is still transmitting the previous packet (Connection::AsyncWrite) */
+	};
+
+#ifndef UNIT_TEST
+protected:
+#endif
+	/**
+	 * @brief A queued command, it is encoded with the selected ProtocolVersion when it is packed into a packet.
+	 *
+	 */
+	struct QueuedCommand
+	{
+		uint8_t command;
+		uint8_t priority : 7; // Priority, the queue is sorted by its priorityRank()
+		uint8_t expires : 1;  // The command is dropped once deadline passed
+		uint16_t deadline;	  // rcmicros() / 1024, wraps every 67 s (that's why the time to live is limited to REMOTECONTROLLER_MAX_TTL)
+		float throttle;
+	};
+	static_assert(REMOTECONTROLLER_MAX_TTL <= 33000000UL, "REMOTECONTROLLER_MAX_TTL has to be below half the range of the 16-bit deadline (33 s)");
+
+	/**
+	 * @brief Throttle encodings of RemoteController-Protocol v2, sent as the second byte of every command.
+	 *
+	 */
+	enum ThrottleEncoding : uint8_t
+	{
+		ThrottleNone /** No throttle (0), 0 bytes */,
+		ThrottleUInt8 /** Integer throttle 0-255, 1 byte */,
+		ThrottleUInt16 /** Integer throttle 0-65535, 2 bytes little endian */,
+		ThrottleUnit16 /** Throttle between 0.0 and 1.0 quantized to 1/65535, 2 bytes little endian */,
+		ThrottleFloat /** Any other throttle as 32-bit float, 4 bytes */
+	};
+
+	/**
+	 * @brief Set of command ids for the per command settings (e.g. RemoteController::setQueuePolicy()): a setting for all commands and a short list of the commands that differ from it, instead of one bit for each of the 256 command ids.
+	 *
+	 */
+	class CommandSet
+	{
+	public:
+		bool contains(uint8_t command) const
+		{
+			return all != (find(command) < count);
+		}
+
+		/**
+		 * @brief Add or remove one command
+		 *
+		 * @return false REMOTECONTROLLER_POLICY_COMMANDS commands differ from the setting for all commands already
+		 */
+		bool set(uint8_t command, bool member)
+		{
+			const uint8_t index = find(command);
+			if (member == all)
+			{
+				if (index < count)
+				{
+					exceptions[index] = exceptions[--count]; // Back to the setting for all commands
+				}
+				return true;
+			}
+			if (index < count)
+			{
+				return true;
+			}
+			if (count == REMOTECONTROLLER_POLICY_COMMANDS)
+			{
+				return false;
+			}
+			exceptions[count++] = command;
+			return true;
+		}
+
+		/**
+		 * @brief Add or remove all commands
+		 *
+		 */
+		void setAll(bool member)
+		{
+			all = member;
+			count = 0;
+		}
+
+	private:
+		uint8_t find(uint8_t command) const
+		{
+			uint8_t index = 0;
+			while (index < count && exceptions[index] != command)
+			{
+				index++;
+			}
+			return index;
+		}
+
+		bool all = false;
+		uint8_t count = 0;
+		uint8_t exceptions[REMOTECONTROLLER_POLICY_COMMANDS]; // Commands that are (all == false) or are not (all == true) in the set
+	};
+
+	/**
+	 * @brief State of the fragmented payloads (Feature::LargePayloads)
+	 *
+	 */
+	struct LargePayloadState
+	{
+		// Outgoing fragmented payload (RemoteController::sendLargePayload())
+		const uint8_t *fragmentedPayload = nullptr; // nullptr while no transfer is running
+		size_t fragmentedPayloadLength = 0;
+		uint8_t transferId = 0;
+		uint8_t fragmentSize = 0;
+		uint8_t fragmentCount = 0;
+		uint8_t fragmentBase = 0;		// All fragments below are acknowledged
+		uint16_t fragmentsSentUpTo = 0; // First fragment that was never written (successfully or not), to count retransmissions
+		uint32_t fragmentsAcked = 0;	// Selectively acknowledged fragments, bit n = fragment fragmentBase + n
+		uint32_t fragmentsInFlight = 0; // Sent fragments waiting for acknowledgement, bit n = fragment fragmentBase + n
+		uint32_t transferStart = 0;
+		uint32_t lastFragmentProgress = 0; // Time of the last fragment transmission or acknowledgement
+		uint32_t fragmentTimeout = REMOTECONTROLLER_FRAGMENT_TIMEOUT;
+		TransferStats transferStats = {};
+
+		// Incoming fragmented payload (RemoteController::setLargePayloadBuffer())
+		uint8_t *reassemblyBuffer = nullptr;
+		size_t reassemblyBufferSize = 0;
+		bool reassemblyActive = false;
+		bool reassemblyComplete = false;
+		bool fragmentAckPending = false;
+		uint8_t reassemblyId = 0;
+		uint8_t reassemblyCount = 0;
+		uint8_t reassemblyFragmentSize = 0;
+		uint8_t reassemblyBase = 0;		 // All fragments below are received
+		uint32_t reassemblyReceived = 0; // Received fragments, bit n = fragment reassemblyBase + n
+		size_t reassemblyLength = 0;
+	};
+
+	/**
+	 * @brief State of the outgoing sequence numbers and delivery modes (Feature::SequenceNumbers)
+	 *
+	 */
+	struct SequenceState
+	{
+		CommandSet atMostOnceCommands; // Commands with DeliveryMode::AtMostOnce
+		bool useSequenceNumbers = false;
+		uint8_t outgoingSequence = 0;
+		bool outgoingSequenceSync = true; // Sent until a packet was acknowledged, the receiver restarts its duplicate window (e.g. after a reset of this RemoteController)
+		// Failed packets at the front of the command queue, they are sent again with the same sequence numbers and commands
+		uint8_t pinnedPackets = 0;
+		uint8_t pinnedSequences[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t pinnedCommands[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t pinnedCommandCount = 0; // Commands of all pinned packets
+	};
+
+#ifdef RC_ARCH_USE_THREADS
+	/**
+	 * @brief State of the pump thread (Feature::Pump), commands of other threads are handed over through commandRing
+	 *
+	 */
+	struct PumpState
+	{
+		MpscRing<QueuedCommand, REMOTECONTROLLER_COMMAND_RING_LENGTH> commandRing;
+		std::thread thread;
+		std::mutex mutex; // Only guards the sleep of the pump
+		std::condition_variable wakeup;
+		std::atomic<bool> running{false};		// Cleared by stopPump(), the pump loop ends
+		std::atomic<bool> ringOpen{false};		// sendCommand() hands commands to the pump, closed by the pump after its loop
+		std::atomic<bool> draining{false};		// The pump moves the last commands from the ring to the command queue
+		std::atomic<uint32_t> ringProducers{0}; // sendCommand() calls between checking ringOpen and pushing to the ring
+		std::atomic<bool> wakeupPending{false};
+		uint32_t period = REMOTECONTROLLER_PUMP_PERIOD;
+	};
+#else
+	struct PumpState; // The pump needs threads (ESP32 and native)
+#endif
+
+	/**
+	 * @brief The state of an optional Feature, a base class of RemoteControllerT. Empty if the feature is disabled.
+	 *
+	 */
+	template <bool Enabled, class State>
+	struct OptionalState
+	{
+		State state;
+		State *get() { return &state; }
+	};
+
+	template <class State>
+	struct OptionalState<false, State>
+	{
+		State *get() { return nullptr; }
+	};
+
+	/**
+	 * @brief Order of the priorities in the command queue (Low < Normal < Urgent < High), the values of Priority keep the numbering of Normal and High of older versions
+	 *
+	 */
+	static uint8_t priorityRank(uint8_t priority)
+	{
+		switch (priority)
+		{
+		case Low:
+			return 0;
+		case Normal:
+			return 1;
+		case Urgent:
+			return 2;
+		default:
+			return 3; // High
+		}
+	}
+
+	static size_t encodedCommandSize(const uint8_t *buffer, uint16_t identifier);
+	static size_t decodeCommand(const uint8_t *buffer, size_t length, uint16_t identifier, uint8_t &command, float &throttle);
+};
+
+/**
+ * @brief The RemoteController Class provides a simple and easy to use API for RemoteControllers in Embedded Projects.
+ * @note This is the implementation shared by all buffer configurations, it does not own any buffers. Use RemoteController (default configuration) or RemoteControllerT.
+ *
+ * @tparam ConnectionType the type the Connection is bound to: Connection (calls through the vtable, default) or a concrete final Connection class (calls are resolved at compile time and can be inlined)
+ */
+template <class ConnectionType>
+class RemoteControllerBaseT : public RemoteControllerTypes
+{
+public:
+	~RemoteControllerBaseT();
 
 #ifdef RC_ARCH_USE_FUNCTIONAL
 	/**
 	 * @brief Starts the RemoteController and connects it to the other controller. (Using std::functional)
 	 *
 	 * @param cmdClb this std::function callback is called when commands are received and passes the following arguments: (1) a c-array with the commands, (2) a c-array with the throttles, (3) the length of those arrays!
+	 * @note The arrays hold REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH commands (one 32 byte v1 packet). A packet with more commands (e.g. RemoteControllerPackageConfig<128>) is passed in several calls.
 	 * @return true succesffully started the RemoteController and connected to the other controller
 	 * @return false failed to start or connect
 	 */
@@ -46,6 +484,7 @@ public:
 	 *
 	 * @param cmdClb this callback function is called when commands are received and passes the following arguments: (1) a c-array with the commands, (2) a c-array with the throttles, (3) the length of those arrays!
 	 * @param pldClb this callback function is called when a binary payload is received
+	 * @note The arrays hold REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH commands (one 32 byte v1 packet). A packet with more commands (e.g. RemoteControllerPackageConfig<128>) is passed in several calls.
 	 * @return true succesffully started the RemoteController and connected to the other controller
 	 * @return false failed to start or connect
 	 */
@@ -55,6 +494,7 @@ public:
 	 * @brief Starts the RemoteController and connects it to the other controller. (Using C function pointers)
 	 *
 	 * @param cmdClb this c-function pointer callback is called when commands are received and passes the following arguments: (1) a c-array with the commands, (2) a c-array with the throttles, (3) the length of those arrays!
+	 * @note The arrays hold REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH commands (one 32 byte v1 packet). A packet with more commands (e.g. RemoteControllerPackageConfig<128>) is passed in several calls.
 	 * @return true succesffully started the RemoteController and connected to the other controller
 	 * @return false failed to start or connect
 	 */
@@ -65,6 +505,7 @@ public:
 	 *
 	 * @param cmdClb this callback function is called when commands are received and passes the following arguments: (1) a c-array with the commands, (2) a c-array with the throttles, (3) the length of those arrays!
 	 * @param pldClb this callback function is called when a binary payload is received
+	 * @note The arrays hold REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH commands (one 32 byte v1 packet). A packet with more commands (e.g. RemoteControllerPackageConfig<128>) is passed in several calls.
 	 * @return true succesffully started the RemoteController and connected to the other controller
 	 * @return false failed to start or connect
 	 */
@@ -72,6 +513,39 @@ public:
 #endif
 
 
+#ifdef RC_ARCH_USE_FUNCTIONAL
+	/**
+	 * @brief Set a zero-copy command callback. It is called once per received command packet with a RemoteController::CommandView, in addition to the (array based) command callback passed to RemoteController::begin() (pass nullptr there if it is not needed).
+	 *
+	 * @param viewClb this std::function callback is called when commands are received
+	 */
+	void setCommandViewCallback(std::function<void(const CommandView &commands)> viewClb);
+#else
+	/**
+	 * @brief Set a zero-copy command callback. It is called once per received command packet with a RemoteController::CommandView, in addition to the (array based) command callback passed to RemoteController::begin() (pass nullptr there if it is not needed).
+	 *
+	 * @param viewClb this c-function pointer callback is called when commands are received
+	 */
+	void setCommandViewCallback(void (*viewClb)(const CommandView &commands));
+#endif
+
+	/**
+	 * @brief Register the handler of one command. While at least one handler is registered RemoteController::run() looks up the handler of every received command (O(1)) and calls it while decoding the packet. Commands without a handler are dropped and the array based command callback is not called anymore.
+	 * @note Up to REMOTECONTROLLER_COMMAND_HANDLERS commands can have a handler. Registering a command again replaces its handler. Do not change the handlers from within a handler.
+	 *
+	 * @param command the command the handler is called for
+	 * @param handler called with the throttle of every received command, nullptr removes the handler of the command
+	 * @return true the handler was registered (or removed)
+	 * @return false the handler table is full
+	 */
+	bool setCommandHandler(uint8_t command, CommandHandler handler);
+
+	/**
+	 * @brief Remove all handlers registered with RemoteController::setCommandHandler(), the received commands are passed to the array based command callback again
+	 *
+	 */
+	void clearCommandHandlers();
+
 	/**
 	 * @brief Closes the RemoteController connection and frees all occupied memory
 	 *
@@ -80,64 +554,234 @@ public:
 
 	/**
 	 * @brief This function has to be called repeatedly in a loop! It handles the transmission of queued commands and receiving of commands/payloads.
-   *
+	 * @note If the Connection reports Connection::AsyncWrite, run() never waits for a transmission: it checks the packet that is in flight, starts the next one and handles the received packets (bounded by RemoteController::setReceiveBudget()). Only one packet is in flight at a time, so the command queue is sent one packet per run() call and a failed write is reported by the run() call that sees it.
+	 *
 	 * @return true RemoteController tasks where handled successfully
 	 * @return false An Error occured, get error using RemoteController::getErrorCode() or RemoteController::getErrorDescription()
 	 */
 	bool run();
 
+#ifdef RC_ARCH_USE_THREADS
+	/**
+	 * @brief Starts the pump: a background thread that calls RemoteController::run() every periodMicros. While the pump runs RemoteController::sendCommand() may be called from any number of threads at once, the commands are handed to the pump through a lock-free queue (REMOTECONTROLLER_COMMAND_RING_LENGTH commands). Only available on ESP32 and native.
+	 * @warning The pump thread is the only one using the Connection and the callbacks (command, payload and handler) are called on it. Do not call RemoteController::run() or other functions than RemoteController::sendCommand() from other threads while the pump runs, send payloads and read the error code from the callbacks instead.
+	 * @note Priority::High commands wake the pump, other commands are sent within one period. Needs RemoteController::Pump in the Features of the Config, see RemoteControllerFeatureConfig.
+	 *
+	 * @param periodMicros time between two RemoteController::run() calls of the pump
+	 * @return true the pump was started
+	 * @return false the pump is already running (or the Config has no RemoteController::Pump)
+	 */
+	bool startPump(uint32_t periodMicros = REMOTECONTROLLER_PUMP_PERIOD);
+
+	/**
+	 * @brief Stops the pump and waits for its thread to finish (if called from a callback on the pump thread, the pump ends after the current RemoteController::run() call). Commands that were handed to the pump are kept in the command queue.
+	 * @note Every RemoteController::sendCommand() call that started while the pump ran, even one that races with stopPump(), is in the command queue (or counted as dropped) when stopPump() returns. Called from a callback, that holds once RemoteController::isPumpRunning() returns false. After that sendCommand() uses the command queue directly and is not thread safe anymore.
+	 *
+	 */
+	void stopPump();
+
 	/**
-	 * @brief Sends a command to the other controller without throttle
+	 * @brief Check if the pump thread started with RemoteController::startPump() is running
+	 * @note After a stop from a callback this stays true until the pump has moved the last handed over commands to the command queue
+	 *
+	 */
+	bool isPumpRunning();
+#endif
+
+	/**
+	 * @brief Set how many incoming packets one RemoteController::run() call may handle (Default: 1 packet, no time limit)
+	 * @note Radios like the NRF24L01 only buffer a few packets (3), handling more than one packet per run() call prevents them from being dropped while the main loop is busy.
+	 *
+	 * @param maxPackets maximum number of packets handled per run() call (at least 1)
+	 * @param maxMicros time budget in microseconds, no further packets are read once it is used up (0 = no time limit). At least one packet is always handled.
+	 */
+	void setReceiveBudget(size_t maxPackets, uint32_t maxMicros = 0);
+
+	/**
+	 * @brief Deliver the commands of all packets handled in one RemoteController::run() call with a single command callback call (Default: false, one call per packet)
+	 * @note If the commands don't fit into the callback arrays (REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH) the callback is called once the arrays are full.
+	 *
+	 * @param aggregate true to aggregate the commands of multiple packets
+	 */
+	void setAggregateCommands(bool aggregate);
+
+	/**
+	 * @brief Snapshot of the runtime statistics, e.g. to stream them to telemetry
+	 * @note Only collected if REMOTECONTROLLER_STATISTICS is defined, otherwise all values are 0.
+	 *
+	 * @return Statistics copy of the counters and histograms
+	 */
+	Statistics getStatistics();
+
+	/**
+	 * @brief Reset all statistics to 0
+	 *
+	 */
+	void resetStatistics();
+
+	/**
+	 * @brief Sends a command to the other controller without throttle. Thread safe while the pump runs (RemoteController::startPump()).
 	 * @note The throttle is set internally (to 0) to comply with RemoteController-Protocol encoding requirements.
 	 * @param command The command to be sent (should be implemented as enum on both RemoteControllers)
 	 * @param priority The Priority with which the command should be sent
+	 * @param ttlMicros time to live: a queued command that could not be sent within this time (e.g. during a link dropout) is dropped instead of being delivered late (0 = no time limit, up to REMOTECONTROLLER_MAX_TTL, dropped up to 1024 us late)
 	 */
-	void sendCommand(uint8_t command, Priority priority = Priority::Normal);
+	void sendCommand(uint8_t command, Priority priority = Priority::Normal, uint32_t ttlMicros = 0);
 
 	/**
-	 * @brief Sends a command including a uint8_t throttle value.
+	 * @brief Sends a command including a uint8_t throttle value. Thread safe while the pump runs (RemoteController::startPump()).
 	 *
 	 * @param command The command to be sent (should be implemented as enum on both RemoteControllers)
 	 * @param throttle a uint8_t (0-255) value to be sent alongside the command for throttle, etc. control
 	 * @param priority The Priority with which the command should be sent
+	 * @param ttlMicros time to live: a queued command that could not be sent within this time (e.g. during a link dropout) is dropped instead of being delivered late (0 = no time limit, up to REMOTECONTROLLER_MAX_TTL, dropped up to 1024 us late)
 	 */
-	void sendCommand(uint8_t command, float throttle, Priority priority = Priority::Normal);
+	void sendCommand(uint8_t command, float throttle, Priority priority = Priority::Normal, uint32_t ttlMicros = 0);
 
 	/**
 	 * @brief Sends a binary payload to the other RemoteController. Basically a wrapper for Connection::write()
 	 *
 	 * @param buffer the binary data to be sent
 	 * @param length the length of the data buffer
-	 * @return true the payload was transmitted succesfully
+	 * @note With Connection::AsyncWrite the payload is copied and only handed to the Connection, a failed transmission is reported by the next RemoteController::run() call.
+	 *
+	 * @return true the payload was transmitted succesfully (with Connection::AsyncWrite: the transmission was started)
 	 * @return false failed to transmit the payload, use RemoteController::getErrorCode() or RemoteController::getErrorDescription() for info!
 	 */
 	bool sendPayload(const void *buffer, size_t length);
 
 	/**
-	 * @brief An implementation of standard commands. WARNING if additonal commands want to be used implement an enum conforming to uint8_t holding ALL nedded Commands. IGNORE the StandardCommands enum. Only one enum of Commands can be used!!
+	 * @brief Sends a payload that is larger than one packet. It is split into fragments that are transmitted with the following RemoteController::run() calls, a sliding window of REMOTECONTROLLER_FRAGMENT_WINDOW fragments is sent without waiting and fragments the other RemoteController did not acknowledge are sent again.
+	 * @warning The buffer is not copied, it has to stay valid until RemoteController::isSendingLargePayload() returns false!
 	 *
+	 * @param buffer the binary data to be sent
+	 * @param length the length of the data buffer, up to 255 fragments (packet size - REMOTECONTROLLER_FRAGMENT_HEADER_SIZE bytes each)
+	 * @note Needs RemoteController::LargePayloads in the Features of the Config, see RemoteControllerFeatureConfig
+	 * @return true the transfer was started
+	 * @return false the payload is too big or another transfer is still running, use RemoteController::getErrorCode() or RemoteController::getErrorDescription() for info!
 	 */
-	enum StandardCommands : uint8_t
-	{
-		GoForward,
-		GoBackward,
-		GoLeft,
-		GoRight
-	};
+	bool sendLargePayload(const void *buffer, size_t length);
+
 	/**
-	 * @brief Errors that can occur in the RemoteController, these are handled to the best ability by the RemoteControllerClass itself
+	 * @brief Check if a payload sent with RemoteController::sendLargePayload() is still being transmitted
 	 *
 	 */
-	enum Error : uint8_t
-	{
-		NoError /** No Error, RC is running fine*/,
-		CannotBeginConnection /** Remote Controller begin failed because it cannot begin its connection, probably because it failes to connect*/,
-		FailedToTransmitCommands /** The RemoteController failed to transmit the commands because the Connection didn't succesfully transmit the data*/,
-		CommandQueueFull /** The Command Queue is full. Too many commands where added and not transmitted. CAUSES UNDEFINED BEHAVIOR until a connection is established and commands are succesfully transmitted!*/,
-		CustomPayloadTooBig /** Buffer overflow prevented: The payload that was tried to be send with RemoteController::sendPayload() was too big for the Connection package buffer*/,
-		FailedToTransmitCustomPayload /** The Connection::write() failed to transmit the payload (No ack received)*/,
-		ReceivedCorruptPacket /** The packet that was received and triggered Connection::available() is corrupt and cannot be read! */
-	};
+	bool isSendingLargePayload();
+
+	/**
+	 * @brief Get the statistics (e.g. throughput) of the last payload sent with RemoteController::sendLargePayload()
+	 *
+	 */
+	const TransferStats &getTransferStats();
+
+	/**
+	 * @brief Set the buffer payloads sent with RemoteController::sendLargePayload() are reassembled into. A completely received payload is passed to the payload callback, fragments are ignored while no buffer is set.
+	 * @note The buffer is reused for the next payload once the payload callback returned. Needs RemoteController::LargePayloads in the Features of the Config, see RemoteControllerFeatureConfig
+	 *
+	 * @param buffer the reassembly buffer
+	 * @param size size of the buffer in bytes, bigger payloads are rejected (RemoteController::ReceivedPayloadTooBig)
+	 */
+	void setLargePayloadBuffer(void *buffer, size_t size);
+
+	/**
+	 * @brief Set the time without acknowledgement after which unacknowledged fragments are sent again (Default: REMOTECONTROLLER_FRAGMENT_TIMEOUT)
+	 *
+	 * @param micros timeout in microseconds
+	 */
+	void setFragmentTimeout(uint32_t micros);
+
+	/**
+	 * @brief Send queued commands and payloads back with the acknowledgement of the next packet received from the other RemoteController instead of a transmission of their own (Default: false). Only takes effect if the Connection reports Connection::AckPayload (e.g. RF24Connection).
+	 * @note Meant for the answering side of request/response style control loops (e.g. a vehicle sending telemetry): there is no TX/RX switch, but the replies are only sent as often as the other RemoteController sends packets. Up to 3 packets (NRF24L01) wait for the next acknowledgement, while they are waiting RemoteController::sendPayload() fails and commands stay in the command queue. The other RemoteController receives them through the normal callbacks.
+	 *
+	 * @param enable true to reply with ack payloads
+	 */
+	void setUseAckPayloads(bool enable);
+
+	/**
+	 * @brief Set the QueuePolicy of a single command
+	 * @note Up to REMOTECONTROLLER_POLICY_COMMANDS commands can have another QueuePolicy than the one set for all commands.
+	 *
+	 * @param command The command the policy applies to
+	 * @param policy QueuePolicy::Coalesce to overwrite the throttle of an already queued command, QueuePolicy::Append to queue every command
+	 * @return true the policy was set
+	 * @return false REMOTECONTROLLER_POLICY_COMMANDS commands have another QueuePolicy already
+	 */
+	bool setQueuePolicy(uint8_t command, QueuePolicy policy);
+
+	/**
+	 * @brief Set the QueuePolicy of all commands
+	 *
+	 * @param policy QueuePolicy::Coalesce to overwrite the throttle of an already queued command, QueuePolicy::Append to queue every command
+	 */
+	void setQueuePolicy(QueuePolicy policy);
+
+	/**
+	 * @brief Get the QueuePolicy of a command
+	 *
+	 */
+	QueuePolicy getQueuePolicy(uint8_t command);
+
+	/**
+	 * @brief Set the DeliveryMode of a single command
+	 *
+	 * @param command The command the mode applies to
+	 * @param mode DeliveryMode::AtLeastOnce to send the command again until it was acknowledged, DeliveryMode::AtMostOnce to drop it if its packet was not acknowledged
+	 * @note Needs RemoteController::SequenceNumbers in the Features of the Config, see RemoteControllerFeatureConfig. Up to REMOTECONTROLLER_POLICY_COMMANDS commands can have another DeliveryMode than the one set for all commands.
+	 * @return true the mode was set
+	 * @return false REMOTECONTROLLER_POLICY_COMMANDS commands have another DeliveryMode already
+	 */
+	bool setDeliveryMode(uint8_t command, DeliveryMode mode);
+
+	/**
+	 * @brief Set the DeliveryMode of all commands
+	 * @note Needs RemoteController::SequenceNumbers in the Features of the Config, see RemoteControllerFeatureConfig
+	 *
+	 */
+	void setDeliveryMode(DeliveryMode mode);
+
+	/**
+	 * @brief Get the DeliveryMode of a command
+	 *
+	 */
+	DeliveryMode getDeliveryMode(uint8_t command);
+
+	/**
+	 * @brief Send a sequence number with every command packet (Default: false). The other RemoteController drops command packets it already received, e.g. when an acknowledgement was lost and the packet was sent again. Packets with sequence numbers are always understood, only the sender has to enable them.
+	 * @note A packet that failed is sent again with the same sequence number and the same commands (without the DeliveryMode::AtMostOnce ones), commands are not coalesced into it anymore. Commands sent with Priority::High are queued and sent together with the command queue.
+	 * @note Needs RemoteController::SequenceNumbers in the Features of the Config, see RemoteControllerFeatureConfig
+	 *
+	 * @param enable true to send sequence numbers
+	 */
+	void setUseSequenceNumbers(bool enable);
+
+	/**
+	 * @brief Set the RemoteController-Protocol version used to encode outgoing commands (Default: ProtocolV1)
+	 * @note Only use ProtocolV2 if the other RemoteController understands it (i.e. runs this or a newer library version). Every command packet carries its version in the identifier, so the receiver decodes v1 and v2 packets transparently.
+	 *
+	 * @param version the RemoteController-Protocol version
+	 */
+	void setProtocolVersion(ProtocolVersion version);
+
+	/**
+	 * @brief Get the RemoteController-Protocol version used to encode outgoing commands
+	 *
+	 */
+	ProtocolVersion getProtocolVersion();
+
+	/**
+	 * @brief Append a checksum to every outgoing packet and verify it on every incoming packet before it is decoded (Default: NoFrameCheck), for connections without a hardware CRC (e.g. UART). Packets with a wrong checksum are dropped with RemoteController::Error::ReceivedCorruptPacket.
+	 * @warning Both RemoteControllers have to use the same FrameCheck, the checksum is not announced in the packet (a bit error could announce a packet without one). The checksum takes 1 (Crc8) or 2 (Crc16) bytes of every packet, custom payloads (RemoteController::sendPayload()) can be that much shorter.
+	 *
+	 * @param check the checksum, see RemoteController::FrameCheck
+	 */
+	void setFrameCheck(FrameCheck check);
+
+	/**
+	 * @brief Get the checksum appended to every packet
+	 *
+	 */
+	FrameCheck getFrameCheck();
 
 	/**
 	 * @brief Get the current Error Code
@@ -154,36 +798,360 @@ public:
 	_String getErrorDescription();
 
 #ifndef UNIT_TEST
-private:
+protected:
 #endif
-	Connection &connection;
 	/**
-	 * @brief Holds a list of Commands per RemoteController-Protocol v1.0.0: 8-bit instruction 32-bit float throttle.
+	 * @brief Buffers and sizes of a configuration, provided by RemoteControllerT
 	 *
 	 */
-	uint8_t commandQueue[REMOTECONTROLLER_COMMAND_QUEUE_SIZE];
-	size_t commandQueueIndex = 0; // The currently free index in the command queue to write to (needs to be checked for out-of-bounds before writing)
-	
-	uint8_t incomingBuffer[REMOTECONTROLLER_INCOMING_BUFFER_SIZE];
-	uint8_t outgoingBuffer[REMOTECONTROLLER_OUTGOING_BUFFER_SIZE];
+	struct Storage
+	{
+		uint8_t *incomingBuffer;
+		uint8_t *outgoingBuffer;
+		QueuedCommand *commandQueue;
+		size_t packageSize;			 // Size of the incoming buffer and of each outgoing packet slot
+		size_t batchSize;			 // Outgoing packet slots
+		size_t commandQueueCapacity; // Commands
+		LargePayloadState *largePayload; // nullptr without Feature::LargePayloads
+		SequenceState *sequenceState;	 // nullptr without Feature::SequenceNumbers
+#ifdef RC_ARCH_USE_THREADS
+		PumpState *pumpState; // nullptr without Feature::Pump
+#endif
+	};
+
+	/**
+	 * @brief Construct a new Remote Controller object
+	 *
+	 * @param connection a reference to a Connection object
+	 * @param storage buffers owned by RemoteControllerT
+	 */
+	RemoteControllerBaseT(ConnectionType &connection, const Storage &storage);
+
+	ConnectionType &connection;
+	uint8_t *const incomingBuffer;
+	uint8_t *const outgoingBuffer; // One slot of packageSize bytes per packet of a batch
+	/**
+	 * @brief Ring buffer of Commands that are transmitted with the next RemoteController::run() call. Commands are removed packet by packet as soon as their packet was transmitted.
+	 *
+	 */
+	QueuedCommand *const commandQueue;
+	const size_t packageSize;
+	const size_t batchSize;
+	const size_t commandQueueCapacity;
+	size_t commandQueueHead = 0;   // Index of the oldest queued command
+	size_t commandQueueLength = 0; // Number of queued commands
+	ProtocolVersion protocolVersion = ProtocolV1;
+	FrameCheck frameCheck = NoFrameCheck;
+	CommandSet coalescedCommands; // Commands with QueuePolicy::Coalesce
+	size_t receiveBudgetPackets = 1;
+	uint32_t receiveBudgetMicros = 0;
+	bool aggregateCommands = false;
+	bool useAckPayloads = false;
+
+	SequenceState *const sequenceState; // Outgoing sequence numbers and delivery modes (RemoteController::setUseSequenceNumbers()), nullptr without Feature::SequenceNumbers
+
+	// Duplicate window of the incoming sequence numbers
+	bool incomingSequenceValid = false;
+	bool incomingSequenceSync = false; // The window was restarted by a sync packet and no other packet was received since
+	uint8_t incomingSequence = 0;		 // Highest sequence number received
+	uint32_t incomingSequenceWindow = 0; // Bit n: sequence number incomingSequence - n was received
+
+	LargePayloadState *const largePayload; // Fragmented payloads (RemoteController::sendLargePayload()), nullptr without Feature::LargePayloads
+
+#ifdef RC_ARCH_USE_THREADS
+	PumpState *const pumpState; // Pump thread (RemoteController::startPump()), nullptr without Feature::Pump
+	void pump();
+	void drainCommandRing();
+#endif
+
+	/**
+	 * @brief What the packet in flight (Connection::AsyncWrite) was sent for, decides what happens once the Connection reports the result
+	 *
+	 */
+	enum PendingWrite : uint8_t
+	{
+		NoWrite,
+		CommandWrite,
+		FragmentWrite,
+		FragmentAckWrite,
+		PayloadWrite
+	};
+	PendingWrite pendingWrite = NoWrite;
+	size_t pendingLength = 0;
+	uint8_t pendingSequence = 0;   // CommandWrite
+	size_t pendingCommands = 0;	   // CommandWrite: the first pendingCommands queued commands are in the packet
+	uint8_t pendingTransferId = 0; // FragmentWrite
+	uint8_t pendingFragment = 0;   // FragmentWrite: index of the fragment
+#ifdef REMOTECONTROLLER_STATISTICS
+	uint32_t pendingStart = 0; // rcmicros() time the write was started
+#endif
 	
-	uint8_t incomingCommandsBuffer[REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH];
-	float incomingThrottlesBuffer[REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH];
+
+	/**
+	 * @brief Arrays handed to the array based command callback, only allocated (on the stack of RemoteControllerBaseT::receiveIntoArrays()) while RemoteController::run() receives packets for that callback.
+	 *
+	 */
+	struct CommandArrays
+	{
+		uint8_t commands[REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH];
+		float throttles[REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH];
+		size_t length;
+	};
 
 #if defined(RC_ARCH_USE_FUNCTIONAL)
 	std::function<void(const uint8_t commands[], const float throttles[], size_t length)> commandCallbackFunction;
+	std::function<void(const CommandView &commands)> commandViewCallbackFunction;
 	std::function<void(const void *buffer, size_t length)> payloadCallbackFunction;
 #else
 	void (*commandCallbackFunction)(const uint8_t commands[], const float throttles[], size_t length);
+	void (*commandViewCallbackFunction)(const CommandView &commands) = nullptr;
 	void (*payloadCallbackFunction)(const void *buffer, size_t length);
 
+#endif
+
+	// Command handlers (RemoteController::setCommandHandler()), handlerCommands[i] is handled by handlers[i]
+	CommandHandler handlers[REMOTECONTROLLER_COMMAND_HANDLERS];
+	uint8_t handlerCommands[REMOTECONTROLLER_COMMAND_HANDLERS];
+	uint8_t handlerCount = 0;
+#ifdef RC_ARCH_FLAT_COMMAND_HANDLER_TABLE
+	uint8_t handlerSlots[256] = {}; // Index + 1 into handlers per command, 0 = no handler
+#endif
+
+#ifdef REMOTECONTROLLER_STATISTICS
+	Statistics statistics = {};
+	bool writeFailed = false; // The last write failed, the next one is a retry
 #endif
 
 	Error error = NoError;
 	bool m_begin();
-	void addToCommandQueue(uint8_t command, float throttle);
-	bool transmitCommands(const uint8_t commands[], size_t length);
-	void encodeCommand(uint8_t command, float throttle, uint8_t *buffer);
+	bool m_run();
+	bool receive();
+	bool receivePackets(CommandArrays *arrays);
+	RC_NOINLINE bool receiveIntoArrays();
+	bool receivePacket(CommandArrays *arrays);
+	void deliverCommands(const CommandView &view, CommandArrays *arrays);
+	void flushCommandArrays(CommandArrays &arrays);
+	int findCommandHandler(uint8_t command) const;
+	QueuedCommand makeQueuedCommand(uint8_t command, float throttle, Priority priority, uint32_t ttlMicros);
+	void addToCommandQueue(QueuedCommand queuedCommand);
+	void dropExpiredCommands();
+	bool transmitCommands();
+	bool commandPacketsWritten(uint8_t sequences[], size_t commandsInPackets[], size_t packetCount, size_t packetsSent);
+	bool transmitCommand(uint8_t command, float throttle);
+	bool asyncWrites();
+	bool startPacket(PendingWrite kind, const void *buffer, size_t length);
+	bool pollPendingWrite();
+	size_t lockedCommands();
+	bool writePacket(const void *buffer, size_t length);
+	void countWrite(const size_t lengths[], size_t count, size_t packetsSent, uint32_t start);
+	size_t writePackets(const void *const packets[], const size_t lengths[], size_t count);
+	size_t maxPacketsPerWrite();
+	bool transmitFragments();
+	void fragmentsWritten(const size_t indices[], size_t packetCount, size_t packetsSent);
+	size_t packFragment(uint8_t *packet, size_t index);
+	bool receiveFragment(const uint8_t *packet, size_t length);
+	void receiveFragmentAck(const uint8_t *packet, size_t length);
+	void transmitFragmentAck();
+	size_t beginCommandPacket(uint8_t *packet, uint8_t sequence);
+	bool sendsSequenceNumbers() const;
+	uint8_t nextSequence();
+	bool acceptSequence(uint8_t header);
+	void unpinPackets(size_t count);
+	void keepFailedPackets(const uint8_t sequences[], size_t commandsInPackets[], size_t count);
+	bool packCommand(uint8_t *packet, const QueuedCommand &queuedCommand, size_t &bytesInPacket, size_t maxPackageSize);
+	QueuedCommand &queuedCommandAt(size_t index);
+	size_t encodeCommand(uint8_t command, float throttle, uint8_t *buffer);
+	size_t frameCheckSize();
+	size_t appendFrameCheck(uint8_t *packet, size_t length);
+	bool checkFrame(const uint8_t *packet, size_t &length);
+	size_t encodedCommandSize(float throttle);
+	ThrottleEncoding throttleEncoding(float throttle);
 };
 
+/**
+ * @brief Default configuration of RemoteControllerT, taken from the REMOTECONTROLLER_* macros in RemoteControllerConfig.h
+ *
+ */
+struct RemoteControllerDefaultConfig
+{
+	static constexpr size_t MaxPackageSize = REMOTECONTROLLER_OUTGOING_BUFFER_SIZE;		 // bytes per packet
+	static constexpr size_t CommandQueueLength = REMOTECONTROLLER_COMMAND_QUEUE_LENGTH; // commands
+	static constexpr size_t BatchSize = REMOTECONTROLLER_OUTGOING_BATCH_SIZE;			 // packets per Connection::writeBatch()
+	static constexpr uint8_t Features = REMOTECONTROLLER_FEATURES;						 // RemoteControllerTypes::Feature flags
+};
+
+/**
+ * @brief Configuration of RemoteControllerT derived from the maximum package size of the Connection
+ *
+ * @tparam PackageSize maximum package size of the Connection in bytes (e.g. 32 for the NRF24L01)
+ * @tparam QueuedPackets the command queue holds as many commands as fit into this many (RemoteController-Protocol v1) packets
+ * @tparam PacketsPerBatch packets per Connection::writeBatch() (the NRF24L01 TX FIFO holds 3 packets)
+ */
+template <size_t PackageSize, size_t QueuedPackets = 2, size_t PacketsPerBatch = REMOTECONTROLLER_OUTGOING_BATCH_SIZE>
+struct RemoteControllerPackageConfig
+{
+	static constexpr size_t MaxPackageSize = PackageSize;
+	static constexpr size_t CommandQueueLength = QueuedPackets * ((PackageSize - 2) / REMOTECONTROLLER_ENCODED_COMMAND_SIZE);
+	static constexpr size_t BatchSize = PacketsPerBatch;
+};
+
+/**
+ * @brief Configuration of RemoteControllerT with optional features enabled, the sizes are taken from BaseConfig
+ *
+ * @code
+ * RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::LargePayloads>> rc(connection); // Default sizes and RemoteController::sendLargePayload()
+ * @endcode
+ *
+ * @tparam EnabledFeatures RemoteControllerTypes::Feature flags combined with |
+ * @tparam BaseConfig provides MaxPackageSize, CommandQueueLength and BatchSize, e.g. RemoteControllerPackageConfig
+ */
+template <uint8_t EnabledFeatures, class BaseConfig = RemoteControllerDefaultConfig>
+struct RemoteControllerFeatureConfig : BaseConfig
+{
+	static constexpr uint8_t Features = EnabledFeatures;
+};
+
+/**
+ * @brief The Features of a Config, 0 if it has none (e.g. a Config written before the features existed)
+ *
+ */
+template <class Config>
+struct RemoteControllerConfigFeatures
+{
+	template <class C>
+	static constexpr uint8_t features(decltype(C::Features) *) { return C::Features; }
+	template <class C>
+	static constexpr uint8_t features(...) { return 0; }
+	static constexpr uint8_t value = features<Config>(nullptr);
+};
+
+/**
+ * @brief A RemoteController whose buffers are sized at compile time by Config, so multiple RemoteControllers in one firmware can use different sizes. The implementation (RemoteControllerBase) is shared by all configurations.
+ *
+ * @code
+ * RemoteControllerT<RemoteControllerPackageConfig<32, 4>> rc(connection); // 32 byte packets, queue for 4 packets of commands
+ * @endcode
+ *
+ * @tparam Config provides MaxPackageSize, CommandQueueLength and BatchSize as constexpr and optionally the Features, e.g. RemoteControllerDefaultConfig, RemoteControllerPackageConfig or RemoteControllerFeatureConfig
+ * @tparam ConnectionType Connection (Default) or the concrete final Connection class to bind at compile time, see RemoteControllerBaseT
+ */
+template <class Config, class ConnectionType = Connection>
+class RemoteControllerT : RemoteControllerTypes::OptionalState<(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::LargePayloads) != 0, RemoteControllerTypes::LargePayloadState>,
+						  RemoteControllerTypes::OptionalState<(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::SequenceNumbers) != 0, RemoteControllerTypes::SequenceState>,
+						  RemoteControllerTypes::OptionalState<(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::Pump) != 0, RemoteControllerTypes::PumpState>,
+						  public RemoteControllerBaseT<ConnectionType>
+{
+	typedef RemoteControllerBaseT<ConnectionType> Base;
+	// The feature states are base classes listed before Base, they are constructed before Base gets their addresses
+	typedef RemoteControllerTypes::OptionalState<(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::LargePayloads) != 0, RemoteControllerTypes::LargePayloadState> LargePayloadStorage;
+	typedef RemoteControllerTypes::OptionalState<(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::SequenceNumbers) != 0, RemoteControllerTypes::SequenceState> SequenceStorage;
+	typedef RemoteControllerTypes::OptionalState<(RemoteControllerConfigFeatures<Config>::value & RemoteControllerTypes::Pump) != 0, RemoteControllerTypes::PumpState> PumpStorage;
+
+public:
+	static constexpr uint8_t Features = RemoteControllerConfigFeatures<Config>::value;
+	static constexpr size_t PackageSize = Config::MaxPackageSize;
+	static constexpr size_t CommandQueueLength = Config::CommandQueueLength;
+	static constexpr size_t BatchSize = Config::BatchSize;
+	static constexpr size_t OutgoingBufferSize = PackageSize * BatchSize;
+
+	static_assert(PackageSize >= 2 + REMOTECONTROLLER_ENCODED_COMMAND_SIZE, "The package size has to fit at least one command (identifier and RemoteController-Protocol v1 command)");
+	static_assert(CommandQueueLength >= 1, "The command queue needs space for at least one command");
+	static_assert(BatchSize >= 1 && BatchSize <= REMOTECONTROLLER_MAX_BATCH_SIZE, "BatchSize has to be between 1 and REMOTECONTROLLER_MAX_BATCH_SIZE");
+#ifndef RC_ARCH_USE_THREADS
+	static_assert(!(Features & RemoteControllerTypes::Pump), "RemoteController::Pump needs threads (ESP32 and native)");
+#endif
+
+	/**
+	 * @brief Construct a new Remote Controller object
+	 *
+	 * @param connection a reference to a Connection object
+	 */
+	RemoteControllerT(ConnectionType &connection) : Base(connection, storage(this)) {}
+
+	bool sendLargePayload(const void *buffer, size_t length)
+	{
+		static_assert(Features & RemoteControllerTypes::LargePayloads, "sendLargePayload() needs RemoteController::LargePayloads in the Features of the Config, see RemoteControllerFeatureConfig");
+		return Base::sendLargePayload(buffer, length);
+	}
+
+	void setLargePayloadBuffer(void *buffer, size_t size)
+	{
+		static_assert(Features & RemoteControllerTypes::LargePayloads, "setLargePayloadBuffer() needs RemoteController::LargePayloads in the Features of the Config, see RemoteControllerFeatureConfig");
+		Base::setLargePayloadBuffer(buffer, size);
+	}
+
+	bool setDeliveryMode(uint8_t command, RemoteControllerTypes::DeliveryMode mode)
+	{
+		static_assert(Features & RemoteControllerTypes::SequenceNumbers, "setDeliveryMode() needs RemoteController::SequenceNumbers in the Features of the Config, see RemoteControllerFeatureConfig");
+		return Base::setDeliveryMode(command, mode);
+	}
+
+	void setDeliveryMode(RemoteControllerTypes::DeliveryMode mode)
+	{
+		static_assert(Features & RemoteControllerTypes::SequenceNumbers, "setDeliveryMode() needs RemoteController::SequenceNumbers in the Features of the Config, see RemoteControllerFeatureConfig");
+		Base::setDeliveryMode(mode);
+	}
+
+	void setUseSequenceNumbers(bool enable)
+	{
+		static_assert(Features & RemoteControllerTypes::SequenceNumbers, "setUseSequenceNumbers() needs RemoteController::SequenceNumbers in the Features of the Config, see RemoteControllerFeatureConfig");
+		Base::setUseSequenceNumbers(enable);
+	}
+
+#ifdef RC_ARCH_USE_THREADS
+	bool startPump(uint32_t periodMicros = REMOTECONTROLLER_PUMP_PERIOD)
+	{
+		static_assert(Features & RemoteControllerTypes::Pump, "startPump() needs RemoteController::Pump in the Features of the Config, see RemoteControllerFeatureConfig");
+		return Base::startPump(periodMicros);
+	}
+
+	~RemoteControllerT()
+	{
+		this->stopPump(); // The pump thread uses the buffers below
+	}
+#endif
+
+#ifndef UNIT_TEST
+private:
+#endif
+	uint8_t incomingStorage[PackageSize];
+	uint8_t outgoingStorage[OutgoingBufferSize];
+	RemoteControllerTypes::QueuedCommand commandQueueStorage[CommandQueueLength];
+
+	// Static: no member function may be called before the base class is constructed, only the addresses of the arrays are taken
+	static typename Base::Storage storage(RemoteControllerT *self)
+	{
+		typename Base::Storage storage = {self->incomingStorage, self->outgoingStorage, self->commandQueueStorage, PackageSize, BatchSize, CommandQueueLength,
+										  static_cast<LargePayloadStorage *>(self)->get(), static_cast<SequenceStorage *>(self)->get(),
+#ifdef RC_ARCH_USE_THREADS
+										  static_cast<PumpStorage *>(self)->get()
+#endif
+		};
+		return storage;
+	}
+};
+
+template <class Config, class ConnectionType>
+constexpr uint8_t RemoteControllerT<Config, ConnectionType>::Features;
+template <class Config, class ConnectionType>
+constexpr size_t RemoteControllerT<Config, ConnectionType>::PackageSize;
+template <class Config, class ConnectionType>
+constexpr size_t RemoteControllerT<Config, ConnectionType>::CommandQueueLength;
+template <class Config, class ConnectionType>
+constexpr size_t RemoteControllerT<Config, ConnectionType>::BatchSize;
+template <class Config, class ConnectionType>
+constexpr size_t RemoteControllerT<Config, ConnectionType>::OutgoingBufferSize;
+
+/**
+ * @brief The RemoteController with the default configuration (RemoteControllerConfig.h)
+ *
+ */
+typedef RemoteControllerT<RemoteControllerDefaultConfig> RemoteController;
+
+#include "RemoteControllerImpl.h" // Implementation of the templates
+
+// The implementation bound to the Connection base class is compiled once in RemoteController.cpp
+extern template class RemoteControllerBaseT<Connection>;
+typedef RemoteControllerBaseT<Connection> RemoteControllerBase;
+
 #endif
\ No newline at end of file
@@ -1,17 +1,92 @@
 #ifndef REMOTECONTROLLER_CONFIG_H_
 #define REMOTECONTROLLER_CONFIG_H_
 
+#ifndef REMOTECONTROLLER_ENCODED_COMMAND_MIN_SIZE
+#define REMOTECONTROLLER_ENCODED_COMMAND_MIN_SIZE 2 // Smallest encoded command: RemoteController-Protocol v2 command without throttle (1 byte instruction, 1 byte throttle encoding)
+#endif
+
 #if !defined(REMOTECONTROLLER_CUSTOM_CONFIG)
 
 #define REMOTECONTROLLER_INCOMING_BUFFER_SIZE 32 // bytes
 #define REMOTECONTROLLER_OUTGOING_BUFFER_SIZE 32 // bytes
 #define REMOTECONTROLLER_COMMAND_QUEUE_SIZE 50 // bytes (Allows for 10 commands to be in the queue at once)
 #define REMOTECONTROLLER_ENCODED_COMMAND_SIZE 5 // 1 byte intruction and 4 byte float throttle as specified in RemoteController-Protocol
-#define REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH (REMOTECONTROLLER_INCOMING_BUFFER_SIZE - 2) / REMOTECONTROLLER_ENCODED_COMMAND_SIZE
+#define REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH ((REMOTECONTROLLER_INCOMING_BUFFER_SIZE - 2) / REMOTECONTROLLER_ENCODED_COMMAND_SIZE) // commands, one v1 packet (larger packets of RemoteControllerT are passed to the callback in several calls)
+
+#define REMOTECONTROLLER_IDENTIFIER_COMMAND 0xEEAF // RemoteController Identifier 2 bytes (RemoteController-Protocol v1)
+
+#endif
+
+// Settings added after REMOTECONTROLLER_CUSTOM_CONFIG: each one can be defined on its own (e.g. in the build flags), the others keep their defaults
+
+#ifndef REMOTECONTROLLER_COMMAND_QUEUE_LENGTH
+#define REMOTECONTROLLER_COMMAND_QUEUE_LENGTH (REMOTECONTROLLER_COMMAND_QUEUE_SIZE / REMOTECONTROLLER_ENCODED_COMMAND_SIZE) // commands
+#endif
+#ifndef REMOTECONTROLLER_OUTGOING_BATCH_SIZE
+#define REMOTECONTROLLER_OUTGOING_BATCH_SIZE 3 // packets packed at once for Connection::writeBatch() (the NRF24L01 TX FIFO holds 3 packets), each takes REMOTECONTROLLER_OUTGOING_BUFFER_SIZE bytes
+#endif
+#ifndef REMOTECONTROLLER_MAX_BATCH_SIZE
+#define REMOTECONTROLLER_MAX_BATCH_SIZE 8 // Upper bound for the packets per batch of any RemoteControllerT configuration (sizes per batch bookkeeping on the stack)
+#endif
+#ifndef REMOTECONTROLLER_RECEIVE_RING_LENGTH
+#define REMOTECONTROLLER_RECEIVE_RING_LENGTH 8 // packets buffered by InterruptConnection between interrupt and RemoteController::run(), power of two (max. 128), each takes REMOTECONTROLLER_INCOMING_BUFFER_SIZE bytes
+#endif
+#ifndef REMOTECONTROLLER_COMMAND_HANDLERS
+#define REMOTECONTROLLER_COMMAND_HANDLERS 8 // commands a handler can be registered for with RemoteController::setCommandHandler() (max. 255)
+#endif
+#ifndef REMOTECONTROLLER_POLICY_COMMANDS
+#define REMOTECONTROLLER_POLICY_COMMANDS 8 // commands that can have another QueuePolicy than the one set for all commands (RemoteController::setQueuePolicy())
+#endif
+#ifndef REMOTECONTROLLER_SEQUENCE_WINDOW
+#define REMOTECONTROLLER_SEQUENCE_WINDOW 32 // sequence numbers the receiver remembers to drop duplicate command packets (max. 32)
+#endif
+#ifndef REMOTECONTROLLER_FRAGMENT_WINDOW
+#define REMOTECONTROLLER_FRAGMENT_WINDOW 8 // fragments that are sent without waiting for an acknowledgement (max. 32)
+#endif
+#ifndef REMOTECONTROLLER_FRAGMENT_TIMEOUT
+#define REMOTECONTROLLER_FRAGMENT_TIMEOUT 20000 // microseconds without acknowledgement until the unacknowledged fragments are sent again
+#endif
+#ifndef REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN
+#define REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN 2 // fragments a fragment in flight may be overtaken by, a fragment further behind the last received one is sent again without waiting for REMOTECONTROLLER_FRAGMENT_TIMEOUT
+#endif
+#ifndef REMOTECONTROLLER_MAX_TTL
+#define REMOTECONTROLLER_MAX_TTL 30000000UL // microseconds, longer times to live of RemoteController::sendCommand() are shortened (max. 33000000, the deadline is kept in 16-bit ticks of 1024 us). Call RemoteController::run() at least this often while commands with a time to live are queued.
+#endif
+#ifndef REMOTECONTROLLER_COMMAND_RING_LENGTH
+#define REMOTECONTROLLER_COMMAND_RING_LENGTH 32 // commands RemoteController::sendCommand() can hand to the pump thread between two pump cycles, power of two (ESP32/native only)
+#endif
+#ifndef REMOTECONTROLLER_PUMP_PERIOD
+#define REMOTECONTROLLER_PUMP_PERIOD 1000 // microseconds between two RemoteController::run() calls of the pump thread (ESP32/native only)
+#endif
+#ifndef REMOTECONTROLLER_FEATURES
+#define REMOTECONTROLLER_FEATURES 0 // RemoteControllerTypes::Feature flags of RemoteControllerDefaultConfig (the RemoteController typedef), e.g. RemoteControllerTypes::LargePayloads
+#endif
+#ifndef REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS
+#define REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS 8 // power of two buckets of the run() and write time histograms: <16us, <32us, ... the last bucket counts everything above
+#endif
 
-#define REMOTECONTROLLER_IDENTIFIER_COMMAND 0xEEAF // RemoteController Identifier 2 bytes
+// RemoteController-Protocol identifiers and header sizes, both RemoteControllers have to use the same ones
 
+#ifndef REMOTECONTROLLER_IDENTIFIER_COMMAND_V2
+#define REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 0xEEB0 // RemoteController Identifier 2 bytes (RemoteController-Protocol v2, compact throttle encoding)
+#endif
+#ifndef REMOTECONTROLLER_IDENTIFIER_COMMAND_SEQUENCED
+#define REMOTECONTROLLER_IDENTIFIER_COMMAND_SEQUENCED 0xEEB1 // RemoteController Identifier 2 bytes (v1 commands after a sequence number byte)
+#endif
+#ifndef REMOTECONTROLLER_IDENTIFIER_COMMAND_V2_SEQUENCED
+#define REMOTECONTROLLER_IDENTIFIER_COMMAND_V2_SEQUENCED 0xEEB2 // RemoteController Identifier 2 bytes (v2 commands after a sequence number byte)
+#endif
+#ifndef REMOTECONTROLLER_IDENTIFIER_FRAGMENT
+#define REMOTECONTROLLER_IDENTIFIER_FRAGMENT 0xEEC0 // RemoteController Identifier 2 bytes (fragment of a payload larger than one packet)
+#endif
+#ifndef REMOTECONTROLLER_IDENTIFIER_FRAGMENT_ACK
+#define REMOTECONTROLLER_IDENTIFIER_FRAGMENT_ACK 0xEEC1 // RemoteController Identifier 2 bytes (selective acknowledgement of received fragments)
+#endif
+#ifndef REMOTECONTROLLER_FRAGMENT_HEADER_SIZE
+#define REMOTECONTROLLER_FRAGMENT_HEADER_SIZE 6 // bytes: identifier, transfer id, fragment index, fragment count, fragment size
 #endif
 
+// Define REMOTECONTROLLER_STATISTICS (e.g. -D REMOTECONTROLLER_STATISTICS in the build flags) to collect RemoteController::getStatistics().
+// Costs sizeof(RemoteController::Statistics) bytes of RAM and two rcmicros() calls per run() and write, without it the statistics compile away.
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,1756 @@
+#ifndef REMOTECONTROLLER_IMPL_H_
+#define REMOTECONTROLLER_IMPL_H_
+
+// Implementation of RemoteControllerBaseT, included by RemoteController.h. A header because RemoteControllerBaseT is a template over the Connection type.
+
+#include "RemoteController.h"
+#include <string.h>
+
+// Statement only compiled if the statistics are enabled
+#ifdef REMOTECONTROLLER_STATISTICS
+#define RC_STATISTICS(statement) statement
+#else
+#define RC_STATISTICS(statement)
+#endif
+
+template <class ConnectionType>
+RemoteControllerBaseT<ConnectionType>::RemoteControllerBaseT(ConnectionType &connection, const Storage &storage)
+	: connection(connection), incomingBuffer(storage.incomingBuffer), outgoingBuffer(storage.outgoingBuffer), commandQueue(storage.commandQueue),
+	  packageSize(storage.packageSize), batchSize(storage.batchSize), commandQueueCapacity(storage.commandQueueCapacity),
+	  sequenceState(storage.sequenceState), largePayload(storage.largePayload)
+#ifdef RC_ARCH_USE_THREADS
+	  ,
+	  pumpState(storage.pumpState)
+#endif
+{
+}
+
+template <class ConnectionType>
+RemoteControllerBaseT<ConnectionType>::~RemoteControllerBaseT()
+{
+#ifdef RC_ARCH_USE_THREADS
+	stopPump(); // A running std::thread must not be destroyed
+#endif
+}
+
+template <class ConnectionType>
+#if defined(RC_ARCH_USE_FUNCTIONAL)
+bool RemoteControllerBaseT<ConnectionType>::begin(std::function<void(const uint8_t commands[], const float throttles[], size_t length)> cmdClb)
+{
+	commandCallbackFunction = cmdClb;
+
+	return m_begin();
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::begin(std::function<void(const uint8_t commands[], const float throttles[], size_t length)> cmdClb, std::function<void(const void *buffer, size_t length)> pldClb)
+{
+	// Assign callbacks
+	commandCallbackFunction = cmdClb;
+	payloadCallbackFunction = pldClb;
+
+	return m_begin();
+}
+#else
+bool RemoteControllerBaseT<ConnectionType>::begin(void (*cmdClb)(const uint8_t commands[], const float throttles[], size_t length))
+{
+	commandCallbackFunction = cmdClb;
+	payloadCallbackFunction = NULL;
+
+	return m_begin();
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::begin(void (*cmdClb)(const uint8_t commands[], const float throttles[], size_t length), void (*pldClb)(const void *buffer, size_t length))
+{
+	commandCallbackFunction = cmdClb;
+	payloadCallbackFunction = pldClb;
+
+	return m_begin();
+}
+
+#endif
+
+template <class ConnectionType>
+#if defined(RC_ARCH_USE_FUNCTIONAL)
+void RemoteControllerBaseT<ConnectionType>::setCommandViewCallback(std::function<void(const CommandView &commands)> viewClb)
+#else
+void RemoteControllerBaseT<ConnectionType>::setCommandViewCallback(void (*viewClb)(const CommandView &commands))
+#endif
+{
+	commandViewCallbackFunction = viewClb;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::setCommandHandler(uint8_t command, CommandHandler handler)
+{
+	int index = findCommandHandler(command);
+	if (!handler)
+	{
+		if (index < 0)
+		{
+			return true;
+		}
+		// Move the last handler into the freed entry
+		handlerCount--;
+		handlers[index] = handlers[handlerCount];
+		handlerCommands[index] = handlerCommands[handlerCount];
+		handlers[handlerCount] = nullptr;
+#ifdef RC_ARCH_FLAT_COMMAND_HANDLER_TABLE
+		handlerSlots[handlerCommands[index]] = index + 1;
+		handlerSlots[command] = 0;
+#endif
+		return true;
+	}
+
+	if (index < 0)
+	{
+		if (handlerCount == REMOTECONTROLLER_COMMAND_HANDLERS)
+		{
+			return false;
+		}
+		index = handlerCount++;
+		handlerCommands[index] = command;
+#ifdef RC_ARCH_FLAT_COMMAND_HANDLER_TABLE
+		handlerSlots[command] = index + 1;
+#endif
+	}
+	handlers[index] = handler;
+	return true;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::clearCommandHandlers()
+{
+	while (handlerCount)
+	{
+		handlerCount--;
+		handlers[handlerCount] = nullptr;
+#ifdef RC_ARCH_FLAT_COMMAND_HANDLER_TABLE
+		handlerSlots[handlerCommands[handlerCount]] = 0;
+#endif
+	}
+}
+
+template <class ConnectionType>
+inline int RemoteControllerBaseT<ConnectionType>::findCommandHandler(uint8_t command) const
+{
+#ifdef RC_ARCH_FLAT_COMMAND_HANDLER_TABLE
+	return (int)handlerSlots[command] - 1;
+#else
+	// Only a few commands have a handler, searching them is cheaper than 256 bytes of RAM for a flat table
+	for (uint8_t i = 0; i < handlerCount; i++)
+	{
+		if (handlerCommands[i] == command)
+		{
+			return i;
+		}
+	}
+	return -1;
+#endif
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::m_begin()
+{
+	// Initialize connection to remote
+	if (!connection.begin())
+	{
+		// Failed to start the connection
+		error = CannotBeginConnection;
+		return false;
+	}
+	// The other RemoteController may have been reset as well, start new duplicate windows on both ends
+	if (sequenceState)
+	{
+		sequenceState->outgoingSequenceSync = true;
+	}
+	incomingSequenceValid = false;
+	pendingWrite = NoWrite; // A packet that was in flight before is not known to be transmitted, its commands stay queued
+
+	error = NoError;
+	return true;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::end()
+{
+	// At the moment no RemoteController specific dynamically allocated memory to free...
+	connection.end();
+}
+
+template <class ConnectionType>
+uint8_t RemoteControllerBaseT<ConnectionType>::getErrorCode()
+{
+	return error;
+}
+
+template <class ConnectionType>
+_String RemoteControllerBaseT<ConnectionType>::getErrorDescription()
+{
+	switch (error)
+	{
+	case NoError:
+		return "No Error, RC is running fine";
+	case CannotBeginConnection:
+		return "Remote Controller begin failed because it cannot begin its connection, probably because it failes to connect";
+	case FailedToTransmitCommands:
+		return "The RemoteController failed to transmit the commands because the Connection didn't succesfully transmit the data";
+	case CommandQueueFull:
+		return "The Command Queue is full. Too many commands where added and not transmitted. CAUSES UNDEFINED BEHAVIOR until a connection is established and commands are succesfully transmitted!";
+	case FailedToTransmitCustomPayload:
+		return "The Connection::write() failed to transmit the payload (No ack received)";
+	case ReceivedCorruptPacket:
+		return "The packet that was received and triggered Connection::available() is corrupt and cannot be read!";
+	case ReceivedPayloadTooBig:
+		return "A payload sent with RemoteController::sendLargePayload() does not fit into the buffer set with RemoteController::setLargePayloadBuffer()";
+	case TransferInProgress:
+		return "RemoteController::sendLargePayload() was called while the previous payload is still being transmitted";
+	case WriteInProgress:
+		return "RemoteController::sendPayload() was called while the Connection is still transmitting the previous packet";
+	default:
+		return "Unknown Error";
+	}
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::run()
+{
+#ifdef REMOTECONTROLLER_STATISTICS
+	const uint32_t start = rcmicros();
+	const bool success = m_run();
+	const uint8_t bucket = Statistics::bucket(rcmicros() - start);
+	if (statistics.runMicros[bucket] != UINT16_MAX)
+	{
+		statistics.runMicros[bucket]++;
+	}
+	return success;
+#else
+	return m_run();
+#endif
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::m_run()
+{
+	// Check the packet in flight (Connection::AsyncWrite), the next packet is only started once it is finished
+	if (!pollPendingWrite())
+	{
+		return false; // Like a failed blocking write, the commands that were not transmitted stay queued
+	}
+	// Transmit the queued commands to the receiver
+	if (commandQueueLength != 0)
+	{
+		if (transmitCommands())
+		{
+			// Check if the command queue was overfilled...
+			if (error == CommandQueueFull)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false; // Return error message, the commands that were not transmitted stay queued for the next run() call
+		}
+	}
+	// Transmit the next fragments of a large payload
+	if (largePayload && largePayload->fragmentedPayload && !transmitFragments())
+	{
+		return false;
+	}
+	// Check and process incomming commands and payloads
+	bool success = receive();
+	if (largePayload && largePayload->fragmentAckPending)
+	{
+		transmitFragmentAck(); // Acknowledge the fragments received with this run() call
+	}
+	if (!success)
+	{
+		return false;
+	}
+
+	error = NoError;
+	return true;
+}
+
+#ifdef RC_ARCH_USE_THREADS
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::startPump(uint32_t periodMicros)
+{
+	if (!pumpState || pumpState->running)
+	{
+		return false;
+	}
+	if (pumpState->thread.joinable())
+	{
+		pumpState->thread.join(); // The pump was stopped from one of its callbacks
+	}
+	pumpState->period = periodMicros;
+	pumpState->ringOpen = true;
+	pumpState->running = true;
+	pumpState->thread = std::thread(&RemoteControllerBaseT::pump, this);
+	return true;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::stopPump()
+{
+	if (!pumpState)
+	{
+		return;
+	}
+	{
+		// Under the lock, so the pump cannot miss the wakeup between checking running and going to sleep
+		std::lock_guard<std::mutex> lock(pumpState->mutex);
+		pumpState->running = false;
+	}
+	pumpState->wakeup.notify_one();
+	if (!pumpState->thread.joinable() || pumpState->thread.get_id() == std::this_thread::get_id())
+	{
+		return; // Not running, or called from a callback: the pump ends after this run() call and is joined later
+	}
+	pumpState->thread.join(); // The pump drains the ring before it ends
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::isPumpRunning()
+{
+	return pumpState && (pumpState->ringOpen || pumpState->draining); // In this order: the pump sets draining before it closes the ring
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::pump()
+{
+	PumpState &state = *pumpState;
+	std::unique_lock<std::mutex> lock(state.mutex);
+	while (state.running)
+	{
+		lock.unlock();
+		drainCommandRing();
+		run();
+		lock.lock();
+		// Sleep until the next period, a Priority::High command or stopPump() (a wakeup that is missed while run() is busy delays the command by one period at most)
+		state.wakeup.wait_for(lock, std::chrono::microseconds(state.period), [&state]
+							  { return !state.running || state.wakeupPending.exchange(false); });
+	}
+	// Close the ring, then wait for the producers that still saw it open: their commands are drained here, not left behind in the ring
+	state.draining = true;
+	state.ringOpen = false;
+	while (state.ringProducers != 0)
+	{
+		std::this_thread::yield();
+	}
+	drainCommandRing();
+	state.draining = false;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::drainCommandRing()
+{
+	QueuedCommand queuedCommand;
+	while (pumpState->commandRing.pop(queuedCommand))
+	{
+		addToCommandQueue(queuedCommand);
+	}
+	const uint32_t drops = pumpState->commandRing.takeDrops();
+	if (drops)
+	{
+		RC_STATISTICS(statistics.commandsDropped += drops);
+		error = CommandQueueFull;
+	}
+}
+#endif
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::receive()
+{
+	if (commandCallbackFunction && !handlerCount)
+	{
+		return receiveIntoArrays(); // Only the array based command callback needs the arrays
+	}
+	return receivePackets(nullptr);
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::receiveIntoArrays()
+{
+	CommandArrays arrays; // In its own frame, the other callbacks do not pay for it
+	arrays.length = 0;
+	const bool success = receivePackets(&arrays);
+	flushCommandArrays(arrays); // Commands aggregated over multiple packets
+	return success;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::receivePackets(CommandArrays *arrays)
+{
+	const uint32_t start = receiveBudgetMicros ? rcmicros() : 0;
+	size_t packets = 0;
+	bool success = true;
+	while (packets < receiveBudgetPackets && connection.available())
+	{
+		packets++;
+		if (!receivePacket(arrays))
+		{
+			success = false;
+			break;
+		}
+		if (receiveBudgetMicros && (uint32_t)(rcmicros() - start) >= receiveBudgetMicros)
+		{
+			break; // Time budget used up, the remaining packets are handled with the next run() call
+		}
+	}
+	return success;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::receivePacket(CommandArrays *arrays)
+{
+	size_t payloadSize = rcmin(connection.getPayloadSize(), packageSize);
+	// Check if the packet is corrupt
+	if (payloadSize < 1)
+	{
+		RC_STATISTICS(statistics.corruptPackets++);
+		error = ReceivedCorruptPacket;
+		return false;
+	}
+	// Read the valid packet into the buffer
+	connection.read(incomingBuffer, payloadSize);
+	RC_STATISTICS(statistics.packetsReceived++);
+	RC_STATISTICS(statistics.bytesReceived += payloadSize);
+	// Nothing of the packet (not even the identifier) is trusted before the checksum was verified
+	if (frameCheck != NoFrameCheck && !checkFrame(incomingBuffer, payloadSize))
+	{
+		RC_STATISTICS(statistics.corruptPackets++);
+		error = ReceivedCorruptPacket;
+		return false;
+	}
+	uint8_t *pStart = incomingBuffer;
+
+	// Check the first two bytes of the buffer for RemoteController Command identifier
+	uint16_t identifier = *pStart * 256 + *(pStart + 1);
+	size_t headerSize = 2;
+	if (payloadSize >= 3 && (identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND_SEQUENCED || identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND_V2_SEQUENCED))
+	{
+		// The sequence number byte follows the identifier, the commands are encoded like in unsequenced packets
+		identifier = identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND_SEQUENCED ? REMOTECONTROLLER_IDENTIFIER_COMMAND : REMOTECONTROLLER_IDENTIFIER_COMMAND_V2;
+		headerSize = 3;
+	}
+	if (payloadSize >= 2 && (identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND || identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND_V2))
+	{
+		// Count the commands, nothing is decoded or copied yet
+		size_t index = headerSize; // Skip the identifier (and sequence number)
+		size_t length = 0;
+		while (index < payloadSize)
+		{
+			// v2 commands need the instruction and the throttle encoding byte to tell their size
+			const size_t size = identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND || payloadSize - index >= 2 ? RemoteControllerTypes::encodedCommandSize(incomingBuffer + index, identifier) : 0;
+			if (size == 0 || size > payloadSize - index)
+			{
+				break; // Not enough bytes left for another command, or an unknown throttle encoding
+			}
+			index += size;
+			length++;
+		}
+		// v1 packets may be padded, v2 packets have to be decoded completely
+		if (identifier == REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 && index != payloadSize)
+		{
+			RC_STATISTICS(statistics.corruptPackets++);
+			error = ReceivedCorruptPacket;
+			return false;
+		}
+		// Commands successfully parsed
+		if (headerSize == 3 && !acceptSequence(incomingBuffer[2]))
+		{
+			RC_STATISTICS(statistics.duplicatePackets++);
+			return true; // Already received, e.g. the acknowledgement was lost and the packet was sent again
+		}
+
+		deliverCommands(CommandView(incomingBuffer + headerSize, length, identifier), arrays);
+	}
+	else if (payloadSize >= 2 && identifier == REMOTECONTROLLER_IDENTIFIER_FRAGMENT)
+	{
+		return receiveFragment(incomingBuffer, payloadSize);
+	}
+	else if (payloadSize >= 2 && identifier == REMOTECONTROLLER_IDENTIFIER_FRAGMENT_ACK)
+	{
+		receiveFragmentAck(incomingBuffer, payloadSize);
+	}
+	else
+	{
+		// Non Command type payload received...
+		if (payloadCallbackFunction)
+		{
+			payloadCallbackFunction(incomingBuffer, payloadSize);
+		}
+	}
+	return true;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::deliverCommands(const CommandView &view, CommandArrays *arrays)
+{
+	if (commandViewCallbackFunction)
+	{
+		commandViewCallbackFunction(view);
+	}
+	if (handlerCount)
+	{
+		// Handler table: every command is dispatched while it is decoded, commands without a handler are dropped
+		for (CommandView::Iterator it = view.begin(); it != view.end(); ++it)
+		{
+			Command command = *it;
+			int index = findCommandHandler(command.command);
+			if (index >= 0)
+			{
+				handlers[index](command.throttle);
+			}
+		}
+		return;
+	}
+	if (!commandCallbackFunction || !arrays)
+	{
+		return; // (No arrays: the callback was set by a callback during this run() call, it gets the next packets)
+	}
+
+	// Adapter for the array based command callback
+	if (arrays->length + view.size() > REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH)
+	{
+		flushCommandArrays(*arrays); // Deliver the aggregated commands first, this packet does not fit into the arrays anymore
+	}
+	for (CommandView::Iterator it = view.begin(); it != view.end(); ++it)
+	{
+		if (arrays->length == REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH)
+		{
+			flushCommandArrays(*arrays); // Packets with more commands than a v1 packet of REMOTECONTROLLER_INCOMING_BUFFER_SIZE bytes are delivered in multiple calls
+		}
+		Command command = *it;
+		arrays->commands[arrays->length] = command.command;
+		arrays->throttles[arrays->length] = command.throttle;
+		arrays->length++;
+	}
+	if (!aggregateCommands)
+	{
+		flushCommandArrays(*arrays);
+	}
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::flushCommandArrays(CommandArrays &arrays)
+{
+	if (arrays.length && commandCallbackFunction)
+	{
+		commandCallbackFunction(arrays.commands, arrays.throttles, arrays.length);
+	}
+	arrays.length = 0;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setReceiveBudget(size_t maxPackets, uint32_t maxMicros)
+{
+	receiveBudgetPackets = rcmax(maxPackets, (size_t)1);
+	receiveBudgetMicros = maxMicros;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setAggregateCommands(bool aggregate)
+{
+	aggregateCommands = aggregate;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setUseAckPayloads(bool enable)
+{
+	useAckPayloads = enable;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::sendCommand(uint8_t command, Priority priority, uint32_t ttlMicros)
+{
+	sendCommand(command, 0, priority, ttlMicros);
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::sendCommand(uint8_t command, float throttle, Priority priority, uint32_t ttlMicros)
+{
+#ifdef RC_ARCH_USE_THREADS
+	if (pumpState && (pumpState->ringOpen || pumpState->draining))
+	{
+		// Any thread: only the pump thread touches the command queue and the Connection, it takes the command from the ring.
+		// Announced before checking ringOpen again, so a stopping pump waits for this push before its last drain.
+		pumpState->ringProducers++;
+		if (pumpState->ringOpen)
+		{
+			if (pumpState->commandRing.push(makeQueuedCommand(command, throttle, priority, ttlMicros)) && priority == High)
+			{
+				pumpState->wakeupPending.store(true, std::memory_order_release);
+				pumpState->wakeup.notify_one();
+			}
+			pumpState->ringProducers--;
+			return;
+		}
+		pumpState->ringProducers--;
+		while (pumpState->draining)
+		{
+			std::this_thread::yield(); // The pump stopped, the command queue is used below once its last drain is done
+		}
+	}
+#endif
+	if (priority != High)
+	{
+		addToCommandQueue(makeQueuedCommand(command, throttle, priority, ttlMicros));
+	}
+	else if (sendsSequenceNumbers() || asyncWrites())
+	{
+		// A failed packet has to keep its sequence number, only queued commands are sent again in the same packet.
+		// Asynchronous writes are not waited for, the command is sent in front of the queue as soon as the Connection is free.
+		addToCommandQueue(makeQueuedCommand(command, throttle, priority, ttlMicros));
+		transmitCommands();
+	}
+	else if (!transmitCommand(command, throttle))
+	{
+		/// - Failed to transmit log error message and add to commandqueue (in front of the other commands) to transmit the command later (unless it may be sent at most once)
+		if (getDeliveryMode(command) == AtLeastOnce)
+		{
+			addToCommandQueue(makeQueuedCommand(command, throttle, priority, ttlMicros));
+		}
+		error = FailedToTransmitCommands;
+	}
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::QueuedCommand RemoteControllerBaseT<ConnectionType>::makeQueuedCommand(uint8_t command, float throttle, Priority priority, uint32_t ttlMicros)
+{
+	QueuedCommand queuedCommand;
+	queuedCommand.command = command;
+	queuedCommand.priority = priority;
+	queuedCommand.expires = ttlMicros != 0;
+	queuedCommand.throttle = throttle;
+	queuedCommand.deadline = 0;
+	if (ttlMicros)
+	{
+		// The time to live starts with the sendCommand() call, also if the pump queues the command later. Rounded up to the next tick, the command is never dropped early.
+		ttlMicros = rcmin(ttlMicros, (uint32_t)REMOTECONTROLLER_MAX_TTL);
+		queuedCommand.deadline = (uint16_t)((rcmicros() + ttlMicros + 1023) >> 10);
+	}
+	return queuedCommand;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::addToCommandQueue(QueuedCommand queuedCommand)
+{
+	size_t position = commandQueueLength;
+	if (getQueuePolicy(queuedCommand.command) == Coalesce)
+	{
+		// Latest value wins: take the place of the command that is already waiting in the queue (commands of failed packets are sent again unchanged)
+		for (size_t i = lockedCommands(); i < commandQueueLength; i++)
+		{
+			if (queuedCommandAt(i).command == queuedCommand.command)
+			{
+				if (priorityRank(queuedCommandAt(i).priority) > priorityRank(queuedCommand.priority))
+				{
+					queuedCommand.priority = queuedCommandAt(i).priority;
+				}
+				position = i;
+				break;
+			}
+		}
+	}
+
+	if (position == commandQueueLength)
+	{
+		// Check if the command queue is full...
+		if (commandQueueLength >= commandQueueCapacity)
+		{
+			RC_STATISTICS(statistics.commandsDropped++);
+			error = CommandQueueFull;
+			return;
+		}
+		commandQueueLength++;
+		RC_STATISTICS(statistics.commandQueueHighWatermark = rcmax(statistics.commandQueueHighWatermark, (uint16_t)commandQueueLength));
+	}
+
+	// The queue is sorted by priority (FIFO within a priority), the commands of failed packets and of the packet in flight stay in front
+	const size_t locked = lockedCommands();
+	const uint8_t rank = priorityRank(queuedCommand.priority);
+	while (position > locked && priorityRank(queuedCommandAt(position - 1).priority) < rank)
+	{
+		queuedCommandAt(position) = queuedCommandAt(position - 1);
+		position--;
+	}
+	queuedCommandAt(position) = queuedCommand;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::dropExpiredCommands()
+{
+	// Most commands have no time to live, the clock is only read if needed
+	size_t first = 0;
+	while (first < commandQueueLength && !queuedCommandAt(first).expires)
+	{
+		first++;
+	}
+	if (first == commandQueueLength)
+	{
+		return;
+	}
+
+	const uint16_t now = (uint16_t)(rcmicros() >> 10); // Ticks of the deadlines
+	const size_t pinnedPackets = sequenceState ? sequenceState->pinnedPackets : 0;
+	size_t kept = 0;
+	size_t index = 0;
+	// Commands of pinned packets are dropped as well, the packet is sent again without them
+	for (size_t packet = 0; packet <= pinnedPackets; packet++)
+	{
+		const size_t end = packet < pinnedPackets ? index + sequenceState->pinnedCommands[packet] : commandQueueLength;
+		size_t commandsKept = 0;
+		for (; index < end; index++)
+		{
+			const QueuedCommand &queuedCommand = queuedCommandAt(index);
+			if (queuedCommand.expires && (int16_t)(uint16_t)(now - queuedCommand.deadline) >= 0)
+			{
+				continue;
+			}
+			if (kept != index)
+			{
+				queuedCommandAt(kept) = queuedCommand;
+			}
+			kept++;
+			commandsKept++;
+		}
+		if (packet < pinnedPackets)
+		{
+			sequenceState->pinnedCommands[packet] = commandsKept;
+		}
+	}
+	RC_STATISTICS(statistics.commandsExpired += commandQueueLength - kept);
+	commandQueueLength = kept;
+	if (!pinnedPackets)
+	{
+		return;
+	}
+
+	// Pinned packets without commands are not sent anymore
+	SequenceState &state = *sequenceState;
+	size_t packets = 0;
+	for (size_t packet = 0; packet < pinnedPackets; packet++)
+	{
+		if (state.pinnedCommands[packet])
+		{
+			state.pinnedSequences[packets] = state.pinnedSequences[packet];
+			state.pinnedCommands[packets] = state.pinnedCommands[packet];
+			packets++;
+		}
+	}
+	state.pinnedPackets = packets;
+	unpinPackets(0); // Recounts the pinned commands
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::QueuedCommand &RemoteControllerBaseT<ConnectionType>::queuedCommandAt(size_t index)
+{
+	return commandQueue[(commandQueueHead + index) % commandQueueCapacity];
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::setQueuePolicy(uint8_t command, QueuePolicy policy)
+{
+	return coalescedCommands.set(command, policy == Coalesce);
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setQueuePolicy(QueuePolicy policy)
+{
+	coalescedCommands.setAll(policy == Coalesce);
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::QueuePolicy RemoteControllerBaseT<ConnectionType>::getQueuePolicy(uint8_t command)
+{
+	return coalescedCommands.contains(command) ? Coalesce : Append;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::setDeliveryMode(uint8_t command, DeliveryMode mode)
+{
+	return sequenceState && sequenceState->atMostOnceCommands.set(command, mode == AtMostOnce);
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setDeliveryMode(DeliveryMode mode)
+{
+	if (sequenceState)
+	{
+		sequenceState->atMostOnceCommands.setAll(mode == AtMostOnce);
+	}
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::DeliveryMode RemoteControllerBaseT<ConnectionType>::getDeliveryMode(uint8_t command)
+{
+	return sequenceState && sequenceState->atMostOnceCommands.contains(command) ? AtMostOnce : AtLeastOnce;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setUseSequenceNumbers(bool enable)
+{
+	if (sequenceState)
+	{
+		sequenceState->useSequenceNumbers = enable;
+	}
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setProtocolVersion(ProtocolVersion version)
+{
+	protocolVersion = version;
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::ProtocolVersion RemoteControllerBaseT<ConnectionType>::getProtocolVersion()
+{
+	return protocolVersion;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setFrameCheck(FrameCheck check)
+{
+	frameCheck = check;
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::FrameCheck RemoteControllerBaseT<ConnectionType>::getFrameCheck()
+{
+	return frameCheck;
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::frameCheckSize()
+{
+	return frameCheck == Crc16 ? 2 : frameCheck == Crc8 ? 1 : 0;
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::appendFrameCheck(uint8_t *packet, size_t length)
+{
+	// The packet was packed with frameCheckSize() bytes left free
+	if (frameCheck == Crc8)
+	{
+		packet[length] = Crc::crc8(packet, length);
+	}
+	else if (frameCheck == Crc16)
+	{
+		const uint16_t crc = Crc::crc16(packet, length);
+		packet[length] = (uint8_t)(crc >> 8);
+		packet[length + 1] = (uint8_t)crc;
+	}
+	return length + frameCheckSize();
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::checkFrame(const uint8_t *packet, size_t &length)
+{
+	const size_t size = frameCheckSize();
+	if (length <= size)
+	{
+		return false; // Nothing but the checksum (or not even that)
+	}
+	length -= size;
+	if (frameCheck == Crc8)
+	{
+		return packet[length] == Crc::crc8(packet, length);
+	}
+	return (uint16_t)(packet[length] << 8 | packet[length + 1]) == Crc::crc16(packet, length);
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::ThrottleEncoding RemoteControllerBaseT<ConnectionType>::throttleEncoding(float throttle)
+{
+	if (throttle == 0)
+		return ThrottleNone;
+	if (throttle >= 1 && throttle <= 65535 && throttle == (float)(uint16_t)throttle)
+		return throttle <= 255 ? ThrottleUInt8 : ThrottleUInt16;
+	if (throttle > 0 && throttle < 1)
+		return ThrottleUnit16;
+	return ThrottleFloat; // Negative, fractional above 1.0, too big or NaN
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::encodedCommandSize(float throttle)
+{
+	if (protocolVersion == ProtocolV1)
+		return REMOTECONTROLLER_ENCODED_COMMAND_SIZE;
+
+	switch (throttleEncoding(throttle))
+	{
+	case ThrottleNone:
+		return 2;
+	case ThrottleUInt8:
+		return 3;
+	case ThrottleUInt16:
+	case ThrottleUnit16:
+		return 4;
+	default:
+		return 6;
+	}
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::encodeCommand(uint8_t command, float throttle, uint8_t *buffer)
+{
+	*buffer++ = command;
+	if (protocolVersion == ProtocolV1)
+	{
+		memcpy(buffer, &throttle, sizeof throttle);
+		return REMOTECONTROLLER_ENCODED_COMMAND_SIZE;
+	}
+
+	ThrottleEncoding encoding = throttleEncoding(throttle);
+	*buffer++ = encoding;
+	uint16_t value;
+	switch (encoding)
+	{
+	case ThrottleNone:
+		return 2;
+	case ThrottleUInt8:
+		*buffer = (uint8_t)throttle;
+		return 3;
+	case ThrottleUInt16:
+	case ThrottleUnit16:
+		value = encoding == ThrottleUInt16 ? (uint16_t)throttle : (uint16_t)(throttle * 65535.0f + 0.5f);
+		*buffer++ = (uint8_t)value;
+		*buffer = (uint8_t)(value >> 8);
+		return 4;
+	default:
+		memcpy(buffer, &throttle, sizeof throttle);
+		return 6;
+	}
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::sendPayload(const void *buffer, size_t length)
+{
+	const size_t checkSize = frameCheckSize();
+	if (length + checkSize > connection.getMaxPackageSize())
+	{
+		error = CustomPayloadTooBig;
+		return false;
+	}
+	const bool async = asyncWrites();
+	if (async && pendingWrite != NoWrite)
+	{
+		error = WriteInProgress;
+		return false;
+	}
+	if (async || checkSize)
+	{
+		// Copied: the packet has to stay valid while it is in flight and gets the checksum appended
+		if (length + checkSize > packageSize)
+		{
+			error = CustomPayloadTooBig; // Does not fit into the outgoing buffer
+			return false;
+		}
+		memcpy(outgoingBuffer, buffer, length);
+		buffer = outgoingBuffer;
+		length = appendFrameCheck(outgoingBuffer, length);
+	}
+	if (!(async ? startPacket(PayloadWrite, buffer, length) : writePacket(buffer, length)))
+	{
+		error = FailedToTransmitCustomPayload;
+		return false;
+	}
+	return true;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::sendLargePayload(const void *buffer, size_t length)
+{
+	if (!largePayload)
+	{
+		error = CustomPayloadTooBig; // Without Feature::LargePayloads every payload has to fit into one packet
+		return false;
+	}
+	LargePayloadState &state = *largePayload;
+	if (state.fragmentedPayload)
+	{
+		error = TransferInProgress;
+		return false;
+	}
+	const size_t maxPackageSize = rcmin(packageSize, connection.getMaxPackageSize()) - frameCheckSize();
+	const size_t size = maxPackageSize > REMOTECONTROLLER_FRAGMENT_HEADER_SIZE ? rcmin(maxPackageSize - REMOTECONTROLLER_FRAGMENT_HEADER_SIZE, (size_t)255) : 0;
+	if (length == 0 || size == 0 || (length + size - 1) / size > 255)
+	{
+		error = CustomPayloadTooBig;
+		return false;
+	}
+
+	// The fragments are transmitted with the following run() calls
+	state.fragmentedPayload = (const uint8_t *)buffer;
+	state.fragmentedPayloadLength = length;
+	state.transferId++;
+	state.fragmentSize = (uint8_t)size;
+	state.fragmentCount = (uint8_t)((length + size - 1) / size);
+	state.fragmentBase = 0;
+	state.fragmentsSentUpTo = 0;
+	state.fragmentsAcked = 0;
+	state.fragmentsInFlight = 0;
+	state.transferStart = state.lastFragmentProgress = rcmicros();
+	state.transferStats.bytes = length;
+	state.transferStats.micros = 0;
+	state.transferStats.fragments = 0;
+	state.transferStats.retransmissions = 0;
+	return true;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::isSendingLargePayload()
+{
+	return largePayload && largePayload->fragmentedPayload != nullptr;
+}
+
+template <class ConnectionType>
+const RemoteControllerTypes::TransferStats &RemoteControllerBaseT<ConnectionType>::getTransferStats()
+{
+	static const TransferStats noTransfer = {}; // Without Feature::LargePayloads
+	return largePayload ? largePayload->transferStats : noTransfer;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setLargePayloadBuffer(void *buffer, size_t size)
+{
+	if (!largePayload)
+	{
+		return; // Without Feature::LargePayloads fragments are always ignored
+	}
+	largePayload->reassemblyBuffer = (uint8_t *)buffer;
+	largePayload->reassemblyBufferSize = size;
+	largePayload->reassemblyActive = false;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::setFragmentTimeout(uint32_t micros)
+{
+	if (largePayload)
+	{
+		largePayload->fragmentTimeout = micros;
+	}
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::packFragment(uint8_t *packet, size_t index)
+{
+	LargePayloadState &state = *largePayload;
+	const size_t offset = index * state.fragmentSize;
+	const size_t length = rcmin(state.fragmentedPayloadLength - offset, (size_t)state.fragmentSize);
+	packet[0] = (uint8_t)(REMOTECONTROLLER_IDENTIFIER_FRAGMENT >> 8);
+	packet[1] = (uint8_t)REMOTECONTROLLER_IDENTIFIER_FRAGMENT;
+	packet[2] = state.transferId;
+	packet[3] = (uint8_t)index;
+	packet[4] = state.fragmentCount;
+	packet[5] = state.fragmentSize;
+	memcpy(packet + REMOTECONTROLLER_FRAGMENT_HEADER_SIZE, state.fragmentedPayload + offset, length);
+	return appendFrameCheck(packet, REMOTECONTROLLER_FRAGMENT_HEADER_SIZE + length);
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::transmitFragments()
+{
+	LargePayloadState &state = *largePayload;
+	const uint32_t now = rcmicros();
+	if (state.fragmentsInFlight && (uint32_t)(now - state.lastFragmentProgress) >= state.fragmentTimeout)
+	{
+		// No acknowledgement for too long, the fragments in flight are sent again (selectively acknowledged ones are skipped)
+		state.fragmentsInFlight = 0;
+	}
+	if (pendingWrite != NoWrite)
+	{
+		return true; // The Connection is still busy with the packet in flight
+	}
+
+	// Asynchronous writes send one fragment per run() call
+	const bool async = asyncWrites();
+	const size_t maxPackets = async ? 1 : maxPacketsPerWrite();
+	const size_t window = rcmin((size_t)REMOTECONTROLLER_FRAGMENT_WINDOW, (size_t)(state.fragmentCount - state.fragmentBase));
+	size_t position = 0; // Position in the window
+	while (true)
+	{
+		const void *packets[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t lengths[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t indices[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t packetCount = 0;
+
+		// Pack the next fragments of the window that are neither acknowledged nor in flight
+		for (; position < window && packetCount < maxPackets; position++)
+		{
+			if ((state.fragmentsAcked | state.fragmentsInFlight) & (1UL << position))
+			{
+				continue;
+			}
+			uint8_t *packet = outgoingBuffer + packetCount * packageSize;
+			packets[packetCount] = packet;
+			lengths[packetCount] = packFragment(packet, state.fragmentBase + position);
+			indices[packetCount] = state.fragmentBase + position;
+			packetCount++;
+		}
+		if (packetCount == 0)
+		{
+			return true; // The window is sent completely, wait for acknowledgements
+		}
+
+		if (async)
+		{
+			if (!startPacket(FragmentWrite, packets[0], lengths[0]))
+			{
+				fragmentsWritten(indices, 1, 0);
+				error = FailedToTransmitCustomPayload;
+				return false;
+			}
+			pendingTransferId = state.transferId;
+			pendingFragment = (uint8_t)indices[0];
+			return true;
+		}
+		size_t packetsSent = writePackets(packets, lengths, packetCount);
+		fragmentsWritten(indices, rcmin(packetsSent + 1, packetCount), packetsSent); // The packets behind a failed write were not attempted
+		if (packetsSent < packetCount)
+		{
+			error = FailedToTransmitCustomPayload;
+			return false; // The fragments that were not transmitted are sent with the next run() call
+		}
+	}
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::fragmentsWritten(const size_t indices[], size_t packetCount, size_t packetsSent)
+{
+	// indices[0 .. packetCount - 1] were attempted, the first packetsSent of them were transmitted
+	LargePayloadState &state = *largePayload;
+	for (size_t i = 0; i < packetCount; i++)
+	{
+		const size_t index = indices[i];
+		if (i < packetsSent && index >= state.fragmentBase)
+		{
+			state.fragmentsInFlight |= 1UL << (index - state.fragmentBase); // (An acknowledgement may have moved the window while an asynchronous write was in flight)
+		}
+		state.transferStats.fragments++;
+		if (index < state.fragmentsSentUpTo)
+		{
+			state.transferStats.retransmissions++;
+		}
+		else
+		{
+			state.fragmentsSentUpTo = index + 1;
+		}
+	}
+	if (packetsSent)
+	{
+		state.lastFragmentProgress = rcmicros();
+	}
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::receiveFragmentAck(const uint8_t *packet, size_t length)
+{
+	if (!largePayload)
+	{
+		return;
+	}
+	LargePayloadState &state = *largePayload;
+	// Acknowledgements of older transfers are ignored
+	if (!state.fragmentedPayload || length < 8 || packet[2] != state.transferId || packet[3] < state.fragmentBase || packet[3] > state.fragmentCount)
+	{
+		return;
+	}
+	const size_t shift = packet[3] - state.fragmentBase;
+	const uint32_t received = (uint32_t)packet[4] | ((uint32_t)packet[5] << 8) | ((uint32_t)packet[6] << 16) | ((uint32_t)packet[7] << 24);
+
+	// Move the window to the first fragment the other RemoteController is missing
+	state.fragmentsAcked = shift < 32 ? state.fragmentsAcked >> shift : 0;
+	state.fragmentsInFlight = shift < 32 ? state.fragmentsInFlight >> shift : 0;
+	state.fragmentsAcked |= received;
+	state.fragmentsInFlight &= ~state.fragmentsAcked;
+	if (received)
+	{
+		// Packets can overtake each other (e.g. a channel with jitter): fragments in flight more than REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN fragments before the last received one count as lost and are sent again right away, the closer ones after the fragment timeout
+		uint8_t highest = 31;
+		while (!(received & (1UL << highest)))
+		{
+			highest--;
+		}
+		if (highest > REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN)
+		{
+			state.fragmentsInFlight &= ~((1UL << (highest - REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN)) - 1);
+		}
+	}
+	state.fragmentBase = packet[3];
+	state.lastFragmentProgress = rcmicros();
+
+	if (state.fragmentBase == state.fragmentCount)
+	{
+		// Transfer complete
+		state.transferStats.micros = rcmax(state.lastFragmentProgress - state.transferStart, (uint32_t)1);
+		state.fragmentedPayload = nullptr;
+	}
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::receiveFragment(const uint8_t *packet, size_t length)
+{
+	if (!largePayload || !largePayload->reassemblyBuffer)
+	{
+		return true; // Large payloads are not received
+	}
+	LargePayloadState &state = *largePayload;
+	const uint8_t id = packet[2];
+	const uint8_t index = packet[3];
+	const uint8_t count = packet[4];
+	const uint8_t size = packet[5];
+	const size_t dataLength = length - REMOTECONTROLLER_FRAGMENT_HEADER_SIZE;
+	if (length <= REMOTECONTROLLER_FRAGMENT_HEADER_SIZE || index >= count || dataLength > size || (index != count - 1 && dataLength != size))
+	{
+		RC_STATISTICS(statistics.corruptPackets++);
+		error = ReceivedCorruptPacket;
+		return false;
+	}
+
+	if (!state.reassemblyActive || id != state.reassemblyId || count != state.reassemblyCount || size != state.reassemblyFragmentSize)
+	{
+		// First fragment of a new transfer
+		state.reassemblyActive = true;
+		state.reassemblyComplete = false;
+		state.reassemblyId = id;
+		state.reassemblyCount = count;
+		state.reassemblyFragmentSize = size;
+		state.reassemblyBase = 0;
+		state.reassemblyReceived = 0;
+		state.reassemblyLength = 0;
+	}
+	state.fragmentAckPending = true;
+	if (state.reassemblyComplete || index < state.reassemblyBase || index - state.reassemblyBase >= 32)
+	{
+		return true; // Already received (the acknowledgement got lost) or too far ahead
+	}
+
+	const size_t offset = (size_t)index * size;
+	if (offset + dataLength > state.reassemblyBufferSize)
+	{
+		state.reassemblyActive = false;
+		state.fragmentAckPending = false;
+		error = ReceivedPayloadTooBig;
+		return false;
+	}
+	memcpy(state.reassemblyBuffer + offset, packet + REMOTECONTROLLER_FRAGMENT_HEADER_SIZE, dataLength);
+	state.reassemblyReceived |= 1UL << (index - state.reassemblyBase);
+	if (index == count - 1)
+	{
+		state.reassemblyLength = offset + dataLength;
+	}
+	while (state.reassemblyReceived & 1)
+	{
+		state.reassemblyReceived >>= 1;
+		state.reassemblyBase++;
+	}
+
+	if (state.reassemblyBase == state.reassemblyCount)
+	{
+		state.reassemblyComplete = true;
+		if (payloadCallbackFunction)
+		{
+			payloadCallbackFunction(state.reassemblyBuffer, state.reassemblyLength);
+		}
+	}
+	return true;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::transmitFragmentAck()
+{
+	LargePayloadState &state = *largePayload;
+	if (pendingWrite != NoWrite)
+	{
+		return; // Sent by a later run() call, once the packet in flight is finished
+	}
+	uint8_t packet[8 + 2] = { // Room for the checksum
+		(uint8_t)(REMOTECONTROLLER_IDENTIFIER_FRAGMENT_ACK >> 8),
+		(uint8_t)REMOTECONTROLLER_IDENTIFIER_FRAGMENT_ACK,
+		state.reassemblyId,
+		state.reassemblyBase,
+		(uint8_t)state.reassemblyReceived,
+		(uint8_t)(state.reassemblyReceived >> 8),
+		(uint8_t)(state.reassemblyReceived >> 16),
+		(uint8_t)(state.reassemblyReceived >> 24)};
+	const size_t length = appendFrameCheck(packet, 8);
+	if (asyncWrites() && length <= packageSize)
+	{
+		memcpy(outgoingBuffer, packet, length); // Has to stay valid while the packet is in flight
+		state.fragmentAckPending = !startPacket(FragmentAckWrite, outgoingBuffer, length);
+		return;
+	}
+	state.fragmentAckPending = !writePacket(packet, length); // On failure the next run() call tries again
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::beginCommandPacket(uint8_t *packet, uint8_t sequence)
+{
+	// The first two bytes of each package are the IDENTIFIER COMMAND
+	uint16_t identifier = protocolVersion == ProtocolV2 ? REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 : REMOTECONTROLLER_IDENTIFIER_COMMAND;
+	const bool sequenced = sendsSequenceNumbers();
+	if (sequenced)
+	{
+		identifier = protocolVersion == ProtocolV2 ? REMOTECONTROLLER_IDENTIFIER_COMMAND_V2_SEQUENCED : REMOTECONTROLLER_IDENTIFIER_COMMAND_SEQUENCED;
+		// Sequence number byte: 7-bit sequence number, the highest bit asks the receiver to restart its duplicate window
+		packet[2] = (uint8_t)(sequence | (sequenceState->outgoingSequenceSync ? 0x80 : 0));
+	}
+	packet[0] = (uint8_t)(identifier >> 8);
+	packet[1] = (uint8_t)identifier;
+	return sequenced ? 3 : 2;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::sendsSequenceNumbers() const
+{
+	return sequenceState && sequenceState->useSequenceNumbers;
+}
+
+template <class ConnectionType>
+uint8_t RemoteControllerBaseT<ConnectionType>::nextSequence()
+{
+	if (!sequenceState)
+	{
+		return 0; // Without Feature::SequenceNumbers no sequence number is sent
+	}
+	const uint8_t sequence = sequenceState->outgoingSequence;
+	sequenceState->outgoingSequence = (sequence + 1) & 0x7F;
+	return sequence;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::acceptSequence(uint8_t header)
+{
+	const uint8_t sequence = header & 0x7F;
+	const bool sync = header & 0x80;
+	if (!incomingSequenceValid)
+	{
+		incomingSequenceValid = true;
+		incomingSequenceSync = sync;
+		incomingSequence = sequence;
+		incomingSequenceWindow = 1;
+		return true;
+	}
+
+	// Distance to the highest received sequence number (-64 to 63)
+	int distance = (sequence - incomingSequence) & 0x7F;
+	if (distance >= 64)
+	{
+		distance -= 128;
+	}
+	const bool received = distance <= 0 && -distance < REMOTECONTROLLER_SEQUENCE_WINDOW && (incomingSequenceWindow >> -distance) & 1;
+	if (sync && !(incomingSequenceSync && received))
+	{
+		// The sender started over, only packets since then are duplicates
+		incomingSequenceSync = true;
+		incomingSequence = sequence;
+		incomingSequenceWindow = 1;
+		return true;
+	}
+	incomingSequenceSync = incomingSequenceSync && sync;
+	if (distance > 0)
+	{
+		incomingSequenceWindow = distance >= REMOTECONTROLLER_SEQUENCE_WINDOW ? 0 : incomingSequenceWindow << distance;
+		incomingSequenceWindow |= 1;
+		incomingSequence = sequence;
+		return true;
+	}
+	if (received || -distance >= REMOTECONTROLLER_SEQUENCE_WINDOW)
+	{
+		return false; // A duplicate, or too old to tell
+	}
+	incomingSequenceWindow |= 1UL << -distance; // Arrived late (reordered)
+	return true;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::packCommand(uint8_t *packet, const QueuedCommand &queuedCommand, size_t &bytesInPacket, size_t maxPackageSize)
+{
+	if (bytesInPacket + encodedCommandSize(queuedCommand.throttle) > maxPackageSize)
+	{
+		return false; // The command does not fit into this package anymore
+	}
+	bytesInPacket += encodeCommand(queuedCommand.command, queuedCommand.throttle, packet + bytesInPacket);
+	return true;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::transmitCommands()
+{
+	if (pendingWrite != NoWrite)
+	{
+		return true; // The Connection is still busy with the packet in flight, the queue is sent once it is finished
+	}
+	// Stream the command queue if neccessary, each packet is removed from the queue as soon as it was transmitted
+	const size_t maxPackageSize = rcmin(packageSize, connection.getMaxPackageSize()) - frameCheckSize(); // Actual maximum size in byte that can be sent in one packet, without the checksum
+	const bool async = asyncWrites(); // Only one packet per run() call, the result is checked by a later run() call
+	const size_t maxPackets = async ? 1 : maxPacketsPerWrite();
+	dropExpiredCommands(); // Expired commands would only waste airtime
+	while (commandQueueLength != 0)
+	{
+		const void *packets[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t lengths[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t commandsInPackets[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		uint8_t sequences[REMOTECONTROLLER_MAX_BATCH_SIZE];
+		size_t packetCount = 0;
+		size_t packedCommands = 0;
+
+		// Pack the next packet(s), each into its own slot of the outgoing buffer
+		while (packetCount < maxPackets && packedCommands < commandQueueLength)
+		{
+			// A failed packet is packed again with its sequence number and commands, the receiver may already have it
+			const bool pinned = sequenceState && packetCount < sequenceState->pinnedPackets;
+			const size_t maxCommands = pinned ? sequenceState->pinnedCommands[packetCount] : commandQueueLength - packedCommands;
+			uint8_t *packet = outgoingBuffer + packetCount * packageSize;
+			sequences[packetCount] = pinned ? sequenceState->pinnedSequences[packetCount] : nextSequence();
+			size_t bytesInPacket = beginCommandPacket(packet, sequences[packetCount]);
+			size_t commandsInPacket = 0;
+
+			// Encode as many commands as fit into the package
+			while (commandsInPacket < maxCommands && packCommand(packet, queuedCommandAt(packedCommands + commandsInPacket), bytesInPacket, maxPackageSize))
+			{
+				commandsInPacket++;
+			}
+			if (commandsInPacket == 0)
+			{
+				// Not even a single command fits into one package of this connection
+				error = FailedToTransmitCommands;
+				return false;
+			}
+			packets[packetCount] = packet;
+			lengths[packetCount] = appendFrameCheck(packet, bytesInPacket);
+			commandsInPackets[packetCount] = commandsInPacket;
+			packedCommands += commandsInPacket;
+			packetCount++;
+		}
+
+		if (async)
+		{
+			if (!startPacket(CommandWrite, packets[0], lengths[0]))
+			{
+				return commandPacketsWritten(sequences, commandsInPackets, 1, 0);
+			}
+			pendingSequence = sequences[0];
+			pendingCommands = commandsInPackets[0];
+			return true;
+		}
+
+		// Try to transmit the payload(s)
+		size_t packetsSent = writePackets(packets, lengths, packetCount);
+		if (!commandPacketsWritten(sequences, commandsInPackets, packetCount, packetsSent))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::commandPacketsWritten(uint8_t sequences[], size_t commandsInPackets[], size_t packetCount, size_t packetsSent)
+{
+	// sequences and commandsInPackets hold REMOTECONTROLLER_MAX_BATCH_SIZE packets, the packets from packetCount on are overwritten
+	for (size_t i = 0; i < packetsSent; i++)
+	{
+		commandQueueHead = (commandQueueHead + commandsInPackets[i]) % commandQueueCapacity;
+		commandQueueLength -= commandsInPackets[i];
+	}
+	if (packetsSent && sendsSequenceNumbers())
+	{
+		sequenceState->outgoingSequenceSync = false; // The receiver restarted its duplicate window
+	}
+	if (packetsSent < packetCount)
+	{
+		// The failed packets followed by the pinned packets that did not fit into this batch
+		const size_t pinnedPackets = sequenceState ? sequenceState->pinnedPackets : 0;
+		for (size_t i = packetCount; i < pinnedPackets; i++)
+		{
+			sequences[i] = sequenceState->pinnedSequences[i];
+			commandsInPackets[i] = sequenceState->pinnedCommands[i];
+		}
+		const size_t failedPackets = rcmax(pinnedPackets, packetCount) - packetsSent;
+		keepFailedPackets(sequences + packetsSent, commandsInPackets + packetsSent, failedPackets);
+		error = FailedToTransmitCommands;
+		return false; // The packets that were already transmitted are not sent again
+	}
+	unpinPackets(packetCount);
+	return true;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::unpinPackets(size_t count)
+{
+	if (!sequenceState)
+	{
+		return; // Nothing is pinned without Feature::SequenceNumbers
+	}
+	SequenceState &state = *sequenceState;
+	count = rcmin(count, (size_t)state.pinnedPackets);
+	for (size_t i = count; i < state.pinnedPackets; i++)
+	{
+		state.pinnedSequences[i - count] = state.pinnedSequences[i];
+		state.pinnedCommands[i - count] = state.pinnedCommands[i];
+	}
+	state.pinnedPackets -= count;
+	state.pinnedCommandCount = 0;
+	for (size_t i = 0; i < state.pinnedPackets; i++)
+	{
+		state.pinnedCommandCount += state.pinnedCommands[i];
+	}
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::keepFailedPackets(const uint8_t sequences[], size_t commandsInPackets[], size_t count)
+{
+	// The commands of the failed packets are the first ones in the queue, the DeliveryMode::AtMostOnce ones are dropped.
+	// The kept commands are moved towards the back, so the order is preserved and only the head of the queue moves.
+	size_t end = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		end += commandsInPackets[i];
+	}
+	size_t kept = end; // Index in front of the last kept command
+	for (size_t i = count; i-- > 0;)
+	{
+		const size_t start = end - commandsInPackets[i];
+		size_t commandsKept = 0;
+		for (size_t j = end; j-- > start;)
+		{
+			if (getDeliveryMode(queuedCommandAt(j).command) == AtLeastOnce)
+			{
+				queuedCommandAt(--kept) = queuedCommandAt(j);
+				commandsKept++;
+			}
+		}
+		commandsInPackets[i] = commandsKept;
+		end = start;
+	}
+	commandQueueHead = (commandQueueHead + kept) % commandQueueCapacity;
+	commandQueueLength -= kept;
+
+	// With sequence numbers the packets are sent again unchanged (except for the dropped commands)
+	if (!sequenceState)
+	{
+		return;
+	}
+	SequenceState &state = *sequenceState;
+	state.pinnedPackets = 0;
+	state.pinnedCommandCount = 0;
+	for (size_t i = 0; state.useSequenceNumbers && i < count; i++)
+	{
+		if (commandsInPackets[i])
+		{
+			state.pinnedSequences[state.pinnedPackets] = sequences[i];
+			state.pinnedCommands[state.pinnedPackets] = commandsInPackets[i];
+			state.pinnedCommandCount += commandsInPackets[i];
+			state.pinnedPackets++;
+		}
+	}
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::transmitCommand(uint8_t command, float throttle)
+{
+	const size_t maxPackageSize = rcmin(packageSize, connection.getMaxPackageSize()) - frameCheckSize();
+	QueuedCommand queuedCommand;
+	queuedCommand.command = command;
+	queuedCommand.priority = High;
+	queuedCommand.expires = false;
+	queuedCommand.throttle = throttle;
+	queuedCommand.deadline = 0;
+
+	size_t bytesInPacket = beginCommandPacket(outgoingBuffer, nextSequence());
+	if (!packCommand(outgoingBuffer, queuedCommand, bytesInPacket, maxPackageSize))
+	{
+		return false;
+	}
+	return writePacket(outgoingBuffer, appendFrameCheck(outgoingBuffer, bytesInPacket));
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::asyncWrites()
+{
+	// Ack payloads are queued without waiting anyway. A packet in flight is finished asynchronously, even if ack payloads were enabled since.
+	const bool ackPayloads = useAckPayloads && connection.hasCapability(Connection::AckPayload);
+	return pendingWrite != NoWrite || (connection.hasCapability(Connection::AsyncWrite) && !ackPayloads);
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::lockedCommands()
+{
+	// Commands at the front of the queue that are neither coalesced nor overtaken: the ones of failed packets and of the packet in flight
+	const size_t pinnedCommands = sequenceState ? sequenceState->pinnedCommandCount : 0;
+	return rcmax(pinnedCommands, pendingWrite == CommandWrite ? pendingCommands : (size_t)0);
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::startPacket(PendingWrite kind, const void *buffer, size_t length)
+{
+	RC_STATISTICS(pendingStart = rcmicros());
+	if (!connection.startWrite(buffer, length))
+	{
+		RC_STATISTICS(countWrite(&length, 1, 0, pendingStart));
+		return false;
+	}
+	pendingWrite = kind;
+	pendingLength = length;
+	return true;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::pollPendingWrite()
+{
+	if (pendingWrite == NoWrite)
+	{
+		return true;
+	}
+	const Connection::WriteStatus status = connection.pollWrite();
+	if (status == Connection::WritePending)
+	{
+		return true;
+	}
+	const bool success = status == Connection::WriteSucceeded;
+	const PendingWrite kind = pendingWrite;
+	pendingWrite = NoWrite;
+	RC_STATISTICS(countWrite(&pendingLength, 1, success ? 1 : 0, pendingStart)); // The write time is the time until the result was seen
+
+	switch (kind)
+	{
+	case CommandWrite:
+	{
+		uint8_t sequences[REMOTECONTROLLER_MAX_BATCH_SIZE] = {pendingSequence};
+		size_t commandsInPackets[REMOTECONTROLLER_MAX_BATCH_SIZE] = {pendingCommands};
+		return commandPacketsWritten(sequences, commandsInPackets, 1, success ? 1 : 0);
+	}
+	case FragmentWrite: // (Fragments and their acknowledgements are only sent with Feature::LargePayloads)
+		if (largePayload->fragmentedPayload && largePayload->transferId == pendingTransferId)
+		{
+			const size_t index = pendingFragment;
+			fragmentsWritten(&index, 1, success ? 1 : 0);
+		}
+		break;
+	case FragmentAckWrite:
+		largePayload->fragmentAckPending = largePayload->fragmentAckPending || !success; // On failure the next run() call tries again
+		return true;
+	default:
+		break;
+	}
+	if (!success)
+	{
+		error = FailedToTransmitCustomPayload;
+		return false;
+	}
+	return true;
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::maxPacketsPerWrite()
+{
+	const bool ackPayloads = useAckPayloads && connection.hasCapability(Connection::AckPayload);
+	return ackPayloads || connection.hasCapability(Connection::BatchWrite) ? batchSize : 1;
+}
+
+template <class ConnectionType>
+size_t RemoteControllerBaseT<ConnectionType>::writePackets(const void *const packets[], const size_t lengths[], size_t count)
+{
+	RC_STATISTICS(const uint32_t start = rcmicros());
+	size_t packetsSent = 0;
+	if (useAckPayloads && connection.hasCapability(Connection::AckPayload))
+	{
+		// Queue the packets for the next acknowledgements, they count as transmitted once queued
+		while (packetsSent < count && connection.writeAckPayload(packets[packetsSent], lengths[packetsSent]))
+		{
+			packetsSent++;
+		}
+	}
+	else if (connection.hasCapability(Connection::BatchWrite))
+	{
+		packetsSent = connection.writeBatch(packets, lengths, count);
+	}
+	else
+	{
+		while (packetsSent < count && connection.write(packets[packetsSent], lengths[packetsSent]))
+		{
+			packetsSent++;
+		}
+	}
+	RC_STATISTICS(countWrite(lengths, count, packetsSent, start));
+	return packetsSent;
+}
+
+template <class ConnectionType>
+bool RemoteControllerBaseT<ConnectionType>::writePacket(const void *buffer, size_t length)
+{
+	RC_STATISTICS(const uint32_t start = rcmicros());
+	bool success;
+	if (useAckPayloads && connection.hasCapability(Connection::AckPayload))
+	{
+		success = connection.writeAckPayload(buffer, length);
+	}
+	else
+	{
+		success = connection.write(buffer, length);
+	}
+	RC_STATISTICS(countWrite(&length, 1, success ? 1 : 0, start));
+	return success;
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::countWrite(const size_t lengths[], size_t count, size_t packetsSent, uint32_t start)
+{
+#ifdef REMOTECONTROLLER_STATISTICS
+	const uint8_t bucket = Statistics::bucket(rcmicros() - start);
+	if (statistics.writeMicros[bucket] != UINT16_MAX)
+	{
+		statistics.writeMicros[bucket]++;
+	}
+	if (writeFailed && count)
+	{
+		statistics.writeRetries++; // The first packet is the one whose write failed last time
+	}
+	statistics.packetsSent += packetsSent;
+	for (size_t i = 0; i < packetsSent; i++)
+	{
+		statistics.bytesSent += lengths[i];
+	}
+	// A batch stops at the packet that failed, the packets behind it were not attempted
+	writeFailed = packetsSent < count;
+	if (writeFailed)
+	{
+		statistics.writeFailures++;
+	}
+#else
+	(void)lengths;
+	(void)count;
+	(void)packetsSent;
+	(void)start;
+#endif
+}
+
+template <class ConnectionType>
+RemoteControllerTypes::Statistics RemoteControllerBaseT<ConnectionType>::getStatistics()
+{
+#ifdef REMOTECONTROLLER_STATISTICS
+	return statistics;
+#else
+	Statistics statistics = {};
+	return statistics;
+#endif
+}
+
+template <class ConnectionType>
+void RemoteControllerBaseT<ConnectionType>::resetStatistics()
+{
+#ifdef REMOTECONTROLLER_STATISTICS
+	Statistics cleared = {};
+	statistics = cleared;
+	writeFailed = false;
+#endif
+}
+
+#endif
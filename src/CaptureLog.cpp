@@ -0,0 +1,88 @@
+#include "CaptureLog.h"
+#include <string.h>
+
+static const uint8_t sessionMagic[4] = {'R', 'C', 'L', 'G'};
+
+size_t CaptureLog::encodeVarint(uint8_t *output, uint32_t value)
+{
+	size_t length = 0;
+	while (value >= 0x80)
+	{
+		output[length++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	output[length++] = (uint8_t)value;
+	return length;
+}
+
+bool CaptureLog::decodeVarint(const uint8_t *log, size_t length, size_t &position, uint32_t &value)
+{
+	value = 0;
+	for (uint8_t shift = 0; shift < 35 && position < length; shift += 7)
+	{
+		const uint8_t byte = log[position++];
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+size_t CaptureLog::encodeRecordHeader(uint8_t *output, RecordKind kind, bool failed, uint8_t peer, uint32_t deltaMicros, size_t length)
+{
+	output[0] = (uint8_t)(kind | (failed ? Failed : 0) | (peer ? HasPeer : 0));
+	size_t size = 1;
+	size += encodeVarint(output + size, deltaMicros);
+	size += encodeVarint(output + size, (uint32_t)length);
+	if (peer)
+	{
+		output[size++] = peer;
+	}
+	return size;
+}
+
+void CaptureLog::encodeSession(uint8_t *output, uint8_t capabilities, uint8_t peerCount, size_t maxPackageSize)
+{
+	memcpy(output, sessionMagic, sizeof sessionMagic);
+	output[4] = Version;
+	output[5] = capabilities;
+	output[6] = peerCount;
+	output[7] = (uint8_t)maxPackageSize;
+	output[8] = (uint8_t)(maxPackageSize >> 8);
+}
+
+bool CaptureLog::decodeRecord(const uint8_t *log, size_t length, size_t &position, Record &record)
+{
+	size_t next = position;
+	if (next >= length)
+		return false;
+	const uint8_t type = log[next++];
+	uint32_t payloadLength;
+	if (!decodeVarint(log, length, next, record.deltaMicros) || !decodeVarint(log, length, next, payloadLength))
+		return false;
+	record.kind = (RecordKind)(type & KindMask);
+	record.failed = type & Failed;
+	record.peer = 0;
+	if (type & HasPeer)
+	{
+		if (next >= length)
+			return false;
+		record.peer = log[next++];
+	}
+	if (payloadLength > length - next)
+		return false; // The capture was cut off in the middle of the record
+	record.payload = log + next;
+	record.length = payloadLength;
+	position = next + payloadLength;
+	return true;
+}
+
+bool CaptureLog::decodeSession(const Record &record, uint8_t &capabilities, uint8_t &peerCount, size_t &maxPackageSize)
+{
+	if (record.kind != Session || record.length < SessionSize || memcmp(record.payload, sessionMagic, sizeof sessionMagic) != 0 || record.payload[4] != Version)
+		return false;
+	capabilities = record.payload[5];
+	peerCount = record.payload[6];
+	maxPackageSize = record.payload[7] | (size_t)record.payload[8] << 8;
+	return true;
+}
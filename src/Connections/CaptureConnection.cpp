@@ -0,0 +1,131 @@
+#include "Connections/CaptureConnection.h"
+
+CaptureConnection::CaptureConnection(Connection &connection, _Stream &log) : connection(connection), log(log)
+{
+	capabilities = (connection.hasCapability(BatchWrite) ? BatchWrite : 0) | (connection.hasCapability(AckPayload) ? AckPayload : 0) | (connection.hasCapability(AsyncWrite) ? AsyncWrite : 0) | (connection.hasCapability(MultiPeer) ? MultiPeer : 0);
+}
+
+void CaptureConnection::record(CaptureLog::RecordKind kind, bool failed, uint8_t peer, const void *payload, size_t length)
+{
+	const uint32_t now = rcmicros();
+	uint8_t header[CaptureLog::MaxRecordHeaderSize];
+	const size_t headerSize = CaptureLog::encodeRecordHeader(header, kind, failed, peer, now - lastMicros, length);
+	lastMicros = now;
+	if (log.write(header, headerSize) != headerSize || (length && log.write((const uint8_t *)payload, length) != length))
+	{
+		logErrors++;
+		return;
+	}
+	recordsWritten++;
+}
+
+bool CaptureConnection::begin()
+{
+	if (!connection.begin())
+		return false;
+	writePeer = 0;
+	pendingBuffer = nullptr;
+	uint8_t session[CaptureLog::SessionSize];
+	CaptureLog::encodeSession(session, capabilities, hasCapability(MultiPeer) ? connection.getPeerCount() : 1, connection.getMaxPackageSize());
+	if (recordsWritten == 0)
+	{
+		lastMicros = rcmicros(); // Later sessions keep the time between them
+	}
+	record(CaptureLog::Session, false, 0, session, sizeof session);
+	return true;
+}
+
+void CaptureConnection::end()
+{
+	connection.end();
+}
+
+bool CaptureConnection::available()
+{
+	return connection.available();
+}
+
+size_t CaptureConnection::getPayloadSize()
+{
+	return connection.getPayloadSize();
+}
+
+void CaptureConnection::read(void *buffer, size_t length)
+{
+	// The peer and the size are only valid before the packet is read
+	const uint8_t peer = hasCapability(MultiPeer) ? connection.getReadPeer() : 0;
+	const size_t size = rcmin(connection.getPayloadSize(), length);
+	connection.read(buffer, length);
+	record(CaptureLog::Read, false, peer, buffer, size);
+}
+
+bool CaptureConnection::write(const void *buffer, size_t length)
+{
+	const bool success = connection.write(buffer, length);
+	record(CaptureLog::Write, !success, writePeer, buffer, length);
+	return success;
+}
+
+size_t CaptureConnection::getMaxPackageSize()
+{
+	return connection.getMaxPackageSize();
+}
+
+size_t CaptureConnection::writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+{
+	const size_t sent = connection.writeBatch(buffers, lengths, count);
+	// The packets after the failed one were not transmitted and are not logged
+	for (size_t i = 0; i < count && i <= sent; i++)
+	{
+		record(CaptureLog::Write, i == sent, writePeer, buffers[i], lengths[i]);
+	}
+	return sent;
+}
+
+bool CaptureConnection::writeAckPayload(const void *buffer, size_t length)
+{
+	const bool success = connection.writeAckPayload(buffer, length);
+	record(CaptureLog::AckPayload, !success, writePeer, buffer, length);
+	return success;
+}
+
+bool CaptureConnection::startWrite(const void *buffer, size_t length)
+{
+	if (!connection.startWrite(buffer, length))
+	{
+		record(CaptureLog::Write, true, writePeer, buffer, length);
+		return false;
+	}
+	pendingBuffer = buffer; // Valid until the write finished
+	pendingLength = length;
+	return true;
+}
+
+Connection::WriteStatus CaptureConnection::pollWrite()
+{
+	const WriteStatus status = connection.pollWrite();
+	if (pendingBuffer && (status == WriteSucceeded || status == WriteFailed))
+	{
+		record(CaptureLog::Write, status == WriteFailed, writePeer, pendingBuffer, pendingLength);
+		pendingBuffer = nullptr;
+	}
+	return status;
+}
+
+uint8_t CaptureConnection::getPeerCount()
+{
+	return connection.getPeerCount();
+}
+
+bool CaptureConnection::setWritePeer(uint8_t peer)
+{
+	if (!connection.setWritePeer(peer))
+		return false;
+	writePeer = peer;
+	return true;
+}
+
+uint8_t CaptureConnection::getReadPeer()
+{
+	return connection.getReadPeer();
+}
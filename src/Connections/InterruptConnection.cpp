@@ -0,0 +1,167 @@
+#include "Connections/InterruptConnection.h"
+#include <string.h>
+
+InterruptConnection::InterruptConnection(Connection &connection) : connection(connection)
+{
+	capabilities = (connection.hasCapability(BatchWrite) ? BatchWrite : 0) | (connection.hasCapability(AckPayload) ? AckPayload : 0) | (connection.hasCapability(AsyncWrite) ? AsyncWrite : 0);
+}
+
+bool InterruptConnection::tryLock()
+{
+#if defined(RC_ARCH_USE_ATOMIC)
+	return !busy.exchange(true);
+#else
+	// An interrupt either runs before or after this (it runs to completion), never in between on the same core
+	if (busy)
+		return false;
+	busy = true;
+	return true;
+#endif
+}
+
+void InterruptConnection::lock()
+{
+	while (!tryLock())
+	{
+		// The interrupt side only holds the lock while it moves packets into the ring
+	}
+}
+
+void InterruptConnection::unlock()
+{
+	busy = false;
+	if (pending)
+	{
+		handleInterrupt(); // An interrupt occured while the wrapped Connection was in use
+	}
+}
+
+void InterruptConnection::handleInterrupt()
+{
+	// Flag first, then try to get the wrapped Connection: either this call or the current lock owner (in unlock()) handles the packets
+	pending = true;
+	while (pending && tryLock())
+	{
+		pending = false;
+		while (connection.available())
+		{
+			size_t length = connection.getPayloadSize();
+			if (length < 1)
+			{
+				break; // Corrupt packet, the wrapped Connection has to discard it
+			}
+			length = rcmin(length, PacketRing::PacketSize);
+			uint8_t *slot = ring.reserve();
+			if (slot)
+			{
+				connection.read(slot, length);
+				ring.commit(length);
+			}
+			else
+			{
+				// Ring full (counted as overflow drop), the packet is still read to free the radio
+				uint8_t discard[PacketRing::PacketSize];
+				connection.read(discard, length);
+			}
+		}
+		busy = false;
+	}
+}
+
+bool InterruptConnection::begin()
+{
+	lock();
+	bool success = connection.begin();
+	unlock();
+	return success;
+}
+
+void InterruptConnection::end()
+{
+	lock();
+	connection.end();
+	busy = false; // No handleInterrupt() on an ended Connection
+	pending = false;
+	while (!ring.empty())
+	{
+		ring.pop();
+	}
+}
+
+bool InterruptConnection::available()
+{
+	return !ring.empty();
+}
+
+void InterruptConnection::read(void *buffer, size_t length)
+{
+	if (ring.empty())
+		return;
+	memcpy(buffer, ring.front(), rcmin(length, ring.frontLength()));
+	ring.pop();
+}
+
+size_t InterruptConnection::getPayloadSize()
+{
+	return ring.empty() ? 0 : ring.frontLength();
+}
+
+bool InterruptConnection::write(const void *buffer, size_t length)
+{
+	lock();
+	bool success = connection.write(buffer, length);
+	unlock();
+	return success;
+}
+
+size_t InterruptConnection::getMaxPackageSize()
+{
+	return rcmin(connection.getMaxPackageSize(), PacketRing::PacketSize); // Larger packets would not fit into the ring slots
+}
+
+size_t InterruptConnection::writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+{
+	lock();
+	size_t sent = connection.writeBatch(buffers, lengths, count);
+	unlock();
+	return sent;
+}
+
+bool InterruptConnection::writeAckPayload(const void *buffer, size_t length)
+{
+	lock();
+	bool success = connection.writeAckPayload(buffer, length);
+	unlock();
+	return success;
+}
+
+bool InterruptConnection::startWrite(const void *buffer, size_t length)
+{
+	lock();
+	bool success = connection.startWrite(buffer, length);
+	unlock();
+	return success;
+}
+
+Connection::WriteStatus InterruptConnection::pollWrite()
+{
+	lock();
+	WriteStatus status = connection.pollWrite();
+	unlock();
+	return status;
+}
+
+uint8_t InterruptConnection::getHighWatermark() const
+{
+	return ring.highWatermark();
+}
+
+uint32_t InterruptConnection::getOverflowDrops() const
+{
+	return ring.overflowDrops();
+}
+
+void InterruptConnection::resetStatistics()
+{
+	ring.resetStatistics();
+}
@@ -0,0 +1,166 @@
+#include "Connections/LoopbackConnection.h"
+#include <string.h>
+
+LoopbackConnection::LoopbackConnection()
+{
+	capabilities = BatchWrite | AckPayload | MultiPeer;
+}
+
+LoopbackConnection::LoopbackConnection(LoopbackConnection &peer)
+{
+	capabilities = BatchWrite | AckPayload | MultiPeer;
+	pair(peer);
+}
+
+void LoopbackConnection::pair(LoopbackConnection &peer)
+{
+	peers[0] = &peer;
+	peerCount = 1;
+	peer.peers[0] = this;
+	peer.peerCount = 1;
+}
+
+int LoopbackConnection::addPeer(LoopbackConnection &peer)
+{
+	if (peerCount >= REMOTECONTROLLER_LOOPBACK_PEERS)
+		return -1;
+	peers[peerCount] = &peer;
+	peer.peers[0] = this;
+	peer.peerCount = 1;
+	return peerCount++;
+}
+
+uint8_t LoopbackConnection::getPeerCount()
+{
+	return peerCount;
+}
+
+bool LoopbackConnection::setWritePeer(uint8_t peer)
+{
+	if (peer >= peerCount)
+		return false;
+	writePeer = peer;
+	return true;
+}
+
+uint8_t LoopbackConnection::getReadPeer()
+{
+	for (uint8_t i = 0; count && i < peerCount; i++)
+	{
+		if (peers[i] == packetSources[head])
+			return i;
+	}
+	return 0;
+}
+
+void LoopbackConnection::setMaxPackageSize(size_t size)
+{
+	maxPackageSize = size < REMOTECONTROLLER_LOOPBACK_PACKET_SIZE ? size : REMOTECONTROLLER_LOOPBACK_PACKET_SIZE;
+}
+
+size_t LoopbackConnection::queuedPackets() const
+{
+	return count;
+}
+
+size_t LoopbackConnection::queuedAckPayloads() const
+{
+	return ackCount;
+}
+
+void LoopbackConnection::resetCounters()
+{
+	packetsWritten = 0;
+	bytesWritten = 0;
+	writeFailures = 0;
+}
+
+bool LoopbackConnection::begin()
+{
+	isBegun = true;
+	return true;
+}
+
+void LoopbackConnection::end()
+{
+	isBegun = false;
+	head = 0;
+	count = 0;
+	ackHead = 0;
+	ackCount = 0;
+}
+
+bool LoopbackConnection::available()
+{
+	return count != 0;
+}
+
+void LoopbackConnection::read(void *buffer, size_t length)
+{
+	if (count == 0)
+		return;
+	size_t packetLength = packetLengths[head];
+	memcpy(buffer, packets[head], length < packetLength ? length : packetLength);
+	head = (head + 1) % REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH;
+	count--;
+}
+
+size_t LoopbackConnection::getPayloadSize()
+{
+	return count ? packetLengths[head] : 0;
+}
+
+bool LoopbackConnection::write(const void *buffer, size_t length)
+{
+	// Like a radio without ack: the write fails if nobody is listening on the other end
+	LoopbackConnection *peer = writePeer < peerCount ? peers[writePeer] : nullptr;
+	if (!peer || !peer->isBegun || length > maxPackageSize || !peer->enqueue(this, buffer, length))
+	{
+		writeFailures++;
+		return false;
+	}
+	packetsWritten++;
+	bytesWritten += length;
+	peer->sendAckPayload(this); // The peer acknowledges the packet
+	return true;
+}
+
+size_t LoopbackConnection::getMaxPackageSize()
+{
+	return maxPackageSize;
+}
+
+bool LoopbackConnection::enqueue(const LoopbackConnection *source, const void *buffer, size_t length)
+{
+	if (count >= REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH)
+		return false; // Receive queue full, the packet is dropped (no ack)
+	size_t tail = (head + count) % REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH;
+	memcpy(packets[tail], buffer, length);
+	packetLengths[tail] = length;
+	packetSources[tail] = source;
+	count++;
+	return true;
+}
+
+bool LoopbackConnection::writeAckPayload(const void *buffer, size_t length)
+{
+	if (ackCount >= REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH || length > maxPackageSize)
+		return false;
+	size_t tail = (ackHead + ackCount) % REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH;
+	memcpy(ackPayloads[tail], buffer, length);
+	ackPayloadLengths[tail] = length;
+	ackPayloadTargets[tail] = writePeer < peerCount ? peers[writePeer] : nullptr;
+	ackCount++;
+	return true;
+}
+
+void LoopbackConnection::sendAckPayload(LoopbackConnection *writer)
+{
+	// The oldest ack payload rides on the acknowledgement of its peer, it stays queued if that peer cannot receive it
+	if (ackCount == 0 || ackPayloadTargets[ackHead] != writer || !writer->enqueue(this, ackPayloads[ackHead], ackPayloadLengths[ackHead]))
+		return;
+	packetsWritten++;
+	bytesWritten += ackPayloadLengths[ackHead];
+	ackHead = (ackHead + 1) % REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH;
+	ackCount--;
+}
@@ -0,0 +1,140 @@
+#include "Connections/PeerConnection.h"
+#include "ArchConfig.h"
+#include <string.h>
+
+PeerMux::PeerMux(Connection &connection, uint8_t *stagingBuffer, size_t stagingBufferSize, uint8_t peers)
+	: connection(connection), stagingBuffer(stagingBuffer), stagingBufferSize(stagingBufferSize), peers(peers)
+{
+}
+
+bool PeerMux::begin()
+{
+	staged = false;
+	begun = connection.begin();
+	return begun;
+}
+
+void PeerMux::end()
+{
+	connection.end();
+	begun = false;
+	staged = false;
+}
+
+bool PeerMux::isBegun() const
+{
+	return begun;
+}
+
+bool PeerMux::stage()
+{
+	while (!staged && connection.available())
+	{
+		const size_t length = connection.getPayloadSize();
+		if (length < 1)
+		{
+			return false; // Corrupt packet, the shared Connection has to discard it
+		}
+		const uint8_t peer = connection.hasCapability(Connection::MultiPeer) ? connection.getReadPeer() : 0;
+		stagedLength = rcmin(length, stagingBufferSize);
+		connection.read(stagingBuffer, stagedLength);
+		if (peer < peers)
+		{
+			stagedPeer = peer;
+			staged = true;
+		}
+		else
+		{
+			unknownPeerDrops++;
+		}
+	}
+	return staged;
+}
+
+bool PeerMux::available(uint8_t peer)
+{
+	// A packet of another peer stays staged (and blocks the following ones) until the PeerConnection of that peer reads it
+	return stage() && stagedPeer == peer;
+}
+
+void PeerMux::read(uint8_t peer, void *buffer, size_t length)
+{
+	if (!available(peer))
+		return;
+	memcpy(buffer, stagingBuffer, rcmin(length, stagedLength));
+	staged = false;
+}
+
+size_t PeerMux::getPayloadSize(uint8_t peer)
+{
+	return available(peer) ? stagedLength : 0;
+}
+
+bool PeerMux::select(uint8_t peer)
+{
+	if (!connection.hasCapability(Connection::MultiPeer))
+		return peer == 0;
+	return connection.setWritePeer(peer);
+}
+
+uint32_t PeerMux::getUnknownPeerDrops() const
+{
+	return unknownPeerDrops;
+}
+
+void PeerConnection::attach(PeerMux &mux, uint8_t peer)
+{
+	this->mux = &mux;
+	this->peer = peer;
+	capabilities = (mux.connection.hasCapability(BatchWrite) ? BatchWrite : 0) | (mux.connection.hasCapability(AckPayload) ? AckPayload : 0);
+}
+
+uint8_t PeerConnection::getPeer() const
+{
+	return peer;
+}
+
+bool PeerConnection::begin()
+{
+	// The shared Connection is started once by the owner of the PeerMux
+	return mux && mux->isBegun();
+}
+
+void PeerConnection::end()
+{
+}
+
+bool PeerConnection::available()
+{
+	return mux->available(peer);
+}
+
+void PeerConnection::read(void *buffer, size_t length)
+{
+	mux->read(peer, buffer, length);
+}
+
+size_t PeerConnection::getPayloadSize()
+{
+	return mux->getPayloadSize(peer);
+}
+
+bool PeerConnection::write(const void *buffer, size_t length)
+{
+	return mux->select(peer) && mux->connection.write(buffer, length);
+}
+
+size_t PeerConnection::getMaxPackageSize()
+{
+	return mux->connection.getMaxPackageSize();
+}
+
+size_t PeerConnection::writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+{
+	return mux->select(peer) ? mux->connection.writeBatch(buffers, lengths, count) : 0;
+}
+
+bool PeerConnection::writeAckPayload(const void *buffer, size_t length)
+{
+	return mux->select(peer) && mux->connection.writeAckPayload(buffer, length);
+}
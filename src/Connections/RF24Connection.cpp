@@ -2,13 +2,15 @@
 
 RF24Connection::RF24Connection(int cepin, int cspin, const uint8_t *address) : rf24(RF24(cepin, cspin))
 {
-	memcpy(rf24_address, address, 5);
+	memcpy(rf24_addresses[0], address, 5);
+	capabilities = BatchWrite | MultiPeer;
 }
 
 RF24Connection::RF24Connection(RF24 &rf24, const uint8_t *address) : rf24(rf24)
 {
-	memcpy(rf24_address, address, 5);
+	memcpy(rf24_addresses[0], address, 5);
 	isRF24Initialized = true;
+	capabilities = BatchWrite | MultiPeer;
 }
 
 void RF24Connection::useSpecificSPIBus(_SPI *spiBus)
@@ -16,6 +18,24 @@ void RF24Connection::useSpecificSPIBus(_SPI *spiBus)
 	nonDefaultSPI = spiBus;
 }
 
+void RF24Connection::setAsyncWrites(bool enable)
+{
+	capabilities = enable ? capabilities | AsyncWrite : capabilities & ~AsyncWrite;
+}
+
+void RF24Connection::setAckPayloads(bool enable)
+{
+	capabilities = enable ? capabilities | AckPayload : capabilities & ~AckPayload;
+}
+
+int RF24Connection::addPeer(const uint8_t *address)
+{
+	if (peerCount >= REMOTECONTROLLER_RF24CONNECTION_MAX_PEERS)
+		return -1;
+	memcpy(rf24_addresses[peerCount], address, 5);
+	return peerCount++;
+}
+
 bool RF24Connection::begin()
 {
 	if (!isRF24Initialized)
@@ -41,14 +61,31 @@ bool RF24Connection::begin()
 	// Required NRF24L01 settings for RF24 to work
 	rf24.enableDynamicPayloads();
 	rf24.setAutoAck(true);
-	rf24.openReadingPipe(1, rf24_address);
+	if (hasCapability(AckPayload))
+	{
+		rf24.enableAckPayload(); // Allows replies attached to the auto-ack, see RF24Connection::writeAckPayload()
+	}
+	else
+	{
+		rf24.disableAckPayload();
+	}
+	// The pipes are configured once: the writing pipe (TX address and pipe 0 for the acks) is kept while listening on pipes 1-5, startListening() only closes pipe 0
+	writePeer = 0;
+	rf24.openWritingPipe(rf24_addresses[0]);
+	for (uint8_t peer = 0; peer < peerCount; peer++)
+	{
+		rf24.openReadingPipe(peer + 1, rf24_addresses[peer]);
+	}
 	rf24.startListening();
 	return true;
 }
 
 void RF24Connection::end()
 {
-	rf24.closeReadingPipe(1);
+	for (uint8_t peer = 0; peer < peerCount; peer++)
+	{
+		rf24.closeReadingPipe(peer + 1);
+	}
 	rf24.powerDown();
 	isRF24Initialized = false;
 }
@@ -71,15 +108,82 @@ size_t RF24Connection::getPayloadSize()
 bool RF24Connection::write(const void *buffer, size_t length)
 {
 	rf24.stopListening();
-	rf24.closeReadingPipe(1);
-	rf24.openWritingPipe(rf24_address);
 	bool success = rf24.write(buffer, length);
-	rf24.openReadingPipe(1, rf24_address);
 	rf24.startListening();
 	return success;
 }
 
-size_t RF24Connection::getMaxPackageSize()
+size_t RF24Connection::writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+{
+	// Switch to TX mode once for the whole batch
+	rf24.stopListening();
+
+	// Fill the TX FIFO, writeFast() only blocks while the FIFO is full and fails if the oldest packet in the full FIFO reached the retry limit
+	size_t queued = 0;
+	while (queued < count && rf24.writeFast(buffers[queued], lengths[queued]))
+	{
+		queued++;
+	}
+	// Wait until the TX FIFO is empty (all packets acked), on failure txStandBy() clears the retry limit flag and flushes the TX FIFO
+	bool success = rf24.txStandBy() && queued == count;
+	rf24.startListening();
+
+	if (success)
+		return count;
+	// The packets that were still in the TX FIFO are not known to be acked
+	return queued > REMOTECONTROLLER_RF24CONNECTION_TX_FIFO_SIZE ? queued - REMOTECONTROLLER_RF24CONNECTION_TX_FIFO_SIZE : 0;
+}
+
+bool RF24Connection::writeAckPayload(const void *buffer, size_t length)
+{
+	return rf24.writeAckPayload(writePeer + 1, buffer, length);
+}
+
+bool RF24Connection::setWritePeer(uint8_t peer)
+{
+	if (peer >= peerCount || writeStatus == WritePending)
+		return false;
+	if (peer != writePeer)
+	{
+		rf24.openWritingPipe(rf24_addresses[peer]);
+		writePeer = peer;
+	}
+	return true;
+}
+
+uint8_t RF24Connection::getReadPeer()
 {
-	return maxPackageSize;
+	uint8_t pipe = 0;
+	if (!rf24.available(&pipe))
+		return 0;
+	// Pipe 0 only receives the ack payloads of our own writes, they come from the peer that was written to
+	return pipe >= 1 ? pipe - 1 : writePeer;
+}
+
+bool RF24Connection::startWrite(const void *buffer, size_t length)
+{
+	if (length > maxPackageSize || writeStatus == WritePending)
+		return false;
+	rf24.stopListening();
+	// CE stays high, the NRF24L01 sends the packet and retries on its own until it is acked or the retry limit is reached
+	rf24.startFastWrite(buffer, length, false);
+	writeStatus = WritePending;
+	return true;
+}
+
+Connection::WriteStatus RF24Connection::pollWrite()
+{
+	if (writeStatus != WritePending)
+		return writeStatus;
+	bool txOk, txFail, rxReady;
+	rf24.whatHappened(txOk, txFail, rxReady);
+	if (!txOk && !txFail)
+		return WritePending;
+	if (txFail)
+	{
+		rf24.flush_tx(); // The packet that reached the retry limit stays in the TX FIFO
+	}
+	rf24.startListening();
+	writeStatus = txOk ? WriteSucceeded : WriteFailed;
+	return writeStatus;
 }
@@ -0,0 +1,146 @@
+#include "Connections/ReplayConnection.h"
+#include <string.h>
+
+ReplayConnection::ReplayConnection(const uint8_t *log, size_t length) : log(log), logLength(length)
+{
+	// The capabilities have to be known before begin(), e.g. for MultiPeerRemoteController::begin()
+	size_t position = 0;
+	CaptureLog::Record session;
+	uint8_t recordedCapabilities;
+	if (CaptureLog::decodeRecord(log, logLength, position, session) && CaptureLog::decodeSession(session, recordedCapabilities, peerCount, maxPackageSize))
+	{
+		capabilities = recordedCapabilities;
+	}
+}
+
+void ReplayConnection::setOriginalSpeed(bool enable)
+{
+	originalSpeed = enable;
+}
+
+bool ReplayConnection::begin()
+{
+	if (maxPackageSize == 0)
+		return false; // The log does not start with a session of this version
+	readPosition = 0;
+	readMicros = 0;
+	readPending = false;
+	blockedOnWrite = false;
+	writePosition = 0;
+	writePeer = 0;
+	packetsReplayed = 0;
+	writeMismatches = 0;
+	startMicros = rcmicros();
+	return true;
+}
+
+void ReplayConnection::end()
+{
+	readPending = false;
+}
+
+bool ReplayConnection::available()
+{
+	while (!readPending)
+	{
+		size_t position = readPosition;
+		if (!CaptureLog::decodeRecord(log, logLength, position, nextRead))
+			return false; // End of the log
+		if ((nextRead.kind == CaptureLog::Write || nextRead.kind == CaptureLog::AckPayload) && readPosition >= writePosition)
+		{
+			// The packets recorded after a write are only read once the RemoteController made the write, like in the recorded run() calls.
+			// A write the RemoteController did not make until the next run() call (e.g. other settings than recorded) is skipped.
+			if (!blockedOnWrite)
+			{
+				blockedOnWrite = true;
+				return false;
+			}
+			writePosition = position;
+			writeMismatches++;
+		}
+		blockedOnWrite = false;
+		readPosition = position;
+		readMicros += nextRead.deltaMicros;
+		readPending = nextRead.kind == CaptureLog::Read;
+	}
+	return !originalSpeed || (uint32_t)(rcmicros() - startMicros) >= readMicros;
+}
+
+void ReplayConnection::read(void *buffer, size_t length)
+{
+	if (!readPending)
+		return;
+	memcpy(buffer, nextRead.payload, rcmin(length, nextRead.length));
+	readPending = false;
+	packetsReplayed++;
+}
+
+size_t ReplayConnection::getPayloadSize()
+{
+	return readPending ? nextRead.length : 0;
+}
+
+uint8_t ReplayConnection::getReadPeer()
+{
+	return readPending ? nextRead.peer : 0;
+}
+
+bool ReplayConnection::nextWrite(CaptureLog::RecordKind kind, const void *buffer, size_t length)
+{
+	blockedOnWrite = false;
+	CaptureLog::Record recorded;
+	while (CaptureLog::decodeRecord(log, logLength, writePosition, recorded))
+	{
+		if (recorded.kind != CaptureLog::Write && recorded.kind != CaptureLog::AckPayload)
+			continue;
+		if (recorded.kind != kind || recorded.peer != writePeer || recorded.length != length || memcmp(recorded.payload, buffer, length) != 0)
+		{
+			writeMismatches++;
+		}
+		return !recorded.failed;
+	}
+	writeMismatches++; // More writes than recorded
+	return true;
+}
+
+bool ReplayConnection::write(const void *buffer, size_t length)
+{
+	return nextWrite(CaptureLog::Write, buffer, length);
+}
+
+bool ReplayConnection::writeAckPayload(const void *buffer, size_t length)
+{
+	return nextWrite(CaptureLog::AckPayload, buffer, length);
+}
+
+size_t ReplayConnection::getMaxPackageSize()
+{
+	return maxPackageSize;
+}
+
+uint8_t ReplayConnection::getPeerCount()
+{
+	return peerCount;
+}
+
+bool ReplayConnection::setWritePeer(uint8_t peer)
+{
+	if (peer >= peerCount)
+		return false;
+	writePeer = peer;
+	return true;
+}
+
+bool ReplayConnection::finished()
+{
+	if (readPending)
+		return false;
+	size_t position = readPosition;
+	CaptureLog::Record record;
+	while (CaptureLog::decodeRecord(log, logLength, position, record))
+	{
+		if (record.kind == CaptureLog::Read)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,145 @@
+#include "Connections/SerialConnection.h"
+#include <string.h>
+
+SerialConnection::SerialConnection(_Stream &stream) : stream(stream)
+{
+}
+
+void SerialConnection::setMaxPackageSize(size_t size)
+{
+	maxPackageSize = size < REMOTECONTROLLER_SERIAL_PACKET_SIZE ? size : REMOTECONTROLLER_SERIAL_PACKET_SIZE;
+}
+
+size_t SerialConnection::getMaxPackageSize()
+{
+	return maxPackageSize;
+}
+
+bool SerialConnection::begin()
+{
+	resetDecoder();
+	packetReady = false;
+	// Terminates whatever the other end received before (e.g. boot messages), so the first packet is not lost
+	const uint8_t delimiter = 0;
+	return stream.write(&delimiter, 1) == 1;
+}
+
+void SerialConnection::end()
+{
+	resetDecoder();
+	packetReady = false;
+}
+
+void SerialConnection::resetDecoder()
+{
+	rxLength = 0;
+	rxRemaining = 0;
+	rxZeroPending = false;
+	rxStarted = false;
+	rxDiscarding = false;
+}
+
+bool SerialConnection::appendReceived(uint8_t byte)
+{
+	if (rxLength >= maxPackageSize)
+	{
+		rxDiscarding = true; // Larger than any packet of this connection
+		return false;
+	}
+	rxBuffer[rxLength++] = byte;
+	return true;
+}
+
+bool SerialConnection::available()
+{
+	// Decode what arrived so far, stop at the end of a packet: the bytes of the next one stay in the Stream until this one is read
+	while (!packetReady && stream.available() > 0)
+	{
+		const int received = stream.read();
+		if (received < 0)
+			break;
+		const uint8_t byte = (uint8_t)received;
+		if (byte == 0)
+		{
+			// Delimiter: the packet is complete if the last block is
+			if (rxStarted && !rxDiscarding && rxRemaining == 0)
+			{
+				packetReady = true;
+				packetsReceived++;
+				rxStarted = false; // rxLength is kept for SerialConnection::read()
+				continue;
+			}
+			if (rxStarted || rxDiscarding)
+			{
+				framingErrors++;
+			}
+			resetDecoder(); // Empty frames (two delimiters in a row) are ignored
+			continue;
+		}
+		if (rxDiscarding)
+		{
+			continue;
+		}
+		if (rxRemaining == 0)
+		{
+			// Code byte: the previous block ended with a 0x00, the new block has byte - 1 data bytes
+			if (rxZeroPending && !appendReceived(0))
+				continue;
+			rxRemaining = byte - 1;
+			rxZeroPending = byte < 0xFF;
+			rxStarted = true;
+		}
+		else if (appendReceived(byte))
+		{
+			rxRemaining--;
+		}
+	}
+	return packetReady;
+}
+
+void SerialConnection::read(void *buffer, size_t length)
+{
+	if (!packetReady)
+		return;
+	memcpy(buffer, rxBuffer, length < rxLength ? length : rxLength);
+	packetReady = false;
+	resetDecoder();
+}
+
+size_t SerialConnection::getPayloadSize()
+{
+	return packetReady ? rxLength : 0;
+}
+
+size_t SerialConnection::encode(const uint8_t *input, size_t length, uint8_t *output)
+{
+	size_t codeIndex = 0; // Where the code byte of the current block goes
+	size_t outputIndex = 1;
+	uint8_t code = 1;
+	for (size_t i = 0; i < length; i++)
+	{
+		if (input[i] != 0)
+		{
+			output[outputIndex++] = input[i];
+			code++;
+		}
+		if (input[i] == 0 || code == 0xFF)
+		{
+			// End of the block: at a 0x00 (not encoded) or after 254 data bytes
+			output[codeIndex] = code;
+			code = 1;
+			codeIndex = outputIndex++;
+		}
+	}
+	output[codeIndex] = code;
+	return outputIndex;
+}
+
+bool SerialConnection::write(const void *buffer, size_t length)
+{
+	if (length > maxPackageSize)
+		return false;
+	size_t frameSize = encode((const uint8_t *)buffer, length, txBuffer);
+	txBuffer[frameSize++] = 0;
+	return stream.write(txBuffer, frameSize) == frameSize;
+}
@@ -0,0 +1,226 @@
+#include "Connections/SimulatedConnection.h"
+
+#if defined(ARDUINO_ARCH_NATIVE)
+
+#include <string.h>
+
+uint32_t SimulatedConnection::clock = 0;
+
+SimulatedConnection::SimulatedConnection(uint32_t seed) : randomState(seed ? seed : 1) // xorshift must not start at 0
+{
+	memset(packets, 0, sizeof packets);
+}
+
+SimulatedConnection::SimulatedConnection(SimulatedConnection &peer, uint32_t seed) : SimulatedConnection(seed)
+{
+	pair(peer);
+}
+
+void SimulatedConnection::pair(SimulatedConnection &peer)
+{
+	this->peer = &peer;
+	peer.peer = this;
+}
+
+void SimulatedConnection::setChannel(const Channel &channel)
+{
+	this->channel = channel;
+}
+
+void SimulatedConnection::setAsyncWrites(bool enable)
+{
+	capabilities = enable ? capabilities | AsyncWrite : capabilities & ~AsyncWrite;
+}
+
+void SimulatedConnection::setMaxPackageSize(size_t size)
+{
+	maxPackageSize = size < REMOTECONTROLLER_SIMULATED_PACKET_SIZE ? size : REMOTECONTROLLER_SIMULATED_PACKET_SIZE;
+}
+
+size_t SimulatedConnection::queuedPackets() const
+{
+	size_t count = 0;
+	for (size_t i = 0; i < REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH; i++)
+	{
+		count += packets[i].used;
+	}
+	return count;
+}
+
+void SimulatedConnection::resetCounters()
+{
+	packetsWritten = 0;
+	packetsLost = 0;
+	acksLost = 0;
+	packetsDuplicated = 0;
+	packetsDropped = 0;
+	packetsRead = 0;
+	bytesRead = 0;
+}
+
+uint32_t SimulatedConnection::now()
+{
+	return clock;
+}
+
+void SimulatedConnection::advance(uint32_t micros)
+{
+	clock += micros;
+}
+
+void SimulatedConnection::useVirtualClock(bool enable)
+{
+	rcmicrosSource() = enable ? &SimulatedConnection::now : nullptr;
+}
+
+bool SimulatedConnection::begin()
+{
+	isBegun = true;
+	return true;
+}
+
+void SimulatedConnection::end()
+{
+	isBegun = false;
+	for (size_t i = 0; i < REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH; i++)
+	{
+		packets[i].used = false;
+	}
+}
+
+bool SimulatedConnection::available()
+{
+	return nextPacket() != nullptr;
+}
+
+void SimulatedConnection::read(void *buffer, size_t length)
+{
+	Packet *packet = nextPacket();
+	if (!packet)
+		return;
+	memcpy(buffer, packet->data, length < packet->length ? length : packet->length);
+	packet->used = false;
+	packetsRead++;
+	bytesRead += packet->length;
+}
+
+size_t SimulatedConnection::getPayloadSize()
+{
+	Packet *packet = nextPacket();
+	return packet ? packet->length : 0;
+}
+
+bool SimulatedConnection::write(const void *buffer, size_t length)
+{
+	if (length > maxPackageSize)
+		return false;
+	advance(airtime(length)); // The write blocks until the packet is on the air
+	return transmit(buffer, length, clock);
+}
+
+bool SimulatedConnection::startWrite(const void *buffer, size_t length)
+{
+	if (length > maxPackageSize || writeStatus == WritePending)
+		return false;
+	// The outcome is decided right away, it is reported (and the packet can be read) after the airtime
+	writeDone = clock + airtime(length);
+	writeResult = transmit(buffer, length, writeDone) ? WriteSucceeded : WriteFailed;
+	writeStatus = WritePending;
+	return true;
+}
+
+Connection::WriteStatus SimulatedConnection::pollWrite()
+{
+	if (writeStatus == WritePending && (int32_t)(clock - writeDone) >= 0)
+	{
+		writeStatus = writeResult;
+	}
+	return writeStatus;
+}
+
+uint32_t SimulatedConnection::airtime(size_t length)
+{
+	return channel.bytesPerSecond ? (uint32_t)((uint64_t)length * 1000000 / channel.bytesPerSecond) : 0;
+}
+
+bool SimulatedConnection::transmit(const void *buffer, size_t length, uint32_t sent)
+{
+	packetsWritten++;
+	// Nobody listening: like a radio without ack the write fails
+	if (!peer || !peer->isBegun || nextRandom() < channel.loss)
+	{
+		packetsLost++;
+		return false;
+	}
+
+	uint32_t arrival = sent + channel.latencyMicros + (uint32_t)(nextRandom() * channel.jitterMicros);
+	if (!peer->deliver(buffer, length, arrival))
+	{
+		packetsDropped++;
+		return false; // No ack from a full receiver
+	}
+	if (nextRandom() < channel.duplicate)
+	{
+		packetsDuplicated++;
+		arrival = sent + channel.latencyMicros + (uint32_t)(nextRandom() * channel.jitterMicros);
+		if (!peer->deliver(buffer, length, arrival))
+			packetsDropped++;
+	}
+	if (nextRandom() < channel.ackLoss)
+	{
+		acksLost++;
+		return false;
+	}
+	return true;
+}
+
+size_t SimulatedConnection::getMaxPackageSize()
+{
+	return maxPackageSize;
+}
+
+float SimulatedConnection::nextRandom()
+{
+	// xorshift32: the same sequence for a seed on every platform (unlike the std::random distributions)
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (randomState >> 8) / 16777216.0f; // 24 bit in [0.0, 1.0)
+}
+
+bool SimulatedConnection::deliver(const void *buffer, size_t length, uint32_t arrival)
+{
+	for (size_t i = 0; i < REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH; i++)
+	{
+		Packet &packet = packets[i];
+		if (!packet.used)
+		{
+			memcpy(packet.data, buffer, length);
+			packet.length = length;
+			packet.arrival = arrival;
+			packet.sequence = sequence++;
+			packet.used = true;
+			return true;
+		}
+	}
+	return false;
+}
+
+SimulatedConnection::Packet *SimulatedConnection::nextPacket()
+{
+	// The packet that arrived first (and was written first on a tie)
+	Packet *next = nullptr;
+	for (size_t i = 0; i < REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH; i++)
+	{
+		Packet &packet = packets[i];
+		if (!packet.used || (int32_t)(clock - packet.arrival) < 0)
+			continue;
+		if (!next || (int32_t)(packet.arrival - next->arrival) < 0 || (packet.arrival == next->arrival && (int32_t)(packet.sequence - next->sequence) < 0))
+		{
+			next = &packet;
+		}
+	}
+	return next;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include "Connections/UdpConnection.h"
+#include "RemoteControllerConfig.h"
+
+#if defined(ARDUINO_ARCH_NATIVE) && (defined(__unix__) || defined(__APPLE__))
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UdpConnection::UdpConnection(uint16_t localPort) : localPort(localPort)
+{
+	memset(&remote, 0, sizeof remote);
+#if defined(__linux__)
+	capabilities = BatchWrite;
+#endif
+}
+
+UdpConnection::~UdpConnection()
+{
+	end();
+}
+
+bool UdpConnection::setRemote(const char *host, uint16_t port)
+{
+	addrinfo hints;
+	memset(&hints, 0, sizeof hints);
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo *result = nullptr;
+	if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr)
+		return false;
+	memcpy(&remote, result->ai_addr, sizeof remote);
+	freeaddrinfo(result);
+	remote.sin_port = htons(port);
+	remoteFixed = true;
+	remoteKnown = true;
+	return true;
+}
+
+uint16_t UdpConnection::getLocalPort() const
+{
+	sockaddr_in address;
+	socklen_t length = sizeof address;
+	if (socketFd < 0 || getsockname(socketFd, (sockaddr *)&address, &length) != 0)
+		return 0;
+	return ntohs(address.sin_port);
+}
+
+void UdpConnection::setMaxPackageSize(size_t size)
+{
+	maxPackageSize = size < REMOTECONTROLLER_UDP_PACKET_SIZE ? size : REMOTECONTROLLER_UDP_PACKET_SIZE;
+}
+
+size_t UdpConnection::getMaxPackageSize()
+{
+	return maxPackageSize;
+}
+
+bool UdpConnection::begin()
+{
+	end();
+	socketFd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (socketFd < 0)
+		return false;
+	fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL) | O_NONBLOCK);
+	const int reuse = 1;
+	setsockopt(socketFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(localPort);
+	if (bind(socketFd, (const sockaddr *)&address, sizeof address) != 0)
+	{
+		end();
+		return false;
+	}
+	if (!remoteFixed)
+	{
+		remoteKnown = false; // Learned again from the first datagram
+	}
+	return true;
+}
+
+void UdpConnection::end()
+{
+	if (socketFd >= 0)
+	{
+		close(socketFd);
+	}
+	socketFd = -1;
+	packetReady = false;
+}
+
+bool UdpConnection::available()
+{
+	// Keep the datagram until it is read, drop the ones the RemoteController must not see
+	while (!packetReady && socketFd >= 0)
+	{
+		sockaddr_in source;
+		socklen_t sourceLength = sizeof source;
+		const ssize_t received = recvfrom(socketFd, rxBuffer, sizeof rxBuffer, 0, (sockaddr *)&source, &sourceLength);
+		if (received < 0)
+			break; // EAGAIN: nothing received (errors of earlier writes are ignored as well)
+		if ((size_t)received > maxPackageSize || received == 0 || (remoteFixed && (source.sin_addr.s_addr != remote.sin_addr.s_addr || source.sin_port != remote.sin_port)))
+		{
+			datagramsDropped++;
+			continue;
+		}
+		if (!remoteFixed)
+		{
+			remote = source;
+			remoteKnown = true;
+		}
+		rxLength = (size_t)received;
+		packetReady = true;
+		packetsReceived++;
+	}
+	return packetReady;
+}
+
+bool UdpConnection::waitForPacket(int timeoutMillis)
+{
+	if (available())
+		return true;
+	if (socketFd < 0)
+		return false;
+	pollfd descriptor = {socketFd, POLLIN, 0};
+	poll(&descriptor, 1, timeoutMillis);
+	return available();
+}
+
+void UdpConnection::read(void *buffer, size_t length)
+{
+	if (!packetReady)
+		return;
+	memcpy(buffer, rxBuffer, length < rxLength ? length : rxLength);
+	packetReady = false;
+}
+
+size_t UdpConnection::getPayloadSize()
+{
+	return packetReady ? rxLength : 0;
+}
+
+bool UdpConnection::waitWritable()
+{
+	// The kernel send buffer is full (high rate soak tests), it drains within microseconds on a local network
+	pollfd descriptor = {socketFd, POLLOUT, 0};
+	return poll(&descriptor, 1, 100) == 1;
+}
+
+bool UdpConnection::write(const void *buffer, size_t length)
+{
+	if (socketFd < 0 || !remoteKnown || length > maxPackageSize)
+		return false;
+	for (int attempt = 0; attempt < 2; attempt++)
+	{
+		const ssize_t sent = sendto(socketFd, buffer, length, 0, (const sockaddr *)&remote, sizeof remote);
+		if (sent >= 0)
+			return (size_t)sent == length;
+		if ((errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) || !waitWritable())
+			return false;
+	}
+	return false;
+}
+
+size_t UdpConnection::writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+{
+#if defined(__linux__)
+	if (socketFd < 0 || !remoteKnown)
+		return 0;
+	mmsghdr messages[REMOTECONTROLLER_MAX_BATCH_SIZE];
+	iovec vectors[REMOTECONTROLLER_MAX_BATCH_SIZE];
+	size_t sent = 0;
+	int attempts = 0; // Calls in a row that did not send anything
+	while (sent < count && attempts < 2)
+	{
+		// Packets after an oversized one are not transmitted, like after a failed write
+		size_t batch = 0;
+		while (batch < REMOTECONTROLLER_MAX_BATCH_SIZE && sent + batch < count && lengths[sent + batch] <= maxPackageSize)
+		{
+			vectors[batch].iov_base = const_cast<void *>(buffers[sent + batch]);
+			vectors[batch].iov_len = lengths[sent + batch];
+			memset(&messages[batch], 0, sizeof messages[batch]);
+			messages[batch].msg_hdr.msg_name = &remote;
+			messages[batch].msg_hdr.msg_namelen = sizeof remote;
+			messages[batch].msg_hdr.msg_iov = &vectors[batch];
+			messages[batch].msg_hdr.msg_iovlen = 1;
+			batch++;
+		}
+		if (batch == 0)
+			return sent;
+		const int written = sendmmsg(socketFd, messages, (unsigned int)batch, 0);
+		if (written > 0)
+		{
+			sent += (size_t)written;
+			attempts = 0;
+			continue;
+		}
+		attempts++;
+		if ((errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) || !waitWritable())
+			return sent;
+	}
+	return sent;
+#else
+	return Connection::writeBatch(buffers, lengths, count);
+#endif
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "NativeStream.h"
+
+#if defined(ARDUINO_ARCH_NATIVE) && (defined(__unix__) || defined(__APPLE__))
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+FdStream::FdStream(int fd) : fd(-1)
+{
+	open(fd);
+}
+
+FdStream::~FdStream()
+{
+	close();
+}
+
+void FdStream::open(int fd)
+{
+	close();
+	this->fd = fd;
+	if (fd >= 0)
+	{
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	}
+}
+
+void FdStream::close()
+{
+	if (fd >= 0)
+	{
+		::close(fd);
+	}
+	fd = -1;
+	head = 0;
+	count = 0;
+}
+
+int FdStream::getFd() const
+{
+	return fd;
+}
+
+bool FdStream::openPtyPair(FdStream &master, FdStream &slave)
+{
+	int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (masterFd < 0)
+		return false;
+	if (grantpt(masterFd) != 0 || unlockpt(masterFd) != 0)
+	{
+		::close(masterFd);
+		return false;
+	}
+	int slaveFd = ::open(ptsname(masterFd), O_RDWR | O_NOCTTY);
+	if (slaveFd < 0)
+	{
+		::close(masterFd);
+		return false;
+	}
+	// Raw mode: no line buffering, echo or translation of the bytes (e.g. CR to NL)
+	struct termios settings;
+	tcgetattr(slaveFd, &settings);
+	cfmakeraw(&settings);
+	tcsetattr(slaveFd, TCSANOW, &settings);
+
+	master.open(masterFd);
+	slave.open(slaveFd);
+	return true;
+}
+
+bool FdStream::fill()
+{
+	if (count != 0)
+		return true;
+	if (fd < 0)
+		return false;
+	ssize_t received = ::read(fd, buffer, sizeof buffer);
+	if (received <= 0)
+		return false;
+	head = 0;
+	count = (size_t)received;
+	return true;
+}
+
+int FdStream::available()
+{
+	int pending = 0;
+	if (fd >= 0 && ioctl(fd, FIONREAD, &pending) != 0)
+	{
+		pending = 0;
+	}
+	return (int)count + pending;
+}
+
+int FdStream::read()
+{
+	if (!fill())
+		return -1;
+	count--;
+	return buffer[head++];
+}
+
+size_t FdStream::write(const uint8_t *buffer, size_t size)
+{
+	size_t written = 0;
+	while (fd >= 0 && written < size)
+	{
+		ssize_t result = ::write(fd, buffer + written, size - written);
+		if (result > 0)
+		{
+			written += (size_t)result;
+			continue;
+		}
+		if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			break;
+		// Kernel buffer full, wait until the other end read some bytes
+		struct pollfd writable = {fd, POLLOUT, 0};
+		if (poll(&writable, 1, 100) <= 0)
+			break;
+	}
+	return written;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "PacketRing.h"
+
+const uint8_t PacketRing::Length;
+const size_t PacketRing::PacketSize;
+
+static_assert(PacketRing::Length != 0 && PacketRing::Length <= 128 && (PacketRing::Length & (PacketRing::Length - 1)) == 0, "REMOTECONTROLLER_RECEIVE_RING_LENGTH has to be a power of two (max. 128)");
+
+// Load order matters: the producer reads head (freed slots) before writing a slot, the consumer reads tail (published slots) before reading a slot.
+// std::atomic defaults to sequentially consistent accesses, volatile on AVR keeps the compiler from reordering them.
+
+uint8_t *PacketRing::reserve()
+{
+	const uint8_t currentTail = tail;
+	if ((uint8_t)(currentTail - head) >= Length)
+	{
+		drops = drops + 1; // Only the producer writes the counter
+		return nullptr;
+	}
+	return packets[currentTail & (Length - 1)];
+}
+
+void PacketRing::commit(size_t length)
+{
+	const uint8_t currentTail = tail;
+	lengths[currentTail & (Length - 1)] = (uint8_t)(length < PacketSize ? length : PacketSize);
+	tail = (uint8_t)(currentTail + 1); // Publishes the slot
+	const uint8_t waiting = (uint8_t)(currentTail + 1 - head);
+	if (waiting > watermark)
+	{
+		watermark = waiting;
+	}
+}
+
+bool PacketRing::empty() const
+{
+	return head == tail;
+}
+
+const uint8_t *PacketRing::front() const
+{
+	return packets[head & (Length - 1)];
+}
+
+size_t PacketRing::frontLength() const
+{
+	return lengths[head & (Length - 1)];
+}
+
+void PacketRing::pop()
+{
+	head = (uint8_t)(head + 1); // Frees the slot
+}
+
+uint8_t PacketRing::size() const
+{
+	return (uint8_t)(tail - head);
+}
+
+uint8_t PacketRing::highWatermark() const
+{
+	return watermark;
+}
+
+uint32_t PacketRing::overflowDrops() const
+{
+	return drops;
+}
+
+void PacketRing::resetStatistics()
+{
+	watermark = 0;
+	drops = 0;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// Shared helpers for the native benchmarks (run with: pio test -e bench_native -v)
+
+inline uint64_t benchNanos()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Collects samples (e.g. latencies in ns) and reports percentiles
+ *
+ */
+class BenchSamples
+{
+public:
+	void reserve(size_t n) { samples.reserve(n); }
+	void add(uint64_t sample) { samples.push_back(sample); }
+	void add(const BenchSamples &other) { samples.insert(samples.end(), other.samples.begin(), other.samples.end()); } // e.g. the samples of several threads
+	size_t size() const { return samples.size(); }
+	void clear() { samples.clear(); }
+
+	double mean() const
+	{
+		uint64_t sum = 0;
+		for (uint64_t sample : samples)
+			sum += sample;
+		return samples.empty() ? 0 : (double)sum / samples.size();
+	}
+
+	uint64_t percentile(double p)
+	{
+		if (samples.empty())
+			return 0;
+		std::sort(samples.begin(), samples.end());
+		size_t index = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+		return samples[index];
+	}
+
+	void print(const char *name)
+	{
+		printf("%-32s n=%zu p50=%llu p90=%llu p99=%llu max=%llu ns\n", name, samples.size(),
+			   (unsigned long long)percentile(50), (unsigned long long)percentile(90),
+			   (unsigned long long)percentile(99), (unsigned long long)percentile(100));
+	}
+
+private:
+	std::vector<uint64_t> samples;
+};
+
+inline double benchPerSecond(uint64_t count, uint64_t nanos)
+{
+	return nanos ? (double)count * 1e9 / (double)nanos : 0;
+}
+
+/**
+ * @brief Collects named results and writes them as JSON, so runs of different releases can be compared by a script
+ *
+ * @code
+ * {"benchmark": "hotpaths", "label": "v1.1.0", "compiler": "13.2.0", "results": [
+ *   {"name": "encodeCommand", "protocol": 1, "packageSize": 32, "fill": 100, "nsPerCommand": 1.52, "allocationsPerCommand": 0}
+ * ]}
+ * @endcode
+ */
+class BenchReport
+{
+public:
+	BenchReport(const char *benchmark) : benchmark(benchmark) {}
+
+	/**
+	 * @brief Starts a result, add its values with BenchReport::value()
+	 *
+	 */
+	void result(const char *name)
+	{
+		results.push_back("{\"name\": \"" + std::string(name) + "\"");
+	}
+
+	void value(const char *key, double value)
+	{
+		char text[64];
+		snprintf(text, sizeof text, ", \"%s\": %.6g", key, value);
+		results.back() += text;
+	}
+
+	/**
+	 * @brief Writes the report, the label (e.g. the release) is taken from the RC_BENCH_LABEL environment variable
+	 *
+	 * @return true the file was written
+	 */
+	bool write(const char *path)
+	{
+		FILE *file = fopen(path, "w");
+		if (!file)
+			return false;
+		const char *label = getenv("RC_BENCH_LABEL");
+		fprintf(file, "{\"benchmark\": \"%s\", \"label\": \"%s\", \"compiler\": \"%s\", \"results\": [\n", benchmark, label ? label : "", __VERSION__);
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			fprintf(file, "  %s}%s\n", results[i].c_str(), i + 1 < results.size() ? "," : "");
+		}
+		fprintf(file, "]}\n");
+		return fclose(file) == 0;
+	}
+
+private:
+	const char *benchmark;
+	std::vector<std::string> results;
+};
+
+/**
+ * @brief CPU cycle counter (time stamp counter on x86, 0 where not available)
+ *
+ */
+inline uint64_t benchCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
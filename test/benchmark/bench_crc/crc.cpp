@@ -0,0 +1,156 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Crc.h"
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+#include "../Benchmark.h"
+
+// Cost of the frame check (RemoteController::setFrameCheck()) per packet: the CRC variants of Crc and a bitwise CRC-8 without table as reference
+
+#define BENCH_PACKETS 2000000UL
+#define BENCH_ROUNDS 5 // The variants run alternately, the fastest round counts
+#define BENCH_PACKET_SIZE 32 // bytes, a full NRF24L01 packet
+
+static uint8_t crc8Bitwise(const uint8_t *data, size_t length)
+{
+	uint8_t crc = 0x00;
+	for (size_t i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = crc & 0x80 ? (uint8_t)(crc << 1) ^ 0x07 : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+struct CrcResult
+{
+	uint64_t nanos = UINT64_MAX;
+	uint64_t cycles = UINT64_MAX;
+	uint32_t checksum = 0; // Keeps the compiler from dropping the calls
+};
+
+template <class Checksum>
+static void benchCrc(Checksum crc, uint8_t packets[][BENCH_PACKET_SIZE], size_t packetCount, CrcResult &result)
+{
+	uint32_t checksum = 0;
+	uint64_t startNanos = benchNanos();
+	uint64_t startCycles = benchCycles();
+	for (size_t i = 0; i < BENCH_PACKETS; i++)
+	{
+		checksum += crc(packets[i % packetCount], BENCH_PACKET_SIZE);
+	}
+	uint64_t cycles = benchCycles() - startCycles;
+	uint64_t nanos = benchNanos() - startNanos;
+	result.nanos = nanos < result.nanos ? nanos : result.nanos;
+	result.cycles = cycles < result.cycles ? cycles : result.cycles;
+	result.checksum = checksum;
+}
+
+static void printCrc(const char *name, const CrcResult &result, size_t tableBytes)
+{
+	printf("%-28s %8.1f ns/packet %8.1f cycles/packet %5zu bytes of tables\n", name, (double)result.nanos / BENCH_PACKETS, (double)result.cycles / BENCH_PACKETS, tableBytes);
+}
+
+void test_crc_perPacket()
+{
+	static uint8_t packets[64][BENCH_PACKET_SIZE];
+	for (size_t i = 0; i < sizeof packets; i++)
+	{
+		packets[i / BENCH_PACKET_SIZE][i % BENCH_PACKET_SIZE] = (uint8_t)(i * 131 + 7);
+	}
+
+	CrcResult bitwise, crc8Table, crc8Nibbles, crc16Table, crc16Nibbles;
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		benchCrc(crc8Bitwise, packets, 64, bitwise);
+		benchCrc(Crc::crc8ByteTable, packets, 64, crc8Table);
+		benchCrc(Crc::crc8Nibbles, packets, 64, crc8Nibbles);
+		benchCrc(Crc::crc16ByteTable, packets, 64, crc16Table);
+		benchCrc(Crc::crc16Nibbles, packets, 64, crc16Nibbles);
+	}
+	TEST_ASSERT_EQUAL_UINT32(bitwise.checksum, crc8Table.checksum);
+	TEST_ASSERT_EQUAL_UINT32(bitwise.checksum, crc8Nibbles.checksum);
+	TEST_ASSERT_EQUAL_UINT32(crc16Table.checksum, crc16Nibbles.checksum);
+
+	printf("%d byte packets\n", BENCH_PACKET_SIZE);
+	printCrc("CRC-8 bitwise", bitwise, 0);
+	printCrc("CRC-8 byte table", crc8Table, 256);
+	printCrc("CRC-8 nibble table (AVR)", crc8Nibbles, 16);
+	printCrc("CRC-16 byte table", crc16Table, 512);
+	printCrc("CRC-16 nibble table (AVR)", crc16Nibbles, 32);
+}
+
+static size_t commandsReceived;
+
+static uint64_t benchRoundTrip(RemoteController::FrameCheck check)
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { commandsReceived += length; });
+	sender.setFrameCheck(check);
+	receiver.setFrameCheck(check);
+	commandsReceived = 0;
+
+	uint64_t start = benchNanos();
+	for (size_t i = 0; i < BENCH_PACKETS / 10; i++)
+	{
+		for (uint8_t command = 0; command < 5; command++)
+		{
+			sender.sendCommand(command, (float)i);
+		}
+		sender.run();
+		receiver.run();
+	}
+	uint64_t nanos = benchNanos() - start;
+	TEST_ASSERT_EQUAL_UINT32(BENCH_PACKETS / 10 * 5, commandsReceived);
+	sender.end();
+	receiver.end();
+	return nanos;
+}
+
+void test_crc_roundTrip()
+{
+	// A full packet (5 commands) sent, received and decoded, with and without the frame check
+	const RemoteController::FrameCheck checks[3] = {RemoteController::NoFrameCheck, RemoteController::Crc8, RemoteController::Crc16};
+	const char *names[3] = {"no frame check", "CRC-8", "CRC-16"};
+	uint64_t best[3] = {UINT64_MAX, UINT64_MAX, UINT64_MAX};
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		for (size_t c = 0; c < 3; c++)
+		{
+			uint64_t nanos = benchRoundTrip(checks[c]);
+			best[c] = nanos < best[c] ? nanos : best[c];
+		}
+	}
+	for (size_t c = 0; c < 3; c++)
+	{
+		printf("%-28s %8.1f ns/packet (send + receive)\n", names[c], (double)best[c] / (BENCH_PACKETS / 10));
+	}
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_crc_perPacket);
+	RUN_TEST(test_crc_roundTrip);
+
+	UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+#include "../Benchmark.h"
+
+// Virtual (RemoteController over Connection&) vs. static dispatch (RemoteControllerT bound to a final Connection class) in the run() hot path
+
+#define BENCH_ITERATIONS 1000000UL
+#define BENCH_ROUNDS 5 // The variants run alternately, the fastest round counts
+
+/**
+ * @brief Header only Connection without any I/O: every run() receives one command packet and every write succeeds, so only the RemoteController overhead is measured
+ *
+ */
+class InlineConnection final : public Connection
+{
+public:
+	bool begin() { return true; }
+	void end() {}
+	bool available() { return pending; }
+	void read(void *buffer, size_t length)
+	{
+		memcpy(buffer, packet, length < sizeof packet ? length : sizeof packet);
+		pending = false;
+	}
+	size_t getPayloadSize() { return sizeof packet; }
+	bool write(const void *buffer, size_t length)
+	{
+		bytesWritten += length;
+		pending = true; // "Echo" one packet per write
+		return true;
+	}
+	size_t getMaxPackageSize() { return 32; }
+
+	size_t bytesWritten = 0;
+
+private:
+	bool pending = false;
+	const uint8_t packet[7] = {(uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND >> 8), (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND, 1, 0, 0, 0, 0};
+};
+
+static size_t commandsReceived;
+
+struct DispatchResult
+{
+	uint64_t nanos = UINT64_MAX;
+	uint64_t cycles = UINT64_MAX;
+};
+
+template <class Controller>
+static void benchDispatch(Controller &rc, DispatchResult &result)
+{
+	commandsReceived = 0;
+	rc.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+			 { commandsReceived += length; });
+
+	uint64_t startNanos = benchNanos();
+	uint64_t startCycles = benchCycles();
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++)
+	{
+		rc.sendCommand((uint8_t)i, (float)i);
+		rc.run();
+	}
+	uint64_t cycles = benchCycles() - startCycles;
+	uint64_t nanos = benchNanos() - startNanos;
+
+	TEST_ASSERT_EQUAL_UINT32(BENCH_ITERATIONS, commandsReceived);
+	result.nanos = nanos < result.nanos ? nanos : result.nanos;
+	result.cycles = cycles < result.cycles ? cycles : result.cycles;
+	rc.end();
+}
+
+static void printDispatch(const char *name, const DispatchResult &result)
+{
+	printf("%-28s %8.1f ns/run() %8.1f cycles/run()\n", name, (double)result.nanos / BENCH_ITERATIONS, (double)result.cycles / BENCH_ITERATIONS);
+}
+
+void test_dispatch()
+{
+	InlineConnection connection;
+	RemoteController virtualController(connection);										  // Calls through Connection &
+	RemoteControllerT<RemoteControllerDefaultConfig, InlineConnection> staticController(connection); // Calls resolved at compile time
+
+	DispatchResult virtualResult, staticResult;
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		benchDispatch(virtualController, virtualResult);
+		benchDispatch(staticController, staticResult);
+	}
+	printDispatch("virtual dispatch", virtualResult);
+	printDispatch("static dispatch", staticResult);
+	printf("%-28s %8.2fx\n", "static/virtual speedup", (double)virtualResult.nanos / staticResult.nanos);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_dispatch);
+
+	UNITY_END();
+}
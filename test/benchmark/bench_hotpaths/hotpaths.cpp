@@ -0,0 +1,290 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#include "RemoteController.h"
+#include "../Benchmark.h"
+
+// Microbenchmarks of the hot paths: encodeCommand(), addToCommandQueue(), the packing in transmitCommands() and the decoding in run(), for 32, 64 and 256 byte packages and different fill levels.
+// Reports ns/command and heap allocations/command (has to be 0) and writes the results as JSON to RC_BENCH_JSON (default bench_hotpaths.json), label the run with RC_BENCH_LABEL.
+
+#define BENCH_COMMANDS 200000UL // per measurement
+#define BENCH_ROUNDS 3			// The fastest round counts
+#define BENCH_DECODE_PACKETS 8	// packets received per run() call
+
+// Every heap allocation of the benchmark process is counted
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+	allocations++;
+	void *memory = malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+	free(memory);
+}
+
+/**
+ * @brief Connection without any I/O: writes succeed (the next one can be kept as the packet to receive), the kept packet is received BENCH_DECODE_PACKETS times per HotPathConnection::feed() call
+ *
+ */
+class HotPathConnection final : public Connection
+{
+public:
+	HotPathConnection(size_t maxPackageSize) : maxPackageSize(maxPackageSize) {}
+	bool begin() { return true; }
+	void end() {}
+	bool available() { return pending > 0; }
+	void read(void *buffer, size_t length)
+	{
+		memcpy(buffer, packet, length < packetLength ? length : packetLength);
+		pending--;
+	}
+	size_t getPayloadSize() { return packetLength; }
+	bool write(const void *buffer, size_t length)
+	{
+		if (keepNextWrite)
+		{
+			memcpy(packet, buffer, length);
+			packetLength = length;
+			keepNextWrite = false;
+		}
+		packetsWritten++;
+		return true;
+	}
+	size_t getMaxPackageSize() { return maxPackageSize; }
+	void feed() { pending = BENCH_DECODE_PACKETS; }
+
+	bool keepNextWrite = false;
+	size_t packetsWritten = 0;
+
+private:
+	size_t maxPackageSize;
+	uint8_t packet[256];
+	size_t packetLength = 0;
+	size_t pending = 0;
+};
+
+struct HotPathResult
+{
+	uint64_t nanos = UINT64_MAX;
+	size_t commands = 0;
+	size_t allocations = 0; // of all rounds
+	size_t allocationCommands = 0;
+
+	void round(uint64_t roundNanos, size_t roundAllocations, size_t roundCommands)
+	{
+		if (roundNanos / (double)roundCommands < nanos / (double)(commands ? commands : 1))
+		{
+			nanos = roundNanos;
+			commands = roundCommands;
+		}
+		allocations += roundAllocations;
+		allocationCommands += roundCommands;
+	}
+
+	double nsPerCommand() const { return (double)nanos / commands; }
+	double allocationsPerCommand() const { return (double)allocations / allocationCommands; }
+};
+
+static BenchReport report("hotpaths");
+static const float throttles[5] = {0.0f, 1.0f, 0.5f, 0.123f, -1.0f}; // Every throttle encoding of RemoteController-Protocol v2
+static const uint8_t fills[3] = {25, 50, 100};						  // percent
+
+static void printResult(const char *name, RemoteController::ProtocolVersion version, size_t packageSize, uint8_t fill, const HotPathResult &result)
+{
+	char label[48];
+	snprintf(label, sizeof label, "%s v%u %zu byte %u%%", name, version, packageSize, fill);
+	printf("%-36s %8.2f ns/command %8.3f allocations/command\n", label, result.nsPerCommand(), result.allocationsPerCommand());
+	report.result(name);
+	report.value("protocol", version);
+	report.value("packageSize", (double)packageSize);
+	report.value("fill", fill);
+	report.value("nsPerCommand", result.nsPerCommand());
+	report.value("allocationsPerCommand", result.allocationsPerCommand());
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(0, result.allocations, "The hot paths do not allocate!");
+}
+
+template <size_t PackageSize>
+static void benchEncode(RemoteController::ProtocolVersion version)
+{
+	HotPathConnection connection(PackageSize);
+	RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> rc(connection);
+	rc.begin(nullptr);
+	rc.setProtocolVersion(version);
+	uint8_t buffer[8];
+	size_t bytes = 0;
+	HotPathResult result;
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		const size_t allocationsBefore = allocations;
+		const uint64_t start = benchNanos();
+		for (size_t i = 0; i < BENCH_COMMANDS; i++)
+		{
+			bytes += rc.encodeCommand((uint8_t)i, throttles[i % 5], buffer);
+		}
+		result.round(benchNanos() - start, allocations - allocationsBefore, BENCH_COMMANDS);
+	}
+	TEST_ASSERT_TRUE(bytes > 0);
+	printResult("encodeCommand", version, PackageSize, 100, result);
+	rc.end();
+}
+
+template <size_t PackageSize>
+static void benchQueueAndPack(RemoteController::ProtocolVersion version, uint8_t fill)
+{
+	typedef RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> Controller;
+	HotPathConnection connection(PackageSize);
+	Controller rc(connection);
+	rc.begin(nullptr);
+	rc.setProtocolVersion(version);
+	const size_t commands = rcmax((size_t)1, Controller::CommandQueueLength * fill / 100);
+	const size_t fillings = BENCH_COMMANDS / commands;
+
+	// addToCommandQueue() fills the queue, transmitCommands() packs it into packets and empties it
+	HotPathResult queueResult, packResult;
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		uint64_t queueNanos = 0, packNanos = 0;
+		size_t queueAllocations = 0, packAllocations = 0;
+		for (size_t filling = 0; filling < fillings; filling++)
+		{
+			size_t allocationsBefore = allocations;
+			const uint64_t start = benchNanos();
+			for (size_t i = 0; i < commands; i++)
+			{
+				rc.addToCommandQueue(rc.makeQueuedCommand((uint8_t)i, throttles[i % 5], RemoteController::Normal, 0));
+			}
+			const uint64_t queued = benchNanos();
+			queueAllocations += allocations - allocationsBefore;
+			allocationsBefore = allocations;
+			TEST_ASSERT_TRUE(rc.transmitCommands());
+			packNanos += benchNanos() - queued;
+			packAllocations += allocations - allocationsBefore;
+			queueNanos += queued - start;
+		}
+		TEST_ASSERT_EQUAL_size_t(0, rc.commandQueueLength);
+		queueResult.round(queueNanos, queueAllocations, fillings * commands);
+		packResult.round(packNanos, packAllocations, fillings * commands);
+	}
+	printResult("addToCommandQueue", version, PackageSize, fill, queueResult);
+	printResult("transmitCommands", version, PackageSize, fill, packResult);
+	rc.end();
+}
+
+static size_t commandsDecoded;
+
+template <size_t PackageSize>
+static void benchDecode(RemoteController::ProtocolVersion version, uint8_t fill)
+{
+	typedef RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> Controller;
+	HotPathConnection connection(PackageSize);
+	Controller rc(connection);
+	rc.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+			 { commandsDecoded += length; });
+	rc.setProtocolVersion(version);
+	rc.setReceiveBudget(BENCH_DECODE_PACKETS);
+
+	// The packet to decode: the first packet of a queue filled to the fill level of one packet
+	const size_t perPacket = (PackageSize - 2) / REMOTECONTROLLER_ENCODED_COMMAND_SIZE;
+	const size_t commands = rcmax((size_t)1, perPacket * fill / 100);
+	for (size_t i = 0; i < commands; i++)
+	{
+		rc.sendCommand((uint8_t)i, throttles[i % 5]);
+	}
+	connection.keepNextWrite = true;
+	TEST_ASSERT_TRUE(rc.transmitCommands());
+
+	const size_t runs = BENCH_COMMANDS / (commands * BENCH_DECODE_PACKETS) + 1;
+	HotPathResult result;
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		commandsDecoded = 0;
+		const size_t allocationsBefore = allocations;
+		const uint64_t start = benchNanos();
+		for (size_t i = 0; i < runs; i++)
+		{
+			connection.feed();
+			rc.run();
+		}
+		const uint64_t nanos = benchNanos() - start;
+		TEST_ASSERT_EQUAL_size_t(runs * BENCH_DECODE_PACKETS * commands, commandsDecoded);
+		result.round(nanos, allocations - allocationsBefore, commandsDecoded);
+	}
+	printResult("run() decode", version, PackageSize, fill, result);
+	rc.end();
+}
+
+template <size_t PackageSize>
+static void benchPackageSize()
+{
+	const RemoteController::ProtocolVersion versions[2] = {RemoteController::ProtocolV1, RemoteController::ProtocolV2};
+	for (size_t v = 0; v < 2; v++)
+	{
+		benchEncode<PackageSize>(versions[v]);
+		for (size_t f = 0; f < sizeof fills; f++)
+		{
+			benchQueueAndPack<PackageSize>(versions[v], fills[f]);
+		}
+		for (size_t f = 0; f < sizeof fills; f++)
+		{
+			benchDecode<PackageSize>(versions[v], fills[f]);
+		}
+	}
+}
+
+void test_hotpaths_32()
+{
+	benchPackageSize<32>();
+}
+
+void test_hotpaths_64()
+{
+	benchPackageSize<64>();
+}
+
+void test_hotpaths_256()
+{
+	benchPackageSize<256>();
+}
+
+void test_hotpaths_report()
+{
+	const char *path = getenv("RC_BENCH_JSON");
+	path = path ? path : "bench_hotpaths.json";
+	TEST_ASSERT_TRUE_MESSAGE(report.write(path), "Failed to write the JSON report!");
+	printf("results written to %s\n", path);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_hotpaths_32);
+	RUN_TEST(test_hotpaths_64);
+	RUN_TEST(test_hotpaths_256);
+	RUN_TEST(test_hotpaths_report);
+
+	UNITY_END();
+}
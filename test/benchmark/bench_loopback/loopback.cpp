@@ -0,0 +1,195 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+#include "../Benchmark.h"
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::LargePayloads>> LargePayloadController; // RemoteController with RemoteController::sendLargePayload()
+
+// End-to-end benchmark of two RemoteControllers connected through a LoopbackConnection pair
+
+#define BENCH_COMMANDS 100000UL
+#define BENCH_PAYLOADS 100000UL
+#define BENCH_LARGE_PAYLOADS 1000UL
+
+static uint64_t sentAt[BENCH_COMMANDS];
+static BenchSamples latencies;
+static size_t commandsReceived = 0;
+
+static void drain(RemoteController &receiver, LoopbackConnection &connection)
+{
+	while (connection.available())
+	{
+		receiver.run();
+	}
+}
+
+static void benchCommands(size_t burst, RemoteController::ProtocolVersion version = RemoteController::ProtocolV1)
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+
+	commandsReceived = 0;
+	latencies.clear();
+	latencies.reserve(BENCH_COMMANDS);
+	sender.begin(nullptr);
+	sender.setProtocolVersion(version);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   {
+		uint64_t now = benchNanos();
+		for (size_t i = 0; i < length; i++)
+		{
+			latencies.add(now - sentAt[(size_t)throttles[i] * 256 + commands[i]]);
+		}
+		commandsReceived += length; });
+
+	uint64_t start = benchNanos();
+	for (size_t i = 0; i < BENCH_COMMANDS;)
+	{
+		for (size_t b = 0; b < burst && i < BENCH_COMMANDS; b++, i++)
+		{
+			sentAt[i] = benchNanos();
+			sender.sendCommand((uint8_t)i, (float)(i >> 8)); // Command and throttle carry the index to look up the send timestamp
+		}
+		sender.run();
+		drain(receiver, receiverConnection);
+	}
+	uint64_t elapsed = benchNanos() - start;
+
+	TEST_ASSERT_EQUAL_UINT32(BENCH_COMMANDS, commandsReceived);
+	printf("commands v%u burst=%-2zu             %10.0f commands/s %10.0f packets/s %6.2f bytes/command\n", version, burst,
+		   benchPerSecond(commandsReceived, elapsed), benchPerSecond(senderConnection.packetsWritten, elapsed),
+		   (double)senderConnection.bytesWritten / commandsReceived);
+	char name[32];
+	snprintf(name, sizeof name, "latency v%u burst=%zu", version, burst);
+	latencies.print(name);
+
+	sender.end();
+	receiver.end();
+}
+
+void test_commands_single()
+{
+	benchCommands(1);
+}
+
+void test_commands_burst()
+{
+	benchCommands(6);
+}
+
+void test_commands_queue_full()
+{
+	benchCommands(REMOTECONTROLLER_COMMAND_QUEUE_LENGTH);
+}
+
+void test_commands_burst_v2()
+{
+	benchCommands(6, RemoteController::ProtocolV2);
+}
+
+void test_commands_queue_full_v2()
+{
+	benchCommands(REMOTECONTROLLER_COMMAND_QUEUE_LENGTH, RemoteController::ProtocolV2);
+}
+
+void test_payloads()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+
+	static size_t bytesReceived;
+	bytesReceived = 0;
+	sender.begin(nullptr);
+	receiver.begin(nullptr, [](const void *buffer, size_t length) -> void
+				   { bytesReceived += length; });
+
+	uint8_t payload[32];
+	for (size_t i = 0; i < sizeof payload; i++)
+	{
+		payload[i] = (uint8_t)i;
+	}
+
+	uint64_t start = benchNanos();
+	for (size_t i = 0; i < BENCH_PAYLOADS; i++)
+	{
+		sender.sendPayload(payload, sizeof payload);
+		drain(receiver, receiverConnection);
+	}
+	uint64_t elapsed = benchNanos() - start;
+
+	TEST_ASSERT_EQUAL_UINT32(BENCH_PAYLOADS * sizeof payload, bytesReceived);
+	printf("payloads 32 byte                   %10.0f packets/s %10.0f bytes/s\n",
+		   benchPerSecond(BENCH_PAYLOADS, elapsed), benchPerSecond(bytesReceived, elapsed));
+
+	sender.end();
+	receiver.end();
+}
+
+void test_large_payloads()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+
+	static uint8_t payload[6000];
+	static uint8_t reassembled[sizeof payload];
+	static size_t payloadsReceived;
+	payloadsReceived = 0;
+	sender.begin(nullptr);
+	receiver.begin(nullptr, [](const void *buffer, size_t length) -> void
+				   { payloadsReceived++; });
+	receiver.setLargePayloadBuffer(reassembled, sizeof reassembled);
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+	sender.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+
+	uint64_t start = benchNanos();
+	for (size_t i = 0; i < BENCH_LARGE_PAYLOADS; i++)
+	{
+		sender.sendLargePayload(payload, sizeof payload);
+		while (sender.isSendingLargePayload())
+		{
+			sender.run();
+			receiver.run();
+		}
+	}
+	uint64_t elapsed = benchNanos() - start;
+
+	TEST_ASSERT_EQUAL_UINT32(BENCH_LARGE_PAYLOADS, payloadsReceived);
+	printf("large payloads %zu byte           %10.0f bytes/s   %6.2f packets/fragment (incl. acks)\n", sizeof payload,
+		   benchPerSecond(BENCH_LARGE_PAYLOADS * sizeof payload, elapsed),
+		   (double)(senderConnection.packetsWritten + receiverConnection.packetsWritten) / (BENCH_LARGE_PAYLOADS * sender.getTransferStats().fragments));
+
+	sender.end();
+	receiver.end();
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_commands_single);
+	RUN_TEST(test_commands_burst);
+	RUN_TEST(test_commands_queue_full);
+	RUN_TEST(test_commands_burst_v2);
+	RUN_TEST(test_commands_queue_full_v2);
+	RUN_TEST(test_payloads);
+	RUN_TEST(test_large_payloads);
+
+	UNITY_END();
+}
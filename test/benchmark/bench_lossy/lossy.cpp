@@ -0,0 +1,170 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/SimulatedConnection.h"
+#include "../Benchmark.h"
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::LargePayloads>> LargePayloadController; // RemoteController with RemoteController::sendLargePayload()
+
+// Goodput and command latency of two RemoteControllers over a lossy SimulatedConnection channel (virtual time, reproducible)
+
+#define BENCH_COMMANDS 20000UL
+#define BENCH_COMMAND_INTERVAL 1000 // us between two commands
+#define BENCH_STEP 100				// us between two run() calls
+#define BENCH_LARGE_PAYLOAD 4000	// bytes
+
+static uint32_t sentAt[BENCH_COMMANDS];
+static bool received[BENCH_COMMANDS];
+static BenchSamples latencies;
+static size_t commandsReceived;
+static size_t duplicates;
+
+/**
+ * @brief A 1 Mbit/s radio link with the given packet loss, a quarter as many acks get lost
+ *
+ */
+static SimulatedConnection::Channel radioChannel(float loss)
+{
+	SimulatedConnection::Channel channel;
+	channel.loss = loss;
+	channel.ackLoss = loss / 4;
+	channel.latencyMicros = 300;
+	channel.jitterMicros = 200;
+	channel.bytesPerSecond = 125000;
+	return channel;
+}
+
+static void benchCommandsUnderLoss(float loss)
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection(1);
+	SimulatedConnection receiverConnection(senderConnection, 2);
+	senderConnection.setChannel(radioChannel(loss));
+	receiverConnection.setChannel(radioChannel(loss));
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+
+	commandsReceived = 0;
+	duplicates = 0;
+	latencies.clear();
+	latencies.reserve(BENCH_COMMANDS);
+	memset(received, 0, sizeof received);
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   {
+		for (size_t i = 0; i < length; i++)
+		{
+			size_t index = (size_t)throttles[i] * 256 + commands[i];
+			if (received[index])
+			{
+				duplicates++;
+				continue;
+			}
+			received[index] = true;
+			latencies.add((uint64_t)(SimulatedConnection::now() - sentAt[index]) * 1000);
+		}
+		commandsReceived += length; });
+	receiver.setReceiveBudget(4);
+
+	const uint32_t start = SimulatedConnection::now();
+	for (size_t i = 0; i < BENCH_COMMANDS; i++)
+	{
+		sentAt[i] = SimulatedConnection::now();
+		sender.sendCommand((uint8_t)i, (float)(i >> 8)); // Command and throttle carry the index to look up the send timestamp
+		for (uint32_t t = 0; t < BENCH_COMMAND_INTERVAL; t += BENCH_STEP)
+		{
+			sender.run(); // Failed writes stay queued and are retried by the next run() call
+			receiver.run();
+			SimulatedConnection::advance(BENCH_STEP);
+		}
+	}
+	const uint32_t elapsed = SimulatedConnection::now() - start;
+
+	char name[48];
+	snprintf(name, sizeof name, "commands loss=%2.0f%%", loss * 100);
+	printf("%-32s %8.1f commands/s %6.2f%% delivered %5zu duplicates %6u lost packets\n", name,
+		   (double)latencies.size() * 1e6 / elapsed, 100.0 * latencies.size() / BENCH_COMMANDS, duplicates, (unsigned)senderConnection.packetsLost);
+	snprintf(name, sizeof name, "latency loss=%2.0f%%", loss * 100);
+	latencies.print(name);
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+static uint8_t largePayload[BENCH_LARGE_PAYLOAD];
+static uint8_t reassembled[BENCH_LARGE_PAYLOAD];
+
+static void benchLargePayloadUnderLoss(float loss)
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection(3);
+	SimulatedConnection receiverConnection(senderConnection, 4);
+	senderConnection.setChannel(radioChannel(loss));
+	receiverConnection.setChannel(radioChannel(loss));
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	sender.begin(nullptr);
+	receiver.begin(nullptr, [](const void *buffer, size_t length) -> void {});
+	receiver.setLargePayloadBuffer(reassembled, sizeof reassembled);
+	receiver.setReceiveBudget(REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH);
+	sender.setReceiveBudget(REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH);
+
+	TEST_ASSERT_TRUE(sender.sendLargePayload(largePayload, sizeof largePayload));
+	while (sender.isSendingLargePayload())
+	{
+		sender.run();
+		receiver.run();
+		SimulatedConnection::advance(BENCH_STEP);
+	}
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(largePayload, reassembled, sizeof largePayload);
+
+	const RemoteController::TransferStats &stats = sender.getTransferStats();
+	char name[48];
+	snprintf(name, sizeof name, "large payload loss=%2.0f%%", loss * 100);
+	printf("%-32s %8.0f bytes/s %5u fragments %5u retransmissions\n", name, stats.bytesPerSecond(), stats.fragments, stats.retransmissions);
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+static const float losses[] = {0, 0.05f, 0.1f, 0.2f, 0.3f};
+
+void test_commands_under_loss()
+{
+	for (float loss : losses)
+	{
+		benchCommandsUnderLoss(loss);
+	}
+}
+
+void test_large_payload_under_loss()
+{
+	for (size_t i = 0; i < sizeof largePayload; i++)
+	{
+		largePayload[i] = (uint8_t)(i * 31);
+	}
+	for (float loss : losses)
+	{
+		benchLargePayloadUnderLoss(loss);
+	}
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_commands_under_loss);
+	RUN_TEST(test_large_payload_under_loss);
+
+	return UNITY_END();
+}
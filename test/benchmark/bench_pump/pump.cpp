@@ -0,0 +1,185 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "RemoteController.h"
+#include "../Benchmark.h"
+
+// Contention of sendCommand() from several threads: lock-free handover to the pump (RemoteController::startPump()) vs. one mutex around the RemoteController
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::Pump>> PumpedController; // RemoteController with RemoteController::startPump()
+
+#define BENCH_COMMANDS 50000UL // per run, split between the producers
+#define BENCH_SAMPLE_EVERY 16  // Every n-th sendCommand() call is timed
+#define BENCH_PUMP_PERIOD 100  // microseconds
+#define BENCH_IN_FLIGHT 8	   // commands sent but not delivered yet, fits into the command ring and the command queue: nothing is dropped
+
+static_assert(BENCH_IN_FLIGHT <= REMOTECONTROLLER_COMMAND_QUEUE_LENGTH && BENCH_IN_FLIGHT <= REMOTECONTROLLER_COMMAND_RING_LENGTH, "The commands in flight have to fit into the command queue and the ring");
+
+/**
+ * @brief Connection that accepts every packet and counts the commands, only used by the thread that runs the RemoteController (the producers read the count)
+ *
+ */
+class SinkConnection : public Connection
+{
+public:
+	bool begin() { return true; }
+	void end() {}
+	bool available() { return false; }
+	void read(void *buffer, size_t length) {}
+	size_t getPayloadSize() { return 0; }
+	bool write(const void *buffer, size_t length)
+	{
+		commands += (length - 2) / REMOTECONTROLLER_ENCODED_COMMAND_SIZE; // RemoteController-Protocol v1
+		return true;
+	}
+	size_t getMaxPackageSize() { return 32; }
+
+	std::atomic<size_t> commands{0};
+};
+
+struct ContentionResult
+{
+	size_t sent;
+	size_t delivered;
+	BenchSamples latencies;
+};
+
+/**
+ * @brief Runs the producers, each sends its share of BENCH_COMMANDS paced to BENCH_IN_FLIGHT undelivered commands (the wait is not timed)
+ *
+ * @param send called by the producers for every command
+ */
+template <class Send>
+static void runProducers(size_t producers, Send send, const SinkConnection &connection, ContentionResult &result)
+{
+	std::vector<std::thread> threads;
+	std::vector<BenchSamples> samples(producers);
+	std::atomic<size_t> sent{0};
+	const size_t perProducer = BENCH_COMMANDS / producers;
+	for (size_t producer = 0; producer < producers; producer++)
+	{
+		threads.emplace_back([&, producer]
+							 {
+			samples[producer].reserve(perProducer / BENCH_SAMPLE_EVERY + 1);
+			for (size_t i = 0; i < perProducer; i++)
+			{
+				// Take one of the BENCH_IN_FLIGHT slots, like an application that does not send faster than the link
+				size_t inFlight = sent;
+				while (inFlight - connection.commands >= BENCH_IN_FLIGHT || !sent.compare_exchange_weak(inFlight, inFlight + 1))
+				{
+					std::this_thread::yield();
+					inFlight = sent;
+				}
+				if (i % BENCH_SAMPLE_EVERY == 0)
+				{
+					const uint64_t sendStart = benchNanos();
+					send((uint8_t)producer, (float)i);
+					samples[producer].add(benchNanos() - sendStart);
+				}
+				else
+				{
+					send((uint8_t)producer, (float)i);
+				}
+			} });
+	}
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+	result.sent = sent;
+	result.latencies.clear();
+	for (const BenchSamples &producerSamples : samples)
+	{
+		result.latencies.add(producerSamples);
+	}
+}
+
+static void benchPump(size_t producers, ContentionResult &result)
+{
+	SinkConnection connection;
+	PumpedController rc(connection);
+	rc.begin(nullptr);
+	rc.startPump(BENCH_PUMP_PERIOD);
+	runProducers(producers, [&rc](uint8_t command, float throttle)
+				 { rc.sendCommand(command, throttle); }, connection, result);
+	rc.stopPump();
+	rc.run();
+	result.delivered = connection.commands;
+	rc.end();
+}
+
+static void benchMutex(size_t producers, ContentionResult &result)
+{
+	// What applications had to do before: every sendCommand() and the run() loop share one lock
+	SinkConnection connection;
+	RemoteController rc(connection);
+	std::mutex mutex;
+	std::atomic<bool> running{true};
+	rc.begin(nullptr);
+	std::thread loop([&]
+					 {
+		while (running)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				rc.run();
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(BENCH_PUMP_PERIOD));
+		} });
+	runProducers(producers, [&rc, &mutex](uint8_t command, float throttle)
+				 {
+		std::lock_guard<std::mutex> lock(mutex);
+		rc.sendCommand(command, throttle); }, connection, result);
+	running = false;
+	loop.join();
+	rc.run();
+	result.delivered = connection.commands;
+	rc.end();
+}
+
+static void printContention(const char *name, size_t producers, ContentionResult &result)
+{
+	char label[48];
+	snprintf(label, sizeof label, "%s producers=%zu", name, producers);
+	printf("%-28s %8.1f ns/sendCommand() p50=%llu p99=%llu max=%llu ns %6.2f%% delivered\n", label, result.latencies.mean(),
+		   (unsigned long long)result.latencies.percentile(50), (unsigned long long)result.latencies.percentile(99),
+		   (unsigned long long)result.latencies.percentile(100), 100.0 * result.delivered / result.sent);
+}
+
+void test_contention()
+{
+	const size_t producerCounts[] = {1, 2, 4};
+	for (size_t producers : producerCounts)
+	{
+		ContentionResult pump, mutex;
+		benchPump(producers, pump);
+		benchMutex(producers, mutex);
+		// The timings only count if the commands arrived, not if they were dropped quickly
+		TEST_ASSERT_TRUE_MESSAGE(pump.delivered * 100 >= pump.sent * 99, "The pump delivers at least 99% of the commands!");
+		TEST_ASSERT_TRUE_MESSAGE(mutex.delivered * 100 >= mutex.sent * 99, "The mutex loop delivers at least 99% of the commands!");
+		printContention("pump", producers, pump);
+		printContention("mutex", producers, mutex);
+	}
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_contention);
+
+	UNITY_END();
+}
@@ -0,0 +1,174 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "RemoteController.h"
+#include "Connections/CaptureConnection.h"
+#include "Connections/ReplayConnection.h"
+#include "Connections/SimulatedConnection.h"
+#include "../Benchmark.h"
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::LargePayloads>> LargePayloadController; // RemoteController with RemoteController::sendLargePayload()
+
+// Receive path benchmark: a recorded traffic mix is replayed at maximum speed into a RemoteController, only the decoding is measured.
+// The mix is recorded on a lossy SimulatedConnection (commands, payloads, a large payload with retransmissions and duplicates). Set RC_REPLAY_LOG to the path of a CaptureConnection log to replay a field capture instead (packets up to 32 bytes).
+
+#define BENCH_MIX_MILLIS 2000 // virtual time of the recorded mix
+#define BENCH_REPLAYS 200
+
+/**
+ * @brief NativeStream that appends everything to a vector
+ *
+ */
+class VectorStream : public NativeStream
+{
+public:
+	int available() { return 0; }
+	int read() { return -1; }
+	size_t write(const uint8_t *buffer, size_t size)
+	{
+		bytes.insert(bytes.end(), buffer, buffer + size);
+		return size;
+	}
+	std::vector<uint8_t> bytes;
+};
+
+static size_t commandsDecoded;
+static size_t payloadBytes;
+static uint8_t reassembly[4096];
+
+static void recordMix(std::vector<uint8_t> &log)
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection remoteConnection(5);
+	SimulatedConnection radio(remoteConnection, 6);
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.05f;
+	channel.ackLoss = 0.02f;
+	channel.latencyMicros = 300;
+	channel.jitterMicros = 200;
+	remoteConnection.setChannel(channel);
+	radio.setChannel(channel);
+	VectorStream capture;
+	CaptureConnection vehicleConnection(radio, capture);
+	LargePayloadController remote(remoteConnection);
+	LargePayloadController vehicle(vehicleConnection);
+	remote.begin(nullptr);
+	vehicle.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void {},
+				  [](const void *buffer, size_t length) -> void {});
+	vehicle.setLargePayloadBuffer(reassembly, sizeof reassembly);
+	vehicle.setReceiveBudget(4);
+
+	// Sticks every millisecond, buttons now and then, telemetry requests every 20ms, one configuration upload
+	static uint8_t configuration[3000];
+	for (uint32_t millis = 0; millis < BENCH_MIX_MILLIS; millis++)
+	{
+		remote.sendCommand(1, (float)(millis % 200) / 100.0f - 1.0f);
+		remote.sendCommand(2, (float)(millis % 300) / 150.0f - 1.0f);
+		if (millis % 37 == 0)
+			remote.sendCommand((uint8_t)(10 + millis % 5), RemoteController::High);
+		if (millis % 20 == 0)
+		{
+			const uint8_t request[12] = {'T', (uint8_t)millis};
+			remote.sendPayload(request, sizeof request);
+		}
+		if (millis == BENCH_MIX_MILLIS / 2)
+			remote.sendLargePayload(configuration, sizeof configuration);
+		for (int step = 0; step < 4; step++)
+		{
+			remote.run();
+			vehicle.run();
+			SimulatedConnection::advance(250);
+		}
+	}
+	remote.end();
+	vehicle.end();
+	SimulatedConnection::useVirtualClock(false);
+	log.swap(capture.bytes);
+}
+
+static bool loadLog(const char *path, std::vector<uint8_t> &log)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+		return false;
+	uint8_t buffer[4096];
+	size_t length;
+	while ((length = fread(buffer, 1, sizeof buffer, file)) > 0)
+	{
+		log.insert(log.end(), buffer, buffer + length);
+	}
+	fclose(file);
+	return true;
+}
+
+void test_replay_maxSpeed()
+{
+	std::vector<uint8_t> log;
+	const char *path = getenv("RC_REPLAY_LOG");
+	if (path)
+	{
+		TEST_ASSERT_TRUE_MESSAGE(loadLog(path, log), "Failed to read RC_REPLAY_LOG!");
+	}
+	else
+	{
+		recordMix(log);
+	}
+
+	uint64_t elapsed = 0;
+	uint64_t cycles = 0;
+	size_t packets = 0;
+	uint32_t mismatches = 0;
+	for (size_t replayRun = 0; replayRun < BENCH_REPLAYS; replayRun++)
+	{
+		ReplayConnection replay(log.data(), log.size());
+		LargePayloadController controller(replay);
+		commandsDecoded = 0;
+		payloadBytes = 0;
+		TEST_ASSERT_TRUE(controller.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+										  { commandsDecoded += length; },
+										  [](const void *buffer, size_t length) -> void
+										  { payloadBytes += length; }));
+		controller.setLargePayloadBuffer(reassembly, sizeof reassembly);
+		controller.setReceiveBudget(32);
+		const uint64_t start = benchNanos();
+		const uint64_t startCycles = benchCycles();
+		while (!replay.finished())
+		{
+			controller.run();
+		}
+		cycles += benchCycles() - startCycles;
+		elapsed += benchNanos() - start;
+		packets = replay.packetsReplayed;
+		mismatches = replay.writeMismatches;
+		controller.end();
+	}
+
+	printf("log %zu bytes, %zu packets (%.2f log bytes/packet), %zu commands, %zu payload bytes, %u write mismatches\n", log.size(), packets,
+		   packets ? (double)log.size() / packets : 0.0, commandsDecoded, payloadBytes, (unsigned)mismatches);
+	printf("replay at maximum speed           %10.0f packets/s %10.0f commands/s %8.1f ns/packet %8.0f cycles/packet\n",
+		   benchPerSecond(packets * BENCH_REPLAYS, elapsed), benchPerSecond(commandsDecoded * BENCH_REPLAYS, elapsed),
+		   packets ? (double)elapsed / (packets * BENCH_REPLAYS) : 0.0, packets ? (double)cycles / (packets * BENCH_REPLAYS) : 0.0);
+	TEST_ASSERT_TRUE(packets > 0);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_replay_maxSpeed);
+
+	UNITY_END();
+}
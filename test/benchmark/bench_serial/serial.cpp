@@ -0,0 +1,110 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+#include "Connections/SerialConnection.h"
+#include "../Benchmark.h"
+
+// SerialConnection throughput over a pseudo-terminal pair for different package sizes. The pseudo-terminal has no baud rate, the results show the CPU cost per byte: a UART at 2 Mbaud (8N1) carries 200000 bytes/sec.
+
+#define BENCH_MILLIS 500 // per measurement
+
+static size_t commandsReceived;
+static size_t bytesReceived;
+
+// The pseudo-terminal hands the written bytes over in the background, the receiver runs until everything arrived (at most a second)
+template <class Receiver>
+static void drain(Receiver &receiver, const size_t &received, size_t sent)
+{
+	const uint64_t start = benchNanos();
+	while (received < sent && benchNanos() - start < 1000000000ULL)
+	{
+		receiver.run();
+	}
+}
+
+template <size_t PackageSize>
+static void benchSerial()
+{
+	FdStream master, slave;
+	TEST_ASSERT_TRUE_MESSAGE(FdStream::openPtyPair(master, slave), "Failed to open a pseudo-terminal!");
+	SerialConnection senderConnection(master);
+	SerialConnection receiverConnection(slave);
+	senderConnection.setMaxPackageSize(PackageSize);
+	receiverConnection.setMaxPackageSize(PackageSize);
+	RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> sender(senderConnection);
+	RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> receiver(receiverConnection);
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { commandsReceived += length; },
+				   [](const void *buffer, size_t length) -> void
+				   { bytesReceived += length; });
+	sender.setFrameCheck(RemoteController::Crc16);
+	receiver.setFrameCheck(RemoteController::Crc16);
+	receiver.setReceiveBudget(16);
+
+	// Commands: the queue is filled and sent, the receiver drains the pseudo-terminal
+	commandsReceived = 0;
+	uint64_t start = benchNanos();
+	size_t commandsSent = 0;
+	while (benchNanos() - start < BENCH_MILLIS * 1000000ULL)
+	{
+		for (size_t i = 0; i < RemoteControllerT<RemoteControllerPackageConfig<PackageSize>>::CommandQueueLength; i++)
+		{
+			sender.sendCommand((uint8_t)i, (float)commandsSent++);
+		}
+		sender.run();
+		receiver.run();
+	}
+	drain(receiver, commandsReceived, commandsSent);
+	uint64_t commandNanos = benchNanos() - start;
+	TEST_ASSERT_EQUAL_size_t(commandsSent, commandsReceived);
+
+	// Payloads of the maximum size (without the frame check)
+	uint8_t payload[PackageSize];
+	memset(payload, 0x5A, sizeof payload);
+	const size_t payloadSize = PackageSize - 2;
+	bytesReceived = 0;
+	start = benchNanos();
+	size_t bytesSent = 0;
+	while (benchNanos() - start < BENCH_MILLIS * 1000000ULL)
+	{
+		TEST_ASSERT_TRUE(sender.sendPayload(payload, payloadSize));
+		bytesSent += payloadSize;
+		receiver.run();
+	}
+	drain(receiver, bytesReceived, bytesSent);
+	uint64_t payloadNanos = benchNanos() - start;
+	TEST_ASSERT_EQUAL_size_t(bytesSent, bytesReceived);
+	TEST_ASSERT_EQUAL_UINT32(0, receiverConnection.framingErrors);
+
+	printf("%3zu byte packages %12.0f commands/sec %12.0f payload bytes/sec\n", PackageSize, benchPerSecond(commandsReceived, commandNanos), benchPerSecond(bytesReceived, payloadNanos));
+	sender.end();
+	receiver.end();
+}
+
+void test_serial_throughput()
+{
+	benchSerial<32>();
+	benchSerial<64>();
+	benchSerial<128>();
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_serial_throughput);
+
+	UNITY_END();
+}
@@ -0,0 +1,195 @@
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "RemoteController.h"
+#include "Connections/UdpConnection.h"
+#include "../Benchmark.h"
+
+// Two processes over UdpConnection on localhost: this process is the controller, a forked process echoes every command it receives. Reports the round trip time of single commands and the commands/sec of a pipelined stream for different package sizes.
+
+#define BENCH_ROUND_TRIPS 5000UL
+#define BENCH_MILLIS 1000 // pipelined stream per package size
+
+static size_t commandsEchoed = 0;
+
+static void countEchoes(const uint8_t commands[], const float throttles[], size_t length)
+{
+	commandsEchoed += length;
+}
+
+/**
+ * @brief Echo process: sends every received command back, runs until it is killed
+ *
+ */
+template <size_t PackageSize>
+static void runEcho(uint16_t port, pid_t benchmark)
+{
+	static RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> *echo;
+	static bool echoQueued;
+	UdpConnection connection(port);
+	connection.setMaxPackageSize(PackageSize);
+	RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> controller(connection);
+	echo = &controller;
+	controller.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+					 {
+		for (size_t i = 0; i < length; i++)
+		{
+			echo->sendCommand(commands[i], throttles[i]);
+		}
+		echoQueued = true; });
+	controller.setReceiveBudget(16);
+	while (getppid() == benchmark) // Stops with the benchmark process
+	{
+		connection.waitForPacket(10);
+		do
+		{
+			// run() transmits before it receives: the echoes queued by one run() call are sent by the next one
+			echoQueued = false;
+			controller.run();
+		} while (echoQueued || connection.available());
+	}
+	_exit(0);
+}
+
+template <size_t PackageSize>
+static void benchUdp()
+{
+	typedef RemoteControllerT<RemoteControllerPackageConfig<PackageSize>> Controller;
+
+	// A free port for the echo process
+	UdpConnection probe;
+	TEST_ASSERT_TRUE(probe.begin());
+	const uint16_t echoPort = probe.getLocalPort();
+	probe.end();
+	fflush(stdout);
+	const pid_t benchmark = getpid();
+	const pid_t echoProcess = fork();
+	TEST_ASSERT_TRUE(echoProcess >= 0);
+	if (echoProcess == 0)
+	{
+		runEcho<PackageSize>(echoPort, benchmark);
+	}
+
+	UdpConnection connection;
+	connection.setMaxPackageSize(PackageSize);
+	connection.setRemote("127.0.0.1", echoPort);
+	Controller controller(connection);
+	commandsEchoed = 0;
+	TEST_ASSERT_TRUE(controller.begin(countEchoes));
+	controller.setReceiveBudget(16);
+
+	// Wait for the echo process to listen
+	for (int attempt = 0; attempt < 200 && commandsEchoed == 0; attempt++)
+	{
+		controller.sendCommand(0, RemoteController::High);
+		connection.waitForPacket(10);
+		controller.run();
+	}
+	TEST_ASSERT_TRUE_MESSAGE(commandsEchoed > 0, "The echo process does not answer!");
+	while (connection.waitForPacket(50))
+	{
+		controller.run();
+	}
+
+	// Round trip of single commands: written right away (RemoteController::High), waited for
+	BenchSamples roundTrips;
+	roundTrips.reserve(BENCH_ROUND_TRIPS);
+	size_t lost = 0;
+	for (size_t i = 0; i < BENCH_ROUND_TRIPS; i++)
+	{
+		const size_t echoed = commandsEchoed;
+		const uint64_t start = benchNanos();
+		controller.sendCommand((uint8_t)i, RemoteController::High);
+		while (commandsEchoed == echoed && benchNanos() - start < 100000000ULL)
+		{
+			connection.waitForPacket(10);
+			controller.run();
+		}
+		if (commandsEchoed == echoed)
+			lost++;
+		else
+			roundTrips.add(benchNanos() - start);
+	}
+	char name[40];
+	snprintf(name, sizeof name, "round trip %zu byte packages", PackageSize);
+	roundTrips.print(name);
+
+	// Pipelined: up to half the command queue in flight, every command crosses the loopback twice
+	const size_t window = Controller::CommandQueueLength / 2;
+	commandsEchoed = 0;
+	size_t sent = 0;
+	const uint32_t datagramsBefore = connection.packetsReceived;
+	const uint64_t start = benchNanos();
+	uint64_t lastProgress = start;
+	size_t lastEchoed = 0;
+	while (benchNanos() - start < BENCH_MILLIS * 1000000ULL)
+	{
+		while (sent - commandsEchoed < window)
+		{
+			controller.sendCommand((uint8_t)sent, (float)sent);
+			sent++;
+		}
+		controller.run();
+		if (sent != commandsEchoed && connection.waitForPacket(10))
+		{
+			controller.run();
+		}
+		if (commandsEchoed != lastEchoed)
+		{
+			lastEchoed = commandsEchoed;
+			lastProgress = benchNanos();
+		}
+		else if (benchNanos() - lastProgress > 100000000ULL)
+		{
+			lost += sent - commandsEchoed; // Datagrams were dropped, start a new window
+			sent = commandsEchoed;
+			lastProgress = benchNanos();
+		}
+	}
+	const uint64_t elapsed = benchNanos() - start;
+	printf("stream %4zu byte packages        %10.0f commands/s round trip %10.0f datagrams/s received, %zu commands lost\n", PackageSize,
+		   benchPerSecond(commandsEchoed, elapsed), benchPerSecond(connection.packetsReceived - datagramsBefore, elapsed), lost);
+
+	controller.end();
+	kill(echoProcess, SIGKILL);
+	waitpid(echoProcess, nullptr, 0);
+	TEST_ASSERT_TRUE(roundTrips.size() > 0);
+}
+
+void test_udp_32()
+{
+	benchUdp<32>();
+}
+
+void test_udp_512()
+{
+	benchUdp<512>();
+}
+
+void test_udp_1472()
+{
+	benchUdp<REMOTECONTROLLER_UDP_PACKET_SIZE>();
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+int main(int argc, char **argv)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_udp_32);
+	RUN_TEST(test_udp_512);
+	RUN_TEST(test_udp_1472);
+
+	UNITY_END();
+}
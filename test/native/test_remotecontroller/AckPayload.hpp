@@ -0,0 +1,83 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// Replies attached to the acknowledgement of received packets (RemoteController::setUseAckPayloads())
+
+void test_ackPayload_payloadReply()
+{
+	LoopbackConnection controllerConnection;
+	LoopbackConnection vehicleConnection(controllerConnection);
+	RemoteController controller(controllerConnection);
+	RemoteController vehicle(vehicleConnection);
+
+	static size_t payloadsReceived;
+	static uint8_t lastPayload;
+	payloadsReceived = 0;
+	controller.begin(nullptr, [](const void *buffer, size_t length) -> void
+					 {
+		payloadsReceived++;
+		lastPayload = *(const uint8_t *)buffer; });
+	vehicle.begin(nullptr);
+	vehicle.setUseAckPayloads(true);
+
+	// The reply waits for the next packet from the controller
+	uint8_t telemetry = 42;
+	TEST_ASSERT_TRUE(vehicle.sendPayload(&telemetry, sizeof telemetry));
+	TEST_ASSERT_EQUAL_size_t(0, controllerConnection.queuedPackets());
+	TEST_ASSERT_EQUAL_size_t(1, vehicleConnection.queuedAckPayloads());
+
+	// One run() sends the command and receives the reply
+	controller.sendCommand(RemoteController::GoForward);
+	TEST_ASSERT_TRUE(controller.run());
+	TEST_ASSERT_EQUAL_size_t(1, payloadsReceived);
+	TEST_ASSERT_EQUAL_UINT8(42, lastPayload);
+	TEST_ASSERT_EQUAL_size_t(0, vehicleConnection.queuedAckPayloads());
+
+	// No TX/RX switch on the vehicle: nothing was written on its own
+	TEST_ASSERT_EQUAL_UINT32(0, vehicleConnection.writeFailures);
+	controller.end();
+	vehicle.end();
+}
+
+void test_ackPayload_commandReplyAndFullQueue()
+{
+	LoopbackConnection controllerConnection;
+	LoopbackConnection vehicleConnection(controllerConnection);
+	RemoteController controller(controllerConnection);
+	RemoteController vehicle(vehicleConnection);
+
+	static size_t commandsReceived;
+	commandsReceived = 0;
+	controller.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+					 { commandsReceived += length; });
+	vehicle.begin(nullptr);
+	vehicle.setUseAckPayloads(true);
+	vehicleConnection.setMaxPackageSize(2 + REMOTECONTROLLER_ENCODED_COMMAND_SIZE); // One command per packet
+
+	// Only REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH packets can wait for an acknowledgement, the rest stays queued
+	for (uint8_t i = 0; i < REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH + 1; i++)
+	{
+		vehicle.sendCommand(i);
+	}
+	TEST_ASSERT_FALSE(vehicle.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::FailedToTransmitCommands, vehicle.getErrorCode());
+	TEST_ASSERT_EQUAL_size_t(1, vehicle.commandQueueLength);
+	TEST_ASSERT_EQUAL_size_t(REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH, vehicleConnection.queuedAckPayloads());
+
+	// Every packet of the controller pulls one reply
+	for (uint8_t i = 0; i < REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH + 1; i++)
+	{
+		controller.sendCommand(i, RemoteController::High);
+		TEST_ASSERT_TRUE(controller.run());
+		TEST_ASSERT_TRUE(vehicle.run());
+	}
+	TEST_ASSERT_EQUAL_size_t(REMOTECONTROLLER_LOOPBACK_ACK_PAYLOAD_QUEUE_LENGTH + 1, commandsReceived);
+	TEST_ASSERT_EQUAL_size_t(0, vehicle.commandQueueLength);
+	controller.end();
+	vehicle.end();
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+#include "Connections/SimulatedConnection.h"
+
+// Connection::AsyncWrite (Connection::startWrite() / Connection::pollWrite()) and the non-blocking RemoteController::run()
+
+static uint8_t asyncCommands[32];
+static size_t asyncCommandCount = 0;
+
+static void recordAsyncCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && asyncCommandCount < sizeof asyncCommands; i++)
+	{
+		asyncCommands[asyncCommandCount++] = commands[i];
+	}
+}
+
+void test_asyncWrite_defaultAdapter()
+{
+	// A blocking Connection without Connection::AsyncWrite still implements the contract: the result is ready right away
+	LoopbackConnection sender;
+	LoopbackConnection receiver(sender);
+	receiver.begin();
+	TEST_ASSERT_FALSE(sender.hasCapability(Connection::AsyncWrite));
+	TEST_ASSERT_EQUAL_UINT8(Connection::WriteIdle, sender.pollWrite());
+
+	const uint8_t packet[4] = {1, 2, 3, 4};
+	TEST_ASSERT_TRUE(sender.startWrite(packet, sizeof packet));
+	TEST_ASSERT_EQUAL_UINT8(Connection::WriteSucceeded, sender.pollWrite());
+	TEST_ASSERT_TRUE(receiver.available());
+
+	receiver.end();
+	TEST_ASSERT_TRUE(sender.startWrite(packet, sizeof packet));
+	TEST_ASSERT_EQUAL_UINT8(Connection::WriteFailed, sender.pollWrite());
+}
+
+void test_asyncWrite_runDoesNotWait()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection;
+	SimulatedConnection receiverConnection(senderConnection);
+	SimulatedConnection::Channel channel;
+	channel.bytesPerSecond = 250000; // 4us per byte
+	senderConnection.setChannel(channel);
+	senderConnection.setAsyncWrites(true);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	asyncCommandCount = 0;
+	sender.begin(nullptr);
+	receiver.begin(recordAsyncCommands);
+	receiver.setReceiveBudget(8);
+
+	for (uint8_t command = 0; command < 10; command++)
+	{
+		sender.sendCommand(command, 0.5f);
+	}
+	size_t runs = 0;
+	while (sender.commandQueueLength != 0 && runs < 20)
+	{
+		const uint32_t start = SimulatedConnection::now();
+		TEST_ASSERT_TRUE(sender.run());
+		TEST_ASSERT_EQUAL_UINT32_MESSAGE(start, SimulatedConnection::now(), "run() must not wait for the airtime!");
+		// The result of the previous packet was seen and the next packet started by the same run() call
+		TEST_ASSERT_EQUAL_UINT8(sender.commandQueueLength ? RemoteController::CommandWrite : RemoteController::NoWrite, sender.pendingWrite);
+		SimulatedConnection::advance(200);
+		TEST_ASSERT_TRUE(receiver.run());
+		runs++;
+	}
+	TEST_ASSERT_GREATER_THAN_size_t_MESSAGE(2, runs, "One packet per run() call!");
+
+	TEST_ASSERT_EQUAL_size_t(10, asyncCommandCount);
+	for (uint8_t command = 0; command < 10; command++)
+	{
+		TEST_ASSERT_EQUAL_UINT8(command, asyncCommands[command]);
+	}
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+void test_asyncWrite_packetInFlightIsLocked()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection;
+	SimulatedConnection receiverConnection(senderConnection);
+	SimulatedConnection::Channel channel;
+	channel.bytesPerSecond = 250000;
+	senderConnection.setChannel(channel);
+	senderConnection.setAsyncWrites(true);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	asyncCommandCount = 0;
+	sender.begin(nullptr);
+	receiver.begin(recordAsyncCommands);
+	receiver.setReceiveBudget(8);
+
+	// Priority::High does not wait either, the command overtakes the queue but not the packet in flight
+	sender.sendCommand(1);
+	TEST_ASSERT_TRUE(sender.run());
+	sender.sendCommand(2, RemoteController::High);
+	sender.sendCommand(3);
+	sender.sendCommand(4, RemoteController::High);
+	TEST_ASSERT_EQUAL_size_t(4, sender.commandQueueLength);
+	TEST_ASSERT_EQUAL_UINT8(1, sender.queuedCommandAt(0).command);
+	TEST_ASSERT_EQUAL_UINT8(2, sender.queuedCommandAt(1).command);
+	TEST_ASSERT_EQUAL_UINT8(4, sender.queuedCommandAt(2).command);
+	TEST_ASSERT_EQUAL_UINT8(3, sender.queuedCommandAt(3).command);
+
+	const uint8_t payload[4] = {1, 2, 3, 4};
+	TEST_ASSERT_FALSE(sender.sendPayload(payload, sizeof payload));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::WriteInProgress, sender.getErrorCode());
+
+	for (size_t i = 0; i < 4; i++)
+	{
+		SimulatedConnection::advance(200);
+		TEST_ASSERT_TRUE(sender.run());
+		TEST_ASSERT_TRUE(receiver.run());
+	}
+	const uint8_t expected[4] = {1, 2, 4, 3};
+	TEST_ASSERT_EQUAL_size_t(4, asyncCommandCount);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, asyncCommands, 4);
+
+	// A failed packet is reported by the run() call that sees the result, the commands stay queued
+	channel.loss = 1.0f;
+	senderConnection.setChannel(channel);
+	sender.sendCommand(5);
+	TEST_ASSERT_TRUE(sender.run());
+	SimulatedConnection::advance(200);
+	TEST_ASSERT_FALSE(sender.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::FailedToTransmitCommands, sender.getErrorCode());
+	TEST_ASSERT_EQUAL_size_t(1, sender.commandQueueLength);
+
+	channel.loss = 0;
+	senderConnection.setChannel(channel);
+	TEST_ASSERT_TRUE(sender.run());
+	SimulatedConnection::advance(200);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(5, asyncCommandCount);
+	TEST_ASSERT_EQUAL_UINT8(5, asyncCommands[4]);
+
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+static uint8_t asyncLargePayload[200];
+static size_t asyncLargePayloadLength = 0;
+
+static void recordAsyncLargePayload(const void *buffer, size_t length)
+{
+	memcpy(asyncLargePayload, buffer, length);
+	asyncLargePayloadLength = length;
+}
+
+void test_asyncWrite_largePayloadUnderLoss()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection(11);
+	SimulatedConnection receiverConnection(senderConnection, 12);
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.2f;
+	channel.latencyMicros = 300;
+	channel.bytesPerSecond = 250000;
+	senderConnection.setChannel(channel);
+	receiverConnection.setChannel(channel);
+	senderConnection.setAsyncWrites(true);
+	receiverConnection.setAsyncWrites(true); // The fragment acknowledgements are written asynchronously as well
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	uint8_t reassembly[200];
+	asyncLargePayloadLength = 0;
+	sender.begin(nullptr);
+	receiver.begin(nullptr, recordAsyncLargePayload);
+	receiver.setLargePayloadBuffer(reassembly, sizeof reassembly);
+	receiver.setReceiveBudget(8);
+	sender.setFragmentTimeout(5000);
+
+	uint8_t payload[200];
+	for (size_t i = 0; i < sizeof payload; i++)
+	{
+		payload[i] = (uint8_t)(i * 7);
+	}
+	TEST_ASSERT_TRUE(sender.sendLargePayload(payload, sizeof payload));
+	for (size_t i = 0; i < 2000 && sender.isSendingLargePayload(); i++)
+	{
+		const uint32_t start = SimulatedConnection::now();
+		sender.run();
+		receiver.run();
+		TEST_ASSERT_EQUAL_UINT32(start, SimulatedConnection::now());
+		SimulatedConnection::advance(100);
+	}
+	TEST_ASSERT_FALSE(sender.isSendingLargePayload());
+	TEST_ASSERT_EQUAL_size_t(sizeof payload, asyncLargePayloadLength);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, asyncLargePayload, sizeof payload);
+	TEST_ASSERT_GREATER_THAN_UINT32(0, senderConnection.packetsLost);
+
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
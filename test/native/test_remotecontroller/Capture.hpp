@@ -0,0 +1,192 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CaptureLog.h"
+#include "RemoteController.h"
+#include "Connections/CaptureConnection.h"
+#include "Connections/ReplayConnection.h"
+#include "Connections/LoopbackConnection.h"
+#include "Connections/SimulatedConnection.h"
+#include "SerialConnection.hpp" // MemoryStream
+
+// CaptureConnection, ReplayConnection and the CaptureLog format
+
+static uint8_t captureCommands[2][32];
+static size_t captureCommandCounts[2];
+static uint8_t capturePayloads[2][200];
+static size_t capturePayloadLengths[2];
+
+template <size_t Run>
+static void recordCaptureCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && captureCommandCounts[Run] < sizeof captureCommands[Run]; i++)
+	{
+		captureCommands[Run][captureCommandCounts[Run]++] = commands[i];
+	}
+}
+
+template <size_t Run>
+static void recordCapturePayload(const void *buffer, size_t length)
+{
+	memcpy(capturePayloads[Run], buffer, rcmin(length, sizeof capturePayloads[Run]));
+	capturePayloadLengths[Run] = length;
+}
+
+void test_captureLog_records()
+{
+	uint8_t log[64];
+	size_t length = CaptureLog::encodeRecordHeader(log, CaptureLog::Write, true, 3, 300, 2);
+	TEST_ASSERT_EQUAL_size_t(5, length); // Type, 2 byte time, 1 byte length, peer
+	log[length++] = 0xAA;
+	log[length++] = 0xBB;
+	length += CaptureLog::encodeRecordHeader(log + length, CaptureLog::Session, false, 0, 0, CaptureLog::SessionSize);
+	CaptureLog::encodeSession(log + length, Connection::BatchWrite, 1, 1472);
+	length += CaptureLog::SessionSize;
+
+	size_t position = 0;
+	CaptureLog::Record record;
+	TEST_ASSERT_TRUE(CaptureLog::decodeRecord(log, length, position, record));
+	TEST_ASSERT_EQUAL_UINT8(CaptureLog::Write, record.kind);
+	TEST_ASSERT_TRUE(record.failed);
+	TEST_ASSERT_EQUAL_UINT8(3, record.peer);
+	TEST_ASSERT_EQUAL_UINT32(300, record.deltaMicros);
+	TEST_ASSERT_EQUAL_size_t(2, record.length);
+	TEST_ASSERT_EQUAL_HEX8(0xBB, record.payload[1]);
+	TEST_ASSERT_TRUE(CaptureLog::decodeRecord(log, length, position, record));
+	uint8_t capabilities, peers;
+	size_t maxPackageSize;
+	TEST_ASSERT_TRUE(CaptureLog::decodeSession(record, capabilities, peers, maxPackageSize));
+	TEST_ASSERT_EQUAL_UINT8(Connection::BatchWrite, capabilities);
+	TEST_ASSERT_EQUAL_size_t(1472, maxPackageSize);
+	TEST_ASSERT_FALSE(CaptureLog::decodeRecord(log, length, position, record));
+
+	// A log that was cut off in the middle of a record ends before it
+	position = 0;
+	TEST_ASSERT_FALSE(CaptureLog::decodeRecord(log, 6, position, record));
+	TEST_ASSERT_EQUAL_size_t(0, position);
+}
+
+void test_capture_replayReproducesReceiver()
+{
+	MemoryStream wire;
+	LoopbackConnection senderConnection;
+	LoopbackConnection radio(senderConnection);
+	CaptureConnection receiverConnection(radio, wire);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	uint8_t reassembly[200];
+	memset(captureCommandCounts, 0, sizeof captureCommandCounts);
+	memset(capturePayloadLengths, 0, sizeof capturePayloadLengths);
+	TEST_ASSERT_TRUE(receiverConnection.hasCapability(Connection::AckPayload));
+	sender.begin(nullptr);
+	receiver.begin(recordCaptureCommands<0>, recordCapturePayload<0>);
+	receiver.setLargePayloadBuffer(reassembly, sizeof reassembly);
+
+	// Commands, a payload and a large payload: the receiver reads packets and writes fragment acknowledgements
+	for (uint8_t command = 0; command < 8; command++)
+	{
+		sender.sendCommand(command, (float)command);
+	}
+	sender.run();
+	receiver.run();
+	receiver.run();
+	uint8_t large[150];
+	for (size_t i = 0; i < sizeof large; i++)
+	{
+		large[i] = (uint8_t)(i * 11);
+	}
+	TEST_ASSERT_TRUE(sender.sendLargePayload(large, sizeof large));
+	for (size_t i = 0; i < 20 && sender.isSendingLargePayload(); i++)
+	{
+		sender.run();
+		receiver.run();
+	}
+	TEST_ASSERT_EQUAL_size_t(8, captureCommandCounts[0]);
+	TEST_ASSERT_EQUAL_size_t(sizeof large, capturePayloadLengths[0]);
+	TEST_ASSERT_EQUAL_UINT32(0, receiverConnection.logErrors);
+	receiver.end();
+
+	// The replay delivers the same commands and payloads, the fragment acknowledgements match the recorded ones
+	ReplayConnection replay(wire.bytes, wire.length);
+	TEST_ASSERT_TRUE(replay.hasCapability(Connection::AckPayload));
+	TEST_ASSERT_EQUAL_size_t(radio.getMaxPackageSize(), replay.getMaxPackageSize());
+	LargePayloadController replayed(replay);
+	uint8_t replayReassembly[200];
+	TEST_ASSERT_TRUE(replayed.begin(recordCaptureCommands<1>, recordCapturePayload<1>));
+	replayed.setLargePayloadBuffer(replayReassembly, sizeof replayReassembly);
+	for (size_t i = 0; i < 100 && !replay.finished(); i++)
+	{
+		replayed.run();
+	}
+	TEST_ASSERT_TRUE(replay.finished());
+	TEST_ASSERT_EQUAL_size_t(captureCommandCounts[0], captureCommandCounts[1]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(captureCommands[0], captureCommands[1], captureCommandCounts[0]);
+	TEST_ASSERT_EQUAL_size_t(capturePayloadLengths[0], capturePayloadLengths[1]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(capturePayloads[0], capturePayloads[1], sizeof large);
+	TEST_ASSERT_EQUAL_UINT32(0, replay.writeMismatches);
+
+	// A log without a session cannot be replayed
+	ReplayConnection broken(wire.bytes + 1, wire.length - 1);
+	TEST_ASSERT_FALSE(broken.begin());
+
+	sender.end();
+	replayed.end();
+}
+
+void test_capture_replayOriginalSpeedAndFailures()
+{
+	SimulatedConnection::useVirtualClock(true);
+	MemoryStream wire;
+	LoopbackConnection receiverConnection;
+	LoopbackConnection radio(receiverConnection);
+	CaptureConnection senderConnection(radio, wire);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	memset(captureCommandCounts, 0, sizeof captureCommandCounts);
+
+	// A write that fails (nobody listens yet), one that succeeds, a packet that is read 3ms after the start
+	sender.begin(recordCaptureCommands<0>);
+	SimulatedConnection::advance(500);
+	sender.sendCommand(1, 0.5f, RemoteController::High);
+	const uint8_t recordedError = sender.getErrorCode();
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::FailedToTransmitCommands, recordedError);
+	receiver.begin(nullptr);
+	SimulatedConnection::advance(1000);
+	sender.sendCommand(2, 0.5f, RemoteController::High);
+	receiver.sendCommand(7, RemoteController::High);
+	SimulatedConnection::advance(1500);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(1, captureCommandCounts[0]);
+	sender.end();
+	receiver.end();
+
+	ReplayConnection replay(wire.bytes, wire.length);
+	replay.setOriginalSpeed(true);
+	RemoteController replayed(replay);
+	TEST_ASSERT_TRUE(replayed.begin(recordCaptureCommands<1>));
+	SimulatedConnection::advance(500);
+	replayed.sendCommand(1, 0.5f, RemoteController::High);
+	TEST_ASSERT_EQUAL_UINT8(recordedError, replayed.getErrorCode());
+	SimulatedConnection::advance(1000);
+	replayed.sendCommand(2, 0.5f, RemoteController::High);
+	SimulatedConnection::advance(1499);
+	TEST_ASSERT_TRUE(replayed.run()); // Sends the failed command again, the packet was recorded 1.5ms later
+	TEST_ASSERT_EQUAL_size_t(0, captureCommandCounts[1]);
+	SimulatedConnection::advance(1);
+	TEST_ASSERT_TRUE(replayed.run());
+	TEST_ASSERT_EQUAL_size_t(1, captureCommandCounts[1]);
+	TEST_ASSERT_EQUAL_UINT8(7, captureCommands[1][0]);
+	TEST_ASSERT_TRUE(replay.finished());
+	TEST_ASSERT_EQUAL_UINT32(0, replay.writeMismatches);
+	TEST_ASSERT_EQUAL_UINT32(1, replay.packetsReplayed);
+
+	// Writes the log does not have are counted
+	replayed.sendCommand(3, 0.5f, RemoteController::High);
+	TEST_ASSERT_EQUAL_UINT32(1, replay.writeMismatches);
+
+	replayed.end();
+	SimulatedConnection::useVirtualClock(false);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// RemoteController::setCommandHandler() (per-command handler table)
+
+static float forwardThrottle;
+static float leftThrottle;
+static size_t handlerCalls;
+static size_t arrayCallbackCommands;
+
+void test_commandHandlers_dispatch()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+
+	handlerCalls = 0;
+	arrayCallbackCommands = 0;
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { arrayCallbackCommands += length; });
+	TEST_ASSERT_TRUE(receiver.setCommandHandler(RemoteController::GoForward, [](float throttle) -> void
+												{ forwardThrottle = throttle; handlerCalls++; }));
+	TEST_ASSERT_TRUE(receiver.setCommandHandler(RemoteController::GoLeft, [](float throttle) -> void
+												{ leftThrottle = throttle; handlerCalls++; }));
+
+	sender.sendCommand(RemoteController::GoForward, 0.25f);
+	sender.sendCommand(RemoteController::GoBackward, 0.5f); // No handler, dropped
+	sender.sendCommand(RemoteController::GoLeft, (uint8_t)200);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(2, handlerCalls);
+	TEST_ASSERT_EQUAL_FLOAT(0.25f, forwardThrottle);
+	TEST_ASSERT_EQUAL_FLOAT(200, leftThrottle);
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(0, arrayCallbackCommands, "Commands must not be copied into the callback arrays while handlers are registered!");
+
+	// Removing GoForward keeps GoLeft registered
+	TEST_ASSERT_TRUE(receiver.setCommandHandler(RemoteController::GoForward, nullptr));
+	sender.sendCommand(RemoteController::GoForward, 1.0f);
+	sender.sendCommand(RemoteController::GoLeft, 0.75f);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(3, handlerCalls);
+	TEST_ASSERT_EQUAL_FLOAT(0.25f, forwardThrottle);
+	TEST_ASSERT_EQUAL_FLOAT(0.75f, leftThrottle);
+
+	// Without handlers the array based callback gets every command again
+	receiver.clearCommandHandlers();
+	sender.sendCommand(RemoteController::GoForward, 1.0f);
+	sender.sendCommand(RemoteController::GoLeft, 1.0f);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(3, handlerCalls);
+	TEST_ASSERT_EQUAL_size_t(2, arrayCallbackCommands);
+	sender.end();
+	receiver.end();
+}
+
+void test_commandHandlers_tableFull()
+{
+	LoopbackConnection connection;
+	RemoteController rc(connection);
+	rc.begin(nullptr);
+
+	for (size_t i = 0; i < REMOTECONTROLLER_COMMAND_HANDLERS; i++)
+	{
+		TEST_ASSERT_TRUE(rc.setCommandHandler((uint8_t)(100 + i), [](float throttle) -> void {}));
+	}
+	TEST_ASSERT_FALSE(rc.setCommandHandler(99, [](float throttle) -> void {}));
+	TEST_ASSERT_TRUE_MESSAGE(rc.setCommandHandler(100, [](float throttle) -> void {}), "Replacing a handler needs no new entry!");
+
+	// A removed entry can be reused, the moved handler is still found
+	TEST_ASSERT_TRUE(rc.setCommandHandler(100, nullptr));
+	TEST_ASSERT_EQUAL_INT(-1, rc.findCommandHandler(100));
+	TEST_ASSERT_EQUAL_UINT8(100 + REMOTECONTROLLER_COMMAND_HANDLERS - 1, rc.handlerCommands[rc.findCommandHandler(100 + REMOTECONTROLLER_COMMAND_HANDLERS - 1)]);
+	TEST_ASSERT_TRUE(rc.setCommandHandler(99, [](float throttle) -> void {}));
+	TEST_ASSERT_TRUE(rc.findCommandHandler(99) >= 0);
+	rc.end();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <ArduinoFake.h>
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+
+using namespace fakeit;
+
+// RemoteController::setCommandViewCallback() (zero-copy command callback)
+
+void test_commandView_v1()
+{
+	Mock<Connection> mockConnection;
+	When(Method(mockConnection, begin)).Return(true);
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, available)).AlwaysReturn(true);
+	When(Method(mockConnection, read)).AlwaysDo([](void *buffer, size_t length) -> void
+												{
+		uint8_t *pStart = reinterpret_cast<uint8_t *>(buffer);
+		const float throttles[] = {200, 0.5f};
+		*(pStart) = (uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND >> 8);
+		*(++pStart) = (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND;
+		*(++pStart) = 0x32;
+		memcpy(++pStart, &throttles[0], 4);
+		pStart += 4;
+		*pStart = 0x55;
+		memcpy(++pStart, &throttles[1], 4); });
+	When(Method(mockConnection, getPayloadSize)).AlwaysReturn(12);
+
+	RemoteController rc(mockConnection.get());
+	static int clb;
+	clb = 0;
+	rc.begin(nullptr);
+	rc.setCommandViewCallback([](const RemoteController::CommandView &commands) -> void
+							  {
+		clb++;
+		TEST_ASSERT_EQUAL_size_t(2, commands.size());
+		const uint8_t expectedCommands[] = {0x32, 0x55};
+		const float expectedThrottles[] = {200, 0.5f};
+		size_t i = 0;
+		for (RemoteController::Command command : commands)
+		{
+			TEST_ASSERT_EQUAL_UINT8(expectedCommands[i], command.command);
+			TEST_ASSERT_EQUAL_FLOAT(expectedThrottles[i], command.throttle);
+			i++;
+		}
+		TEST_ASSERT_EQUAL_size_t(2, i); });
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(1, clb, "The view callback has to be called exactly once per packet!");
+	rc.end();
+}
+
+void test_commandView_v2AndArrayCallback()
+{
+	Mock<Connection> mockConnection;
+	When(Method(mockConnection, begin)).Return(true);
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, available)).AlwaysReturn(true);
+	When(Method(mockConnection, read)).AlwaysDo([](void *buffer, size_t length) -> void
+												{
+		const uint8_t packet[] = {
+			(uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 >> 8), (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND_V2,
+			0x01, RemoteController::ThrottleFloat, 0x00, 0x00, 0x60, 0xC0,
+			0x02, RemoteController::ThrottleNone,
+			0x03, RemoteController::ThrottleUInt16, 0xE8, 0x03};
+		memcpy(buffer, packet, length); });
+	When(Method(mockConnection, getPayloadSize)).AlwaysReturn(14);
+
+	RemoteController rc(mockConnection.get());
+	static int viewClb, arrayClb;
+	viewClb = 0;
+	arrayClb = 0;
+	rc.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+			 {
+		arrayClb++;
+		TEST_ASSERT_EQUAL_size_t(3, length);
+		TEST_ASSERT_EQUAL_UINT8(0x01, commands[0]);
+		TEST_ASSERT_EQUAL_FLOAT(-3.5f, throttles[0]);
+		TEST_ASSERT_EQUAL_UINT8(0x02, commands[1]);
+		TEST_ASSERT_EQUAL_FLOAT(0, throttles[1]);
+		TEST_ASSERT_EQUAL_UINT8(0x03, commands[2]);
+		TEST_ASSERT_EQUAL_FLOAT(1000, throttles[2]); });
+	rc.setCommandViewCallback([](const RemoteController::CommandView &commands) -> void
+							  {
+		viewClb++;
+		TEST_ASSERT_EQUAL_size_t(3, commands.size());
+		RemoteController::CommandView::Iterator it = commands.begin();
+		TEST_ASSERT_EQUAL_FLOAT(-3.5f, (*it).throttle);
+		++it;
+		TEST_ASSERT_EQUAL_UINT8(0x02, (*it).command);
+		++it;
+		TEST_ASSERT_EQUAL_FLOAT(1000, (*it).throttle);
+		++it;
+		TEST_ASSERT_FALSE(it != commands.end()); });
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_EQUAL_INT(1, viewClb);
+	TEST_ASSERT_EQUAL_INT(1, arrayClb);
+	rc.end();
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Crc.h"
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// Crc and RemoteController::setFrameCheck()
+
+void test_crc_checkValues()
+{
+	const uint8_t check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+	TEST_ASSERT_EQUAL_HEX8(0xF4, Crc::crc8(check, sizeof check));
+	TEST_ASSERT_EQUAL_HEX8(0xF4, Crc::crc8ByteTable(check, sizeof check));
+	TEST_ASSERT_EQUAL_HEX8(0xF4, Crc::crc8Nibbles(check, sizeof check));
+	TEST_ASSERT_EQUAL_HEX16(0x29B1, Crc::crc16(check, sizeof check));
+	TEST_ASSERT_EQUAL_HEX16(0x29B1, Crc::crc16ByteTable(check, sizeof check));
+	TEST_ASSERT_EQUAL_HEX16(0x29B1, Crc::crc16Nibbles(check, sizeof check));
+	TEST_ASSERT_EQUAL_HEX8(0x00, Crc::crc8(check, 0));
+	TEST_ASSERT_EQUAL_HEX16(0xFFFF, Crc::crc16(check, 0));
+}
+
+/**
+ * @brief LoopbackConnection that flips one bit of the next written packet
+ *
+ */
+class BitFlipConnection : public LoopbackConnection
+{
+public:
+	BitFlipConnection(LoopbackConnection &peer) : LoopbackConnection(peer) {}
+	bool write(const void *buffer, size_t length)
+	{
+		uint8_t packet[REMOTECONTROLLER_LOOPBACK_PACKET_SIZE];
+		memcpy(packet, buffer, length);
+		if (flipByte < length)
+		{
+			packet[flipByte] ^= 0x10;
+			flipByte = SIZE_MAX;
+		}
+		lastLength = length;
+		return LoopbackConnection::write(packet, length);
+	}
+	size_t flipByte = SIZE_MAX;
+	size_t lastLength = 0;
+};
+
+static float frameCheckThrottles[8];
+static uint8_t frameCheckCommands[8];
+static size_t frameCheckCommandCount = 0;
+static uint8_t frameCheckPayload[200];
+static size_t frameCheckPayloadLength = 0;
+
+static void recordFrameCheckCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && frameCheckCommandCount < 8; i++)
+	{
+		frameCheckCommands[frameCheckCommandCount] = commands[i];
+		frameCheckThrottles[frameCheckCommandCount++] = throttles[i];
+	}
+}
+
+static void recordFrameCheckPayload(const void *buffer, size_t length)
+{
+	memcpy(frameCheckPayload, buffer, length);
+	frameCheckPayloadLength = length;
+}
+
+void test_frameCheck_roundTrip()
+{
+	const RemoteController::FrameCheck checks[2] = {RemoteController::Crc8, RemoteController::Crc16};
+	for (size_t c = 0; c < 2; c++)
+	{
+		LoopbackConnection receiverConnection;
+		BitFlipConnection senderConnection(receiverConnection);
+		LargePayloadController sender(senderConnection);
+		LargePayloadController receiver(receiverConnection);
+		uint8_t reassembly[200];
+		frameCheckCommandCount = 0;
+		frameCheckPayloadLength = 0;
+		sender.begin(nullptr);
+		receiver.begin(recordFrameCheckCommands, recordFrameCheckPayload);
+		receiver.setLargePayloadBuffer(reassembly, sizeof reassembly);
+		receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+		sender.setFrameCheck(checks[c]);
+		receiver.setFrameCheck(checks[c]);
+		TEST_ASSERT_EQUAL_UINT8(checks[c], sender.getFrameCheck());
+
+		// The checksum follows the commands, a full queue still fits
+		sender.sendCommand(1, 0.25f, RemoteController::High);
+		TEST_ASSERT_EQUAL_size_t(2 + 5 + c + 1, senderConnection.lastLength);
+		for (uint8_t command = 0; command < 6; command++)
+		{
+			sender.sendCommand(command, (float)command);
+		}
+		TEST_ASSERT_TRUE(sender.run());
+		TEST_ASSERT_LESS_OR_EQUAL_size_t(32, senderConnection.lastLength);
+		TEST_ASSERT_TRUE(receiver.run());
+		TEST_ASSERT_EQUAL_size_t(7, frameCheckCommandCount);
+		TEST_ASSERT_EQUAL_FLOAT(0.25f, frameCheckThrottles[0]);
+		TEST_ASSERT_EQUAL_UINT8(5, frameCheckCommands[6]);
+		TEST_ASSERT_EQUAL_FLOAT(5.0f, frameCheckThrottles[6]);
+
+		// Custom payloads lose the checksum bytes of their maximum size
+		uint8_t payload[32];
+		for (size_t i = 0; i < sizeof payload; i++)
+		{
+			payload[i] = (uint8_t)(i * 3);
+		}
+		TEST_ASSERT_FALSE(sender.sendPayload(payload, 32 - c));
+		TEST_ASSERT_EQUAL_UINT8(RemoteController::CustomPayloadTooBig, sender.getErrorCode());
+		TEST_ASSERT_TRUE(sender.sendPayload(payload, 31 - c));
+		TEST_ASSERT_TRUE(receiver.run());
+		TEST_ASSERT_EQUAL_size_t(31 - c, frameCheckPayloadLength);
+		TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, frameCheckPayload, 31 - c);
+
+		// Fragments and fragment acknowledgements carry the checksum as well
+		uint8_t large[150];
+		for (size_t i = 0; i < sizeof large; i++)
+		{
+			large[i] = (uint8_t)(i * 5 + c);
+		}
+		TEST_ASSERT_TRUE(sender.sendLargePayload(large, sizeof large));
+		for (size_t i = 0; i < 20 && sender.isSendingLargePayload(); i++)
+		{
+			sender.run();
+			receiver.run();
+		}
+		TEST_ASSERT_FALSE(sender.isSendingLargePayload());
+		TEST_ASSERT_EQUAL_size_t(sizeof large, frameCheckPayloadLength);
+		TEST_ASSERT_EQUAL_UINT8_ARRAY(large, frameCheckPayload, sizeof large);
+		TEST_ASSERT_EQUAL_UINT32(0, receiver.getStatistics().corruptPackets);
+
+		sender.end();
+		receiver.end();
+	}
+}
+
+void test_frameCheck_bitErrorDetected()
+{
+	LoopbackConnection receiverConnection;
+	BitFlipConnection senderConnection(receiverConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	frameCheckCommandCount = 0;
+	sender.begin(nullptr);
+	receiver.begin(recordFrameCheckCommands);
+
+	// Without a frame check a bit error in the throttle is delivered as a wrong throttle
+	senderConnection.flipByte = 6; // Highest byte of the float throttle
+	sender.sendCommand(1, 0.5f, RemoteController::High);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(1, frameCheckCommandCount);
+	TEST_ASSERT_TRUE(frameCheckThrottles[0] != 0.5f);
+
+	// With a frame check the packet is dropped before it is decoded
+	sender.setFrameCheck(RemoteController::Crc8);
+	receiver.setFrameCheck(RemoteController::Crc8);
+	frameCheckCommandCount = 0;
+	senderConnection.flipByte = 6;
+	sender.sendCommand(1, 0.5f, RemoteController::High);
+	TEST_ASSERT_FALSE(receiver.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::ReceivedCorruptPacket, receiver.getErrorCode());
+	TEST_ASSERT_EQUAL_size_t(0, frameCheckCommandCount);
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_EQUAL_UINT32(1, receiver.getStatistics().corruptPackets);
+#endif
+
+	// A bit error in the identifier is detected too
+	senderConnection.flipByte = 0;
+	sender.sendCommand(2, 0.5f, RemoteController::High);
+	TEST_ASSERT_FALSE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(0, frameCheckCommandCount);
+
+	sender.sendCommand(3, 0.5f, RemoteController::High);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(1, frameCheckCommandCount);
+	TEST_ASSERT_EQUAL_UINT8(3, frameCheckCommands[0]);
+	TEST_ASSERT_EQUAL_FLOAT(0.5f, frameCheckThrottles[0]);
+
+	// Both ends have to use the same frame check
+	receiver.setFrameCheck(RemoteController::Crc16);
+	sender.sendCommand(4, 0.5f, RemoteController::High);
+	TEST_ASSERT_FALSE(receiver.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::ReceivedCorruptPacket, receiver.getErrorCode());
+
+	sender.end();
+	receiver.end();
+}
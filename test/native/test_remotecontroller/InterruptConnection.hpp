@@ -0,0 +1,226 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+
+#include "RemoteController.h"
+#include "PacketRing.h"
+#include "Connections/InterruptConnection.h"
+#include "Connections/LoopbackConnection.h"
+
+// Interrupt driven receive: PacketRing (SPSC ring buffer) and InterruptConnection
+
+#define INTERRUPT_STRESS_PACKETS 200000UL
+
+void test_packetRing_spscStress()
+{
+	static PacketRing ring;
+	static uint32_t failedReserves;
+	failedReserves = 0;
+
+	// Producer thread, retries while the ring is full
+	std::thread producer([]
+						 {
+		for (uint32_t sequence = 0; sequence < INTERRUPT_STRESS_PACKETS;)
+		{
+			uint8_t *slot = ring.reserve();
+			if (!slot)
+			{
+				failedReserves++;
+				std::this_thread::yield();
+				continue;
+			}
+			memcpy(slot, &sequence, sizeof sequence);
+			ring.commit(sizeof sequence + sequence % 8); // Variable length packets
+			sequence++;
+		} });
+
+	// Consumer, every packet has to arrive exactly once and in order
+	uint32_t expected = 0;
+	while (expected < INTERRUPT_STRESS_PACKETS)
+	{
+		if (ring.empty())
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		uint32_t sequence;
+		memcpy(&sequence, ring.front(), sizeof sequence);
+		TEST_ASSERT_EQUAL_UINT32(expected, sequence);
+		TEST_ASSERT_EQUAL_size_t(sizeof sequence + sequence % 8, ring.frontLength());
+		ring.pop();
+		expected++;
+	}
+	producer.join();
+
+	TEST_ASSERT_TRUE(ring.empty());
+	TEST_ASSERT_EQUAL_UINT32(failedReserves, ring.overflowDrops());
+	TEST_ASSERT_TRUE(ring.highWatermark() <= PacketRing::Length);
+	ring.resetStatistics();
+	TEST_ASSERT_EQUAL_UINT32(0, ring.overflowDrops());
+	TEST_ASSERT_EQUAL_UINT8(0, ring.highWatermark());
+}
+
+void test_interruptConnection_overflow()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection radio(senderConnection);
+	InterruptConnection receiverConnection(radio);
+	TEST_ASSERT_TRUE(receiverConnection.hasCapability(Connection::BatchWrite));
+
+	static size_t commandsReceived;
+	commandsReceived = 0;
+	RemoteController receiver(receiverConnection);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { commandsReceived += length; });
+	receiver.setReceiveBudget(PacketRing::Length + 2);
+	senderConnection.begin();
+
+	// Fill the ring buffer, the last two packets are dropped
+	uint8_t packet[] = {0xEE, 0xAF, 1, 0, 0, 0, 0};
+	for (size_t i = 0; i < PacketRing::Length + 2; i++)
+	{
+		senderConnection.write(packet, sizeof packet);
+		receiverConnection.handleInterrupt();
+	}
+	TEST_ASSERT_EQUAL_size_t(0, radio.queuedPackets());
+	TEST_ASSERT_EQUAL_UINT8(PacketRing::Length, receiverConnection.getHighWatermark());
+	TEST_ASSERT_EQUAL_UINT32(2, receiverConnection.getOverflowDrops());
+
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(PacketRing::Length, commandsReceived);
+	TEST_ASSERT_FALSE(receiverConnection.available());
+	receiver.end();
+}
+
+void test_interruptConnection_producerThread()
+{
+	static LoopbackConnection senderConnection;
+	static LoopbackConnection radio;
+	static InterruptConnection receiverConnection(radio);
+	senderConnection.pair(radio);
+
+	static uint32_t nextCommand;
+	static bool inOrder;
+	static size_t commandsReceived;
+	nextCommand = 0;
+	commandsReceived = 0;
+	inOrder = true;
+	RemoteController receiver(receiverConnection);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   {
+		for (size_t i = 0; i < length; i++)
+		{
+			// Commands that were dropped on overflow are skipped, the others have to arrive in order
+			uint32_t command = (uint32_t)throttles[i];
+			inOrder = inOrder && command >= nextCommand;
+			nextCommand = command + 1;
+		}
+		commandsReceived += length; });
+	receiver.setReceiveBudget(PacketRing::Length);
+	receiverConnection.resetStatistics();
+	senderConnection.begin();
+
+	// The sender and the "radio IRQ" run on their own thread, RemoteController::run() only drains the ring
+	static size_t packetsSent;
+	packetsSent = 0;
+	std::thread radioThread([]
+							{
+		for (uint32_t command = 0; command < INTERRUPT_STRESS_PACKETS / 4; command++)
+		{
+			uint8_t packet[7] = {0xEE, 0xAF, 0};
+			float throttle = (float)command;
+			memcpy(packet + 3, &throttle, sizeof throttle);
+			if (senderConnection.write(packet, sizeof packet))
+				packetsSent++;
+			receiverConnection.handleInterrupt();
+			std::this_thread::yield();
+		} });
+
+	while (commandsReceived + receiverConnection.getOverflowDrops() < INTERRUPT_STRESS_PACKETS / 4)
+	{
+		receiver.run();
+		std::this_thread::yield();
+	}
+	radioThread.join();
+
+	TEST_ASSERT_TRUE(inOrder);
+	TEST_ASSERT_EQUAL_size_t(INTERRUPT_STRESS_PACKETS / 4, packetsSent);
+	TEST_ASSERT_TRUE(receiverConnection.getHighWatermark() <= PacketRing::Length);
+	TEST_ASSERT_FALSE(receiverConnection.available());
+	receiver.end();
+	senderConnection.end();
+}
+
+/**
+ * @brief Connection with packets larger than the ring slots, every written packet is received again on the same end
+ *
+ */
+class EchoConnection : public Connection
+{
+public:
+	bool begin() { return true; }
+	void end() { count = 0; }
+	bool available() { return count != 0; }
+	void read(void *buffer, size_t length)
+	{
+		memcpy(buffer, packets[head], length < lengths[head] ? length : lengths[head]);
+		head = (head + 1) % 8;
+		count--;
+	}
+	size_t getPayloadSize() { return count ? lengths[head] : 0; }
+	bool write(const void *buffer, size_t length)
+	{
+		if (count == 8 || length > sizeof packets[0])
+			return false;
+		const size_t tail = (head + count++) % 8;
+		memcpy(packets[tail], buffer, length);
+		lengths[tail] = length;
+		longestWrite = length > longestWrite ? length : longestWrite;
+		return true;
+	}
+	size_t getMaxPackageSize() { return sizeof packets[0]; }
+
+	size_t longestWrite = 0;
+
+private:
+	uint8_t packets[8][128];
+	size_t lengths[8];
+	size_t head = 0;
+	size_t count = 0;
+};
+
+void test_interruptConnection_largePackets()
+{
+	EchoConnection radio;
+	InterruptConnection connection(radio);
+	TEST_ASSERT_EQUAL_size_t(PacketRing::PacketSize, connection.getMaxPackageSize());
+
+	// A controller sized for 128 byte packets only sends what fits into the ring slots, nothing is cut on the way back
+	static size_t commandsReceived;
+	static bool intact;
+	commandsReceived = 0;
+	intact = true;
+	RemoteControllerT<RemoteControllerPackageConfig<128>> rc(connection);
+	rc.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+			 {
+		for (size_t i = 0; i < length; i++)
+		{
+			intact = intact && commands[i] == commandsReceived + i && throttles[i] == (float)(commandsReceived + i);
+		}
+		commandsReceived += length; });
+	rc.setReceiveBudget(PacketRing::Length);
+	for (uint8_t i = 0; i < 20; i++)
+	{
+		rc.sendCommand(i, (float)i);
+	}
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_TRUE(radio.longestWrite <= PacketRing::PacketSize);
+	connection.handleInterrupt();
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_EQUAL_size_t(20, commandsReceived);
+	TEST_ASSERT_TRUE(intact);
+	rc.end();
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// Fragmentation and reassembly of payloads larger than one packet (RemoteController::sendLargePayload())
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::LargePayloads>> LargePayloadController; // RemoteController with the default sizes and RemoteController::LargePayloads
+
+/**
+ * @brief LoopbackConnection that loses one fragment after it was acknowledged by the radio (e.g. the receiver buffer overflowed) or fails the write of one fragment
+ *
+ */
+class FragmentDroppingConnection : public LoopbackConnection
+{
+public:
+	int dropFragment = -1; // Index of the fragment that is lost once
+	int failFragment = -1; // Index of the fragment whose write fails once
+
+	bool write(const void *buffer, size_t length)
+	{
+		const uint8_t *packet = (const uint8_t *)buffer;
+		if (length > 3 && packet[0] == 0xEE && packet[1] == 0xC0 && packet[3] == dropFragment)
+		{
+			dropFragment = -1;
+			return true;
+		}
+		if (length > 3 && packet[0] == 0xEE && packet[1] == 0xC0 && packet[3] == failFragment)
+		{
+			failFragment = -1;
+			return false;
+		}
+		return LoopbackConnection::write(buffer, length);
+	}
+};
+
+/**
+ * @brief LoopbackConnection that delivers one fragment after the next REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN fragments (e.g. a channel with jitter)
+ *
+ */
+class FragmentReorderingConnection : public LoopbackConnection
+{
+public:
+	int delayFragment = -1; // Index of the fragment that is overtaken once
+
+	bool write(const void *buffer, size_t length)
+	{
+		const uint8_t *packet = (const uint8_t *)buffer;
+		if (length > 3 && packet[0] == 0xEE && packet[1] == 0xC0 && packet[3] == delayFragment)
+		{
+			memcpy(delayed, buffer, length);
+			delayedLength = length;
+			delayFragment = -1;
+			return true;
+		}
+		const bool success = LoopbackConnection::write(buffer, length);
+		if (delayedLength && length > 3 && packet[0] == 0xEE && packet[1] == 0xC0 && packet[3] == delayed[3] + REMOTECONTROLLER_FRAGMENT_REORDER_MARGIN)
+		{
+			LoopbackConnection::write(delayed, delayedLength);
+			delayedLength = 0;
+		}
+		return success;
+	}
+
+private:
+	uint8_t delayed[REMOTECONTROLLER_OUTGOING_BUFFER_SIZE];
+	size_t delayedLength = 0;
+};
+
+static uint8_t largePayload[1000];
+static uint8_t reassembled[1000];
+static size_t largePayloadsReceived;
+static size_t largePayloadLength;
+
+static void transferLargePayload(LargePayloadController &sender, LargePayloadController &receiver)
+{
+	for (size_t i = 0; i < sizeof largePayload; i++)
+	{
+		largePayload[i] = (uint8_t)(i * 7);
+	}
+	largePayloadsReceived = 0;
+	receiver.begin(nullptr, [](const void *buffer, size_t length) -> void
+				   {
+		largePayloadsReceived++;
+		largePayloadLength = length; });
+	receiver.setLargePayloadBuffer(reassembled, sizeof reassembled);
+	sender.begin(nullptr);
+
+	TEST_ASSERT_TRUE(sender.sendLargePayload(largePayload, sizeof largePayload));
+	TEST_ASSERT_FALSE(sender.sendLargePayload(largePayload, sizeof largePayload));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::TransferInProgress, sender.getErrorCode());
+	for (size_t i = 0; i < 100 && sender.isSendingLargePayload(); i++)
+	{
+		sender.run();
+		receiver.run();
+	}
+	TEST_ASSERT_FALSE(sender.isSendingLargePayload());
+	TEST_ASSERT_EQUAL_size_t(1, largePayloadsReceived);
+	TEST_ASSERT_EQUAL_size_t(sizeof largePayload, largePayloadLength);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(largePayload, reassembled, sizeof largePayload);
+}
+
+void test_largePayload_transfer()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+
+	transferLargePayload(sender, receiver);
+	const size_t fragments = (sizeof largePayload + 25) / 26; // 26 bytes per 32 byte packet
+	TEST_ASSERT_EQUAL_UINT32(sizeof largePayload, sender.getTransferStats().bytes);
+	TEST_ASSERT_EQUAL_UINT16(fragments, sender.getTransferStats().fragments);
+	TEST_ASSERT_EQUAL_UINT16(0, sender.getTransferStats().retransmissions);
+	TEST_ASSERT_TRUE(sender.getTransferStats().bytesPerSecond() > 0);
+	sender.end();
+	receiver.end();
+}
+
+void test_largePayload_selectiveRetransmit()
+{
+	FragmentDroppingConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+	sender.setFragmentTimeout(0xFFFFFFFF); // Only the acknowledgement can trigger the retransmission
+
+	senderConnection.dropFragment = 3;
+	transferLargePayload(sender, receiver);
+	TEST_ASSERT_EQUAL_UINT16(1, sender.getTransferStats().retransmissions); // Only the lost fragment
+	sender.end();
+	receiver.end();
+}
+
+void test_largePayload_reordered()
+{
+	FragmentReorderingConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	sender.setFragmentTimeout(0xFFFFFFFF); // Only the acknowledgements can trigger a retransmission
+	// The receiver acknowledges every fragment, the acknowledgements of the fragments that overtook the delayed one arrive before it
+
+	senderConnection.delayFragment = 3;
+	transferLargePayload(sender, receiver);
+	TEST_ASSERT_EQUAL_UINT16(0, sender.getTransferStats().retransmissions); // The overtaken fragment was not lost
+	sender.end();
+	receiver.end();
+}
+
+void test_largePayload_failedWriteRetransmit()
+{
+	FragmentDroppingConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+
+	senderConnection.failFragment = 3;
+	transferLargePayload(sender, receiver);
+	const size_t fragments = (sizeof largePayload + 25) / 26;
+	TEST_ASSERT_EQUAL_UINT16(1, sender.getTransferStats().retransmissions); // The write that failed is sent again
+	TEST_ASSERT_EQUAL_UINT16(fragments + 1, sender.getTransferStats().fragments);
+	sender.end();
+	receiver.end();
+}
+
+void test_largePayload_bufferTooSmall()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+	uint8_t buffer[64];
+	receiver.begin(nullptr);
+	receiver.setLargePayloadBuffer(buffer, sizeof buffer);
+	sender.begin(nullptr);
+
+	TEST_ASSERT_TRUE(sender.sendLargePayload(largePayload, sizeof largePayload));
+	sender.run();
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+	TEST_ASSERT_FALSE(receiver.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::ReceivedPayloadTooBig, receiver.getErrorCode());
+
+	// Payloads that need more than 255 fragments are rejected
+	static uint8_t tooBig[255 * 26 + 1];
+	sender.end();
+	LargePayloadController idleSender(senderConnection);
+	TEST_ASSERT_FALSE(idleSender.sendLargePayload(tooBig, sizeof tooBig));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::CustomPayloadTooBig, idleSender.getErrorCode());
+	receiver.end();
+}
+
+void test_largePayload_featureDisabled()
+{
+	// Without RemoteController::LargePayloads the fragment state is not allocated, fragments are ignored and sendLargePayload() fails
+	TEST_ASSERT_TRUE(sizeof(RemoteController) < sizeof(LargePayloadController));
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	LargePayloadController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+	receiver.begin(nullptr);
+	sender.begin(nullptr);
+
+	TEST_ASSERT_TRUE(sender.sendLargePayload(largePayload, 100));
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_FALSE(senderConnection.available()); // No acknowledgement sent back
+	RemoteControllerBase &base = receiver;
+	TEST_ASSERT_FALSE(base.sendLargePayload(largePayload, 100));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::CustomPayloadTooBig, receiver.getErrorCode());
+	TEST_ASSERT_FALSE(receiver.isSendingLargePayload());
+	sender.end();
+	receiver.end();
+}
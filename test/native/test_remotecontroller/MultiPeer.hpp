@@ -0,0 +1,278 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "MultiPeerRemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// Connection::MultiPeer, PeerConnection and MultiPeerRemoteController
+
+static uint8_t multiPeerCommands[16];
+static uint8_t multiPeerSenders[16];
+static size_t multiPeerCommandCount = 0;
+static uint8_t remoteCommands[3][8];
+static size_t remoteCommandCounts[3];
+
+static void recordPeerCommands(uint8_t peer, const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && multiPeerCommandCount < sizeof multiPeerCommands; i++)
+	{
+		multiPeerSenders[multiPeerCommandCount] = peer;
+		multiPeerCommands[multiPeerCommandCount++] = commands[i];
+	}
+}
+
+template <size_t Remote>
+static void recordRemoteCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && remoteCommandCounts[Remote] < sizeof remoteCommands[Remote]; i++)
+	{
+		remoteCommands[Remote][remoteCommandCounts[Remote]++] = commands[i];
+	}
+}
+
+void test_multiPeer_routing()
+{
+	LoopbackConnection baseConnection;
+	LoopbackConnection remoteConnections[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		TEST_ASSERT_EQUAL_INT((int)i, baseConnection.addPeer(remoteConnections[i]));
+	}
+	TEST_ASSERT_TRUE(baseConnection.hasCapability(Connection::MultiPeer));
+	TEST_ASSERT_EQUAL_UINT8(3, baseConnection.getPeerCount());
+
+	MultiPeerRemoteController<3> base(baseConnection);
+	RemoteController remote0(remoteConnections[0]);
+	RemoteController remote1(remoteConnections[1]);
+	RemoteController remote2(remoteConnections[2]);
+	multiPeerCommandCount = 0;
+	memset(remoteCommandCounts, 0, sizeof remoteCommandCounts);
+	TEST_ASSERT_TRUE(base.begin(recordPeerCommands));
+	remote0.begin(recordRemoteCommands<0>);
+	remote1.begin(recordRemoteCommands<1>);
+	remote2.begin(recordRemoteCommands<2>);
+
+	// Every remote talks to the base, the callback tells who sent the commands
+	remote2.sendCommand(20, RemoteController::High);
+	remote0.sendCommand(0, RemoteController::High);
+	remote1.sendCommand(10, RemoteController::High);
+	remote2.sendCommand(21, RemoteController::High);
+	for (size_t i = 0; i < 4; i++) // One packet per peer and run() (receive budget)
+	{
+		TEST_ASSERT_TRUE(base.run());
+	}
+	TEST_ASSERT_EQUAL_size_t(4, multiPeerCommandCount);
+	for (size_t i = 0; i < multiPeerCommandCount; i++)
+	{
+		TEST_ASSERT_EQUAL_UINT8(multiPeerCommands[i] / 10, multiPeerSenders[i]);
+	}
+
+	// Every peer has its own queue and the packets only reach their peer
+	base.peer(1).sendCommand(100);
+	base.peer(1).sendCommand(101);
+	base.peer(2).sendCommand(102);
+	TEST_ASSERT_EQUAL_size_t(2, base.peer(1).commandQueueLength);
+	TEST_ASSERT_EQUAL_size_t(1, base.peer(2).commandQueueLength);
+	TEST_ASSERT_TRUE(base.run());
+	remote0.run();
+	remote1.run();
+	remote2.run();
+	TEST_ASSERT_EQUAL_size_t(0, remoteCommandCounts[0]);
+	TEST_ASSERT_EQUAL_size_t(2, remoteCommandCounts[1]);
+	TEST_ASSERT_EQUAL_UINT8(100, remoteCommands[1][0]);
+	TEST_ASSERT_EQUAL_UINT8(101, remoteCommands[1][1]);
+	TEST_ASSERT_EQUAL_size_t(1, remoteCommandCounts[2]);
+	TEST_ASSERT_EQUAL_UINT8(102, remoteCommands[2][0]);
+
+	// A failed peer does not keep the others from being served
+	remote2.end();
+	base.peer(2).sendCommand(103);
+	base.peer(0).sendCommand(104);
+	TEST_ASSERT_FALSE(base.run());
+	TEST_ASSERT_EQUAL_UINT8(2, base.getErrorPeer());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::FailedToTransmitCommands, base.peer(2).getErrorCode());
+	remote0.run();
+	TEST_ASSERT_EQUAL_size_t(1, remoteCommandCounts[0]);
+	TEST_ASSERT_EQUAL_UINT8(104, remoteCommands[0][0]);
+
+	base.end();
+	remote0.end();
+	remote1.end();
+}
+
+/**
+ * @brief LoopbackConnection that logs the peer of every successful write
+ *
+ */
+class RecordingHubConnection : public LoopbackConnection
+{
+public:
+	bool setWritePeer(uint8_t peer)
+	{
+		selectedPeer = peer;
+		return LoopbackConnection::setWritePeer(peer);
+	}
+	bool write(const void *buffer, size_t length)
+	{
+		if (!LoopbackConnection::write(buffer, length))
+			return false;
+		if (writes < sizeof writePeers)
+			writePeers[writes++] = selectedPeer;
+		return true;
+	}
+	uint8_t writePeers[16];
+	size_t writes = 0;
+
+private:
+	uint8_t selectedPeer = 0;
+};
+
+void test_multiPeer_roundRobin()
+{
+	RecordingHubConnection baseConnection;
+	LoopbackConnection remoteConnections[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		baseConnection.addPeer(remoteConnections[i]);
+		remoteConnections[i].begin();
+	}
+	MultiPeerRemoteController<3> base(baseConnection);
+	TEST_ASSERT_TRUE(base.begin(nullptr));
+
+	// Every run() starts with the next peer, no peer is always served first
+	for (size_t round = 0; round < 3; round++)
+	{
+		for (uint8_t peer = 0; peer < 3; peer++)
+		{
+			base.peer(peer).sendCommand(peer);
+		}
+		TEST_ASSERT_TRUE(base.run());
+	}
+	const uint8_t expected[9] = {0, 1, 2, 1, 2, 0, 2, 0, 1};
+	TEST_ASSERT_EQUAL_size_t(9, baseConnection.writes);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, baseConnection.writePeers, 9);
+	base.end();
+}
+
+void test_multiPeer_unknownAndWaitingPackets()
+{
+	LoopbackConnection baseConnection;
+	LoopbackConnection remoteConnections[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		baseConnection.addPeer(remoteConnections[i]);
+	}
+
+	// More peers than the Connection has
+	MultiPeerRemoteController<4> tooMany(baseConnection);
+	TEST_ASSERT_FALSE(tooMany.begin(recordPeerCommands));
+
+	// The base only serves the first two peers, packets of the third one are dropped
+	MultiPeerRemoteController<2> base(baseConnection);
+	RemoteController remote0(remoteConnections[0]);
+	RemoteController remote1(remoteConnections[1]);
+	RemoteController remote2(remoteConnections[2]);
+	multiPeerCommandCount = 0;
+	TEST_ASSERT_TRUE(base.begin(recordPeerCommands));
+	remote0.begin(nullptr);
+	remote1.begin(nullptr);
+	remote2.begin(nullptr);
+
+	// Peer 0 runs first, the packet of peer 1 ahead of the ones of peer 0 waits for the RemoteController of peer 1
+	remote2.sendCommand(20, RemoteController::High);
+	remote1.sendCommand(10, RemoteController::High);
+	remote0.sendCommand(0, RemoteController::High);
+	remote0.sendCommand(1, RemoteController::High);
+	base.peer(0).setReceiveBudget(4);
+	base.peer(1).setReceiveBudget(4);
+	TEST_ASSERT_TRUE(base.run());
+	TEST_ASSERT_EQUAL_UINT32(1, base.getUnknownPeerDrops());
+	TEST_ASSERT_EQUAL_size_t(1, multiPeerCommandCount);
+	TEST_ASSERT_EQUAL_UINT8(10, multiPeerCommands[0]);
+	TEST_ASSERT_EQUAL_UINT8(1, multiPeerSenders[0]);
+	TEST_ASSERT_TRUE(base.run());
+	TEST_ASSERT_EQUAL_size_t(3, multiPeerCommandCount);
+	TEST_ASSERT_EQUAL_UINT8(0, multiPeerCommands[1]);
+	TEST_ASSERT_EQUAL_UINT8(1, multiPeerCommands[2]);
+	TEST_ASSERT_EQUAL_UINT8(0, multiPeerSenders[2]);
+
+	base.end();
+	remote0.end();
+	remote1.end();
+	remote2.end();
+}
+
+static uint8_t multiPeerPayloads[4];
+static uint8_t multiPeerPayloadSenders[4];
+static size_t multiPeerPayloadCount = 0;
+
+static void recordPeerPayloads(uint8_t peer, const void *buffer, size_t length)
+{
+	if (multiPeerPayloadCount < sizeof multiPeerPayloads)
+	{
+		multiPeerPayloadSenders[multiPeerPayloadCount] = peer;
+		multiPeerPayloads[multiPeerPayloadCount++] = *(const uint8_t *)buffer;
+	}
+}
+
+void test_multiPeer_ackPayloads()
+{
+	LoopbackConnection baseConnection;
+	LoopbackConnection remoteConnections[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		baseConnection.addPeer(remoteConnections[i]);
+	}
+	MultiPeerRemoteController<3> base(baseConnection);
+	RemoteController remote0(remoteConnections[0]);
+	RemoteController remote1(remoteConnections[1]);
+	RemoteController remote2(remoteConnections[2]);
+	multiPeerPayloadCount = 0;
+	TEST_ASSERT_TRUE(base.begin(nullptr, recordPeerPayloads));
+	remote0.begin(nullptr);
+	remote1.begin(nullptr);
+	remote2.begin(nullptr);
+
+	// The replies of the remotes ride on the acks of the base's writes, they belong to the peer that was written to (not to peer 0)
+	remote1.setUseAckPayloads(true);
+	remote2.setUseAckPayloads(true);
+	uint8_t telemetry = 12;
+	TEST_ASSERT_TRUE(remote2.sendPayload(&telemetry, sizeof telemetry));
+	telemetry = 11;
+	TEST_ASSERT_TRUE(remote1.sendPayload(&telemetry, sizeof telemetry));
+	base.peer(2).sendCommand(2, RemoteController::High);
+	base.peer(1).sendCommand(1, RemoteController::High);
+	for (size_t i = 0; i < 3; i++)
+	{
+		TEST_ASSERT_TRUE(base.run());
+	}
+	TEST_ASSERT_EQUAL_size_t(2, multiPeerPayloadCount);
+	for (size_t i = 0; i < multiPeerPayloadCount; i++)
+	{
+		TEST_ASSERT_EQUAL_UINT8(multiPeerPayloads[i] - 10, multiPeerPayloadSenders[i]);
+	}
+	remote1.run(); // Takes the command of the base
+	remote2.run();
+	TEST_ASSERT_EQUAL_size_t(0, remoteConnections[1].queuedPackets());
+
+	// The ack payload of the base only rides on the ack of the selected peer
+	base.peer(1).setUseAckPayloads(true);
+	telemetry = 21;
+	TEST_ASSERT_TRUE(base.peer(1).sendPayload(&telemetry, sizeof telemetry));
+	TEST_ASSERT_EQUAL_size_t(1, baseConnection.queuedAckPayloads());
+	remote0.sendCommand(0, RemoteController::High);
+	TEST_ASSERT_EQUAL_size_t(1, baseConnection.queuedAckPayloads());
+	TEST_ASSERT_EQUAL_size_t(0, remoteConnections[0].queuedPackets());
+	remote1.setUseAckPayloads(false); // Writes again
+	remote1.sendCommand(1, RemoteController::High);
+	TEST_ASSERT_EQUAL_size_t(0, baseConnection.queuedAckPayloads());
+	TEST_ASSERT_EQUAL_size_t(1, remoteConnections[1].queuedPackets());
+
+	base.end();
+	remote0.end();
+	remote1.end();
+	remote2.end();
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+#include "Connections/SimulatedConnection.h"
+
+// Priority classes (Low, Normal, Urgent) and time to live of queued commands
+
+static uint8_t receivedOrder[16];
+static size_t receivedCount;
+
+static void recordOrder(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && receivedCount < sizeof receivedOrder; i++)
+	{
+		receivedOrder[receivedCount++] = commands[i];
+	}
+}
+
+void test_priority_mostUrgentFirst()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteControllerT<RemoteControllerPackageConfig<12, 3>> sender(senderConnection); // 2 v1 commands per packet
+	RemoteController receiver(receiverConnection);
+	receivedCount = 0;
+	sender.begin(nullptr);
+	receiver.begin(recordOrder);
+
+	sender.sendCommand(1, RemoteController::Low);
+	sender.sendCommand(2, RemoteController::Normal);
+	sender.sendCommand(3, RemoteController::Urgent);
+	sender.sendCommand(4);
+	sender.sendCommand(5, RemoteController::Urgent);
+	TEST_ASSERT_TRUE(sender.run());
+
+	// The first packet carries the urgent commands
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(2, receivedCount);
+	const uint8_t expected[] = {3, 5, 2, 4, 1};
+	receiver.setReceiveBudget(4);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(5, receivedCount);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, receivedOrder, sizeof expected);
+	sender.end();
+	receiver.end();
+}
+
+void test_priority_valuesOfOlderVersions()
+{
+	// Code that stores or casts a Priority keeps working, the new classes only get new values
+	TEST_ASSERT_EQUAL_UINT8(0, RemoteController::Normal);
+	TEST_ASSERT_EQUAL_UINT8(1, RemoteController::High);
+	TEST_ASSERT_TRUE(RemoteController::priorityRank(RemoteController::Low) < RemoteController::priorityRank(RemoteController::Normal));
+	TEST_ASSERT_TRUE(RemoteController::priorityRank(RemoteController::Normal) < RemoteController::priorityRank(RemoteController::Urgent));
+	TEST_ASSERT_TRUE(RemoteController::priorityRank(RemoteController::Urgent) < RemoteController::priorityRank(RemoteController::High));
+}
+
+void test_priority_coalesceKeepsHigherPriority()
+{
+	LoopbackConnection connection;
+	RemoteController rc(connection);
+	rc.begin(nullptr);
+	rc.setQueuePolicy(RemoteController::GoForward, RemoteController::Coalesce);
+	rc.sendCommand(RemoteController::GoLeft, 1.0f);
+	rc.sendCommand(RemoteController::GoForward, 0.25f, RemoteController::Urgent);
+	rc.sendCommand(RemoteController::GoForward, 0.5f, RemoteController::Low);
+	TEST_ASSERT_EQUAL_size_t(2, rc.commandQueueLength);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::GoForward, rc.queuedCommandAt(0).command);
+	TEST_ASSERT_EQUAL_FLOAT(0.5f, rc.queuedCommandAt(0).throttle);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Urgent, rc.queuedCommandAt(0).priority);
+	rc.end();
+}
+
+void test_ttl_staleCommandsDropped()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection;
+	SimulatedConnection receiverConnection(senderConnection);
+	SequencedController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	receivedCount = 0;
+	sender.begin(nullptr);
+	sender.setUseSequenceNumbers(true);
+
+	// Link dropout: the receiver is not listening
+	sender.sendCommand(RemoteController::GoForward, 0.8f, RemoteController::Normal, 100000); // 100 ms
+	sender.sendCommand(RemoteController::GoLeft, 0.5f, RemoteController::Normal, 2000000);	 // 2 s
+	sender.sendCommand(RemoteController::GoRight); // No time limit
+	TEST_ASSERT_FALSE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(1, sender.sequenceState->pinnedPackets);
+	TEST_ASSERT_EQUAL_size_t(3, sender.sequenceState->pinnedCommandCount);
+
+	SimulatedConnection::advance(1000000);
+	TEST_ASSERT_FALSE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(2, sender.commandQueueLength);
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(2, sender.sequenceState->pinnedCommandCount, "The failed packet is sent again without the expired command!");
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_EQUAL_UINT32(1, sender.getStatistics().commandsExpired);
+#endif
+
+	receiver.begin(recordOrder);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(2, receivedCount);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::GoLeft, receivedOrder[0]);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::GoRight, receivedOrder[1]);
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+void test_ttl_coarseDeadline()
+{
+	// The deadline is kept in 16-bit ticks of 1024 us: never dropped early, long times to live are shortened to REMOTECONTROLLER_MAX_TTL
+	TEST_ASSERT_EQUAL_size_t(8, sizeof(RemoteControllerTypes::QueuedCommand));
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection::advance(0xFFFFFFFF - SimulatedConnection::now() - 500); // rcmicros() overflows in between
+	LoopbackConnection connection;
+	RemoteController rc(connection);
+	rc.sendCommand(RemoteController::GoForward, 0.5f, RemoteController::Normal, 10000); // 10 ms
+	rc.sendCommand(RemoteController::GoLeft, 0.5f, RemoteController::Normal, 0xFFFFFFFF); // Shortened
+	SimulatedConnection::advance(9999);
+	rc.dropExpiredCommands();
+	TEST_ASSERT_EQUAL_size_t(2, rc.commandQueueLength);
+	SimulatedConnection::advance(1025);
+	rc.dropExpiredCommands();
+	TEST_ASSERT_EQUAL_size_t(1, rc.commandQueueLength);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::GoLeft, rc.queuedCommandAt(0).command);
+	SimulatedConnection::advance(REMOTECONTROLLER_MAX_TTL - 20000);
+	rc.dropExpiredCommands();
+	TEST_ASSERT_EQUAL_size_t(1, rc.commandQueueLength);
+	SimulatedConnection::advance(20000);
+	rc.dropExpiredCommands();
+	TEST_ASSERT_EQUAL_size_t(0, rc.commandQueueLength);
+	SimulatedConnection::useVirtualClock(false);
+}
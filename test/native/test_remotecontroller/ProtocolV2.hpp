@@ -0,0 +1,173 @@
+#pragma once
+#include <ArduinoFake.h>
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+using namespace fakeit;
+
+// RemoteController-Protocol v2 (compact throttle encoding)
+
+void test_protocolV2_encoding()
+{
+	Mock<Connection> mockConnection;
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, begin)).Return(true);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(32);
+	When(Method(mockConnection, write))
+		.Do([](const void *buffer, size_t length) -> bool
+			{
+			const uint8_t expected[] = {
+				(uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 >> 8), (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND_V2,
+				0x01, RemoteController::ThrottleNone,
+				0x02, RemoteController::ThrottleUInt8, 200,
+				0x03, RemoteController::ThrottleUInt16, 0xE8, 0x03,
+				0x04, RemoteController::ThrottleUnit16, 0x00, 0x80,
+				0x05, RemoteController::ThrottleFloat, 0x00, 0x00, 0x60, 0xC0};
+			TEST_ASSERT_EQUAL_size_t(sizeof expected, length);
+			TEST_ASSERT_EQUAL_MEMORY(expected, buffer, sizeof expected);
+			return true; });
+	When(Method(mockConnection, available)).Return(false);
+	RemoteController rc(mockConnection.get());
+	rc.begin(nullptr);
+	rc.setProtocolVersion(RemoteController::ProtocolV2);
+	rc.sendCommand(0x01, RemoteController::Normal);
+	rc.sendCommand(0x02, 200, RemoteController::Normal);
+	rc.sendCommand(0x03, 1000, RemoteController::Normal);
+	rc.sendCommand(0x04, 0.5f, RemoteController::Normal);
+	rc.sendCommand(0x05, -3.5f, RemoteController::Normal);
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_TRUE(Verify(Method(mockConnection, write)).Once());
+	rc.end();
+}
+
+void test_protocolV2_packing()
+{
+	Mock<Connection> mockConnection;
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, begin)).Return(true);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(32);
+	int writeCalled = 0;
+	When(Method(mockConnection, write))
+		.AlwaysDo([&writeCalled](const void *buffer, size_t length) -> bool
+				  {
+			writeCalled++;
+			// 10 commands with a uint8 throttle (3 bytes each) fit into one 32 byte packet, instead of 6 with v1
+			TEST_ASSERT_EQUAL_size_t(writeCalled == 1 ? 32 : 2 + 3 * 3, length);
+			return true; });
+	When(Method(mockConnection, available)).Return(false);
+	RemoteController rc(mockConnection.get());
+	rc.begin(nullptr);
+	rc.setProtocolVersion(RemoteController::ProtocolV2);
+	for (uint8_t i = 0; i < 10; i++)
+	{
+		rc.sendCommand(i, 100 + i, RemoteController::Normal);
+	}
+	rc.run();
+	TEST_ASSERT_TRUE(Verify(Method(mockConnection, write)).Once());
+	rc.end();
+}
+
+void test_protocolV2_receive()
+{
+	Mock<Connection> mockConnection;
+	When(Method(mockConnection, begin)).Return(true);
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, available)).AlwaysReturn(true);
+	When(Method(mockConnection, read)).AlwaysDo([](void *buffer, size_t length) -> void
+												{
+		const uint8_t packet[] = {
+			(uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 >> 8), (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND_V2,
+			0x32, RemoteController::ThrottleUInt8, 200,
+			0x55, RemoteController::ThrottleNone,
+			0x56, RemoteController::ThrottleUnit16, 0xFF, 0xFF};
+		memcpy(buffer, packet, length); });
+	When(Method(mockConnection, getPayloadSize)).AlwaysReturn(11);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(32);
+
+	RemoteController rc(mockConnection.get());
+	int clb = 0;
+	rc.begin([&clb](const uint8_t commands[], const float throttle[], size_t length) -> void
+			 {
+		clb += 1;
+		TEST_ASSERT_EQUAL_size_t(3, length);
+		TEST_ASSERT_EQUAL_UINT8(0x32, commands[0]);
+		TEST_ASSERT_EQUAL_FLOAT(200, throttle[0]);
+		TEST_ASSERT_EQUAL_UINT8(0x55, commands[1]);
+		TEST_ASSERT_EQUAL_FLOAT(0, throttle[1]);
+		TEST_ASSERT_EQUAL_UINT8(0x56, commands[2]);
+		TEST_ASSERT_EQUAL_FLOAT(1.0f, throttle[2]); });
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(1, clb, "The Callback function has to be called exactly once!");
+	rc.end();
+}
+
+void test_protocolV2_receiveCorrupt()
+{
+	Mock<Connection> mockConnection;
+	When(Method(mockConnection, begin)).Return(true);
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, available)).AlwaysReturn(true);
+	When(Method(mockConnection, read)).AlwaysDo([](void *buffer, size_t length) -> void
+												{
+		const uint8_t packet[] = {
+			(uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 >> 8), (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND_V2,
+			0x32, 0x7F, 200}; // Unknown throttle encoding
+		memcpy(buffer, packet, length); });
+	When(Method(mockConnection, getPayloadSize)).AlwaysReturn(5);
+
+	RemoteController rc(mockConnection.get());
+	int clb = 0;
+	rc.begin([&clb](const uint8_t commands[], const float throttle[], size_t length) -> void
+			 { clb += 1; });
+	TEST_ASSERT_FALSE(rc.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::ReceivedCorruptPacket, rc.getErrorCode());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(0, clb, "Corrupt packets must not be passed to the callback");
+	rc.end();
+}
+
+void test_protocolV1andV2_loopback()
+{
+	LoopbackConnection connectionA;
+	LoopbackConnection connectionB(connectionA);
+	RemoteController rcA(connectionA);
+	RemoteController rcB(connectionB);
+	static uint8_t receivedCommands[8];
+	static float receivedThrottles[8];
+	static size_t received;
+	received = 0;
+	rcA.begin(nullptr);
+	rcB.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+			  {
+		for (size_t i = 0; i < length && received < 8; i++, received++)
+		{
+			receivedCommands[received] = commands[i];
+			receivedThrottles[received] = throttles[i];
+		} });
+
+	rcA.sendCommand(0x10, 0.25f);
+	rcA.run();
+	rcB.run();
+	rcA.setProtocolVersion(RemoteController::ProtocolV2);
+	rcA.sendCommand(0x11, 0.25f);
+	rcA.sendCommand(0x12, 70000);
+	rcA.sendCommand(0x13, 12);
+	rcA.run();
+	rcB.run();
+
+	TEST_ASSERT_EQUAL_size_t(4, received);
+	TEST_ASSERT_EQUAL_UINT8(0x10, receivedCommands[0]);
+	TEST_ASSERT_EQUAL_FLOAT(0.25f, receivedThrottles[0]);
+	TEST_ASSERT_EQUAL_UINT8(0x11, receivedCommands[1]);
+	TEST_ASSERT_FLOAT_WITHIN(1.0f / 65535, 0.25f, receivedThrottles[1]);
+	TEST_ASSERT_EQUAL_UINT8(0x12, receivedCommands[2]);
+	TEST_ASSERT_EQUAL_FLOAT(70000, receivedThrottles[2]);
+	TEST_ASSERT_EQUAL_UINT8(0x13, receivedCommands[3]);
+	TEST_ASSERT_EQUAL_FLOAT(12, receivedThrottles[3]);
+	rcA.end();
+	rcB.end();
+}
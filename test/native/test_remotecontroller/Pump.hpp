@@ -0,0 +1,285 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MpscRing.h"
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// MpscRing and RemoteController::startPump() (multi-producer sendCommand)
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::Pump>> PumpedController; // RemoteController with the default sizes and RemoteController::Pump
+
+void test_mpscRing_stress()
+{
+	static const size_t Producers = 4;
+	static const uint32_t Values = 20000; // per producer
+	static MpscRing<uint32_t, 16> ring; // Small, so the producers run into a full ring all the time
+
+	std::vector<std::thread> producers;
+	for (uint32_t producer = 0; producer < Producers; producer++)
+	{
+		producers.emplace_back([producer]
+							   {
+			for (uint32_t value = 0; value < Values;)
+			{
+				if (ring.push(producer << 24 | value))
+					value++;
+				else
+					std::this_thread::yield();
+			} });
+	}
+
+	// Every value arrives exactly once and in order per producer
+	uint32_t next[Producers] = {};
+	size_t received = 0;
+	bool ordered = true;
+	while (received < Producers * Values)
+	{
+		uint32_t value;
+		if (!ring.pop(value))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		const uint32_t producer = value >> 24;
+		ordered = ordered && producer < Producers && (value & 0xFFFFFF) == next[producer];
+		next[producer]++;
+		received++;
+	}
+	for (std::thread &producer : producers)
+	{
+		producer.join();
+	}
+	TEST_ASSERT_TRUE(ordered);
+	uint32_t value;
+	TEST_ASSERT_FALSE(ring.pop(value));
+	TEST_ASSERT_GREATER_THAN_UINT32(0, ring.takeDrops());
+	TEST_ASSERT_EQUAL_UINT32(0, ring.takeDrops());
+}
+
+/**
+ * @brief LoopbackConnection for two pumps: both ends are used from different threads
+ *
+ */
+class LockedLoopbackConnection : public LoopbackConnection
+{
+public:
+	LockedLoopbackConnection() {}
+	LockedLoopbackConnection(LockedLoopbackConnection &peer) : LoopbackConnection(peer) {}
+	bool available()
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		return LoopbackConnection::available();
+	}
+	void read(void *buffer, size_t length)
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		LoopbackConnection::read(buffer, length);
+	}
+	size_t getPayloadSize()
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		return LoopbackConnection::getPayloadSize();
+	}
+	bool write(const void *buffer, size_t length)
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		return LoopbackConnection::write(buffer, length); // (The default writeBatch() calls this)
+	}
+
+private:
+	static std::mutex &mutex()
+	{
+		static std::mutex shared; // One lock for both ends, a write touches the queue of the peer
+		return shared;
+	}
+};
+
+static const size_t PumpProducers = 4;
+static const size_t PumpCommands = 300; // per producer
+static std::atomic<size_t> pumpReceived{0};
+static uint32_t pumpNextThrottle[PumpProducers];
+static bool pumpOrdered = true;
+static std::thread::id pumpCallbackThread;
+
+static void countPumpedCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	if (pumpCallbackThread == std::thread::id())
+		pumpCallbackThread = std::this_thread::get_id(); // The first callbacks come from the pump, the last ones from the test after stopping it
+	for (size_t i = 0; i < length; i++)
+	{
+		// Commands of one producer may be dropped (full queue), but never reordered
+		const uint32_t throttle = (uint32_t)throttles[i];
+		pumpOrdered = pumpOrdered && commands[i] < PumpProducers && throttle >= pumpNextThrottle[commands[i]];
+		if (commands[i] < PumpProducers)
+			pumpNextThrottle[commands[i]] = throttle + 1;
+	}
+	pumpReceived += length;
+}
+
+void test_pump_multiProducerSendCommand()
+{
+	LockedLoopbackConnection senderConnection;
+	LockedLoopbackConnection receiverConnection(senderConnection);
+	PumpedController sender(senderConnection);
+	PumpedController receiver(receiverConnection);
+	pumpReceived = 0;
+	pumpOrdered = true;
+	memset(pumpNextThrottle, 0, sizeof pumpNextThrottle);
+	pumpCallbackThread = std::thread::id();
+	sender.begin(nullptr);
+	receiver.begin(countPumpedCommands);
+	receiver.setReceiveBudget(REMOTECONTROLLER_LOOPBACK_QUEUE_LENGTH);
+
+	TEST_ASSERT_TRUE(receiver.startPump(100));
+	TEST_ASSERT_TRUE(sender.startPump(100));
+	TEST_ASSERT_FALSE(sender.startPump(100));
+	TEST_ASSERT_TRUE(sender.isPumpRunning());
+
+	std::vector<std::thread> producers;
+	for (uint8_t producer = 0; producer < PumpProducers; producer++)
+	{
+		producers.emplace_back([&sender, producer]
+							   {
+			// One priority per producer, a Priority::High command overtakes the queued Normal ones
+			const RemoteController::Priority priority = producer == 0 ? RemoteController::High : RemoteController::Normal;
+			for (size_t i = 0; i < PumpCommands; i++)
+			{
+				sender.sendCommand(producer, (float)i, priority);
+				if (i % 8 == 0)
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+			} });
+	}
+	for (std::thread &producer : producers)
+	{
+		producer.join();
+	}
+
+	// Send what is left without the pumps
+	sender.stopPump();
+	TEST_ASSERT_FALSE(sender.isPumpRunning());
+	for (size_t i = 0; i < 100 && sender.commandQueueLength != 0; i++)
+	{
+		sender.run();
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	receiver.stopPump();
+	while (receiverConnection.available())
+	{
+		receiver.run();
+	}
+
+	TEST_ASSERT_EQUAL_size_t(0, sender.commandQueueLength);
+	TEST_ASSERT_TRUE(pumpOrdered);
+	TEST_ASSERT_GREATER_THAN_size_t(0, pumpReceived.load());
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(PumpProducers * PumpCommands, pumpReceived + sender.getStatistics().commandsDropped, "Every command is either received or counted as dropped!");
+#else
+	TEST_ASSERT_TRUE(pumpReceived <= PumpProducers * PumpCommands);
+#endif
+	TEST_ASSERT_TRUE_MESSAGE(pumpCallbackThread != std::thread::id() && pumpCallbackThread != std::this_thread::get_id(), "The callbacks run on the pump thread!");
+	sender.end();
+	receiver.end();
+}
+
+/**
+ * @brief Connection that accepts every packet and counts the commands, optionally stops the pump from its thread after some commands
+ *
+ */
+class PumpSinkConnection : public Connection
+{
+public:
+	bool begin() { return true; }
+	void end() {}
+	bool available() { return false; }
+	void read(void *buffer, size_t length) {}
+	size_t getPayloadSize() { return 0; }
+	bool write(const void *buffer, size_t length)
+	{
+		commands += (length - 2) / REMOTECONTROLLER_ENCODED_COMMAND_SIZE; // RemoteController-Protocol v1
+		if (stopAfter && commands >= stopAfter)
+		{
+			stopAfter = 0;
+			std::this_thread::sleep_for(std::chrono::microseconds(500)); // The producer fills the ring meanwhile
+			rc->stopPump(); // Like a callback on the pump thread
+		}
+		return true;
+	}
+	size_t getMaxPackageSize() { return 32; }
+
+	PumpedController *rc = nullptr;
+	size_t stopAfter = 0;
+	std::atomic<size_t> commands{0};
+};
+
+/**
+ * @brief One producer keeps sending while the pump is stopped, no command may be left behind in the ring
+ *
+ * @param fromPump stop the pump from its own thread instead of the test thread
+ */
+static void pumpStopWhileSending(bool fromPump)
+{
+	PumpSinkConnection connection;
+	PumpedController rc(connection);
+	connection.rc = &rc;
+	connection.stopAfter = fromPump ? 2000 : 0;
+	rc.begin(nullptr);
+	TEST_ASSERT_TRUE(rc.startPump(50));
+
+	std::atomic<size_t> sent{0};
+	std::thread producer([&]
+						 {
+		// Sends until the pump is gone, the last calls race with the stop
+		while (rc.isPumpRunning())
+		{
+			rc.sendCommand(1, (float)sent);
+			sent++;
+		} });
+	if (!fromPump)
+	{
+		while (connection.commands < 2000)
+		{
+			std::this_thread::yield();
+		}
+		rc.stopPump();
+		TEST_ASSERT_FALSE(rc.isPumpRunning());
+	}
+	producer.join();
+
+	// Before joining the pump thread after a stop from the pump: the ring was drained once isPumpRunning() returned false
+	TEST_ASSERT_GREATER_THAN_size_t(0, connection.commands);
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(sent.load(), connection.commands + rc.commandQueueLength + rc.getStatistics().commandsDropped, "Every command is either sent, queued or counted as dropped!");
+#else
+	TEST_ASSERT_TRUE(connection.commands + rc.commandQueueLength <= sent.load());
+#endif
+	rc.stopPump();
+	rc.end();
+}
+
+void test_pump_stopWhileSending()
+{
+	pumpStopWhileSending(false);
+	pumpStopWhileSending(true);
+}
+
+void test_pump_needsFeature()
+{
+	LoopbackConnection connection;
+	RemoteController rc(connection);
+	RemoteControllerBase &base = rc; // RemoteControllerT::startPump() does not compile without RemoteController::Pump
+	rc.begin(nullptr);
+	TEST_ASSERT_FALSE_MESSAGE(base.startPump(50), "No pump without RemoteController::Pump!");
+	TEST_ASSERT_FALSE(rc.isPumpRunning());
+	rc.sendCommand(1, 10);
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(1, rc.commandQueueLength, "Without the pump sendCommand() queues the command itself!");
+	rc.stopPump();
+	rc.end();
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <ArduinoFake.h>
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+
+using namespace fakeit;
+
+// RemoteController::setQueuePolicy() (latest value wins command coalescing)
+
+void test_queuePolicy_default()
+{
+	Mock<Connection> mockConnection;
+	RemoteController rc(mockConnection.get());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0x00));
+	rc.setQueuePolicy(0x09, RemoteController::Coalesce);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Coalesce, rc.getQueuePolicy(0x09));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0x08));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0x0A));
+	rc.setQueuePolicy(RemoteController::Coalesce);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Coalesce, rc.getQueuePolicy(0xFF));
+	rc.setQueuePolicy(0x09, RemoteController::Append);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0x09));
+	rc.setQueuePolicy(RemoteController::Append);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0xFF));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0x09));
+
+	// Only a few commands can differ from the policy of all commands
+	for (uint8_t command = 0; command < REMOTECONTROLLER_POLICY_COMMANDS; command++)
+	{
+		TEST_ASSERT_TRUE(rc.setQueuePolicy(command, RemoteController::Coalesce));
+	}
+	TEST_ASSERT_TRUE(rc.setQueuePolicy(0, RemoteController::Coalesce)); // Already set
+	TEST_ASSERT_FALSE(rc.setQueuePolicy(0xF0, RemoteController::Coalesce));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0xF0));
+	TEST_ASSERT_TRUE(rc.setQueuePolicy(0, RemoteController::Append));
+	TEST_ASSERT_TRUE(rc.setQueuePolicy(0xF0, RemoteController::Coalesce));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Append, rc.getQueuePolicy(0));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::Coalesce, rc.getQueuePolicy(0xF0));
+}
+
+void test_queuePolicy_coalesce()
+{
+	Mock<Connection> mockConnection;
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, begin)).Return(true);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(32);
+	When(Method(mockConnection, write))
+		.Do([](const void *buffer, size_t length) -> bool
+			{
+			uint8_t *pStart = reinterpret_cast<unsigned char *>(const_cast<void *>(buffer));
+			TEST_ASSERT_EQUAL_size_t(2 + 3 * 5, length);
+			pStart += 2;
+			// The coalesced command keeps its position in the queue but carries the latest throttle
+			TEST_ASSERT_EQUAL_UINT8(RemoteController::GoForward, *(pStart));
+			TEST_ASSERT_EQUAL_FLOAT(30, *(float *)(++pStart));
+			pStart += 4;
+			TEST_ASSERT_EQUAL_UINT8(RemoteController::GoLeft, *(pStart));
+			TEST_ASSERT_EQUAL_FLOAT(1, *(float *)(++pStart));
+			pStart += 4;
+			TEST_ASSERT_EQUAL_UINT8(RemoteController::GoLeft, *(pStart));
+			TEST_ASSERT_EQUAL_FLOAT(2, *(float *)(++pStart));
+			return true; });
+	When(Method(mockConnection, available)).Return(false);
+	RemoteController rc(mockConnection.get());
+	rc.begin(nullptr);
+	rc.setQueuePolicy(RemoteController::GoForward, RemoteController::Coalesce);
+	rc.sendCommand(RemoteController::GoForward, 10);
+	rc.sendCommand(RemoteController::GoLeft, 1);
+	rc.sendCommand(RemoteController::GoForward, 20);
+	rc.sendCommand(RemoteController::GoLeft, 2);
+	rc.sendCommand(RemoteController::GoForward, 30);
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_TRUE(Verify(Method(mockConnection, write)).Once());
+	rc.end();
+}
+
+void test_queuePolicy_coalesceDoesNotFillQueue()
+{
+	Mock<Connection> mockConnection;
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, begin)).Return(true);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(32);
+	When(Method(mockConnection, write))
+		.Do([](const void *buffer, size_t length) -> bool
+			{
+			TEST_ASSERT_EQUAL_size_t(2 + 5, length);
+			TEST_ASSERT_EQUAL_FLOAT(99, *(float *)((uint8_t *)buffer + 3));
+			return true; });
+	When(Method(mockConnection, available)).Return(false);
+	RemoteController rc(mockConnection.get());
+	rc.begin(nullptr);
+	rc.setQueuePolicy(RemoteController::Coalesce);
+	for (int i = 0; i < 100; i++)
+	{
+		rc.sendCommand(RemoteController::GoForward, i);
+	}
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::NoError, rc.getErrorCode());
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_TRUE(Verify(Method(mockConnection, write)).Once());
+	rc.end();
+}
@@ -5,6 +5,7 @@
 #include <stdint.h>
 
 #include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
 
 using namespace fakeit;
 
@@ -77,4 +78,113 @@ void test_receivePayload()
 	rc.run();
 	TEST_ASSERT_EQUAL_INT_MESSAGE(16, clb, "Exactly 16 bytes of data have to be received");
 	rc.end();
-}
\ No newline at end of file
+}
+// RemoteController::setReceiveBudget() and RemoteController::setAggregateCommands()
+
+static int receiveBudgetCallbacks;
+static size_t receiveBudgetCommands;
+
+static void sendReceiveBudgetPackets(RemoteController &sender, int packets)
+{
+	for (int i = 0; i < packets; i++)
+	{
+		sender.sendCommand(RemoteController::GoForward, i, RemoteController::High); // One packet each
+	}
+}
+
+void test_receiveBudget_packets()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	receiveBudgetCallbacks = 0;
+	receiveBudgetCommands = 0;
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   {
+		receiveBudgetCallbacks++;
+		receiveBudgetCommands += length; });
+
+	sendReceiveBudgetPackets(sender, 5);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(1, receiveBudgetCallbacks, "By default only one packet is handled per run() call");
+
+	receiver.setReceiveBudget(3);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT(4, receiveBudgetCallbacks);
+	TEST_ASSERT_EQUAL_size_t(1, receiverConnection.queuedPackets());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT(5, receiveBudgetCallbacks);
+	TEST_ASSERT_EQUAL_size_t(5, receiveBudgetCommands);
+	sender.end();
+	receiver.end();
+}
+
+void test_receiveBudget_micros()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	receiveBudgetCallbacks = 0;
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   {
+		receiveBudgetCallbacks++;
+		uint32_t start = rcmicros();
+		// Busy application callback, takes 2 ms
+		while ((uint32_t)(rcmicros() - start) < 2000) {} });
+
+	sendReceiveBudgetPackets(sender, 3);
+	receiver.setReceiveBudget(10, 1000);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(1, receiveBudgetCallbacks, "The time budget is used up after the first packet");
+	receiver.setReceiveBudget(10);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT(3, receiveBudgetCallbacks);
+	sender.end();
+	receiver.end();
+}
+
+void test_receiveBudget_aggregateCommands()
+{
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	receiveBudgetCallbacks = 0;
+	receiveBudgetCommands = 0;
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   {
+		receiveBudgetCallbacks++;
+		for (size_t i = 0; i < length; i++)
+		{
+			TEST_ASSERT_EQUAL_FLOAT(receiveBudgetCommands + i, throttles[i]);
+		}
+		receiveBudgetCommands += length; });
+	receiver.setReceiveBudget(8);
+	receiver.setAggregateCommands(true);
+
+	sendReceiveBudgetPackets(sender, 3);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(1, receiveBudgetCallbacks, "The commands of all packets are delivered with one callback");
+	TEST_ASSERT_EQUAL_size_t(3, receiveBudgetCommands);
+
+	// More commands than fit into the callback arrays
+	senderConnection.setMaxPackageSize(2 + 6 * REMOTECONTROLLER_ENCODED_COMMAND_SIZE);
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 6; j++)
+		{
+			sender.sendCommand(RemoteController::GoForward, 3 + i * 6 + j);
+		}
+		sender.run();
+	}
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(1 + 18 / REMOTECONTROLLER_INCOMING_CALLBACK_ARRAY_LENGTH, receiveBudgetCallbacks, "One callback per full callback array");
+	TEST_ASSERT_EQUAL_size_t(21, receiveBudgetCommands);
+	sender.end();
+	receiver.end();
+}
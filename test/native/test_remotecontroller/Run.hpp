@@ -24,4 +24,72 @@ void test_run()
 	TEST_ASSERT_FALSE(rc.run());
 	TEST_ASSERT_EQUAL_UINT8(RemoteController::Error::FailedToTransmitCommands, rc.getErrorCode());
 	rc.end();
-}
\ No newline at end of file
+}
+void test_run_resumesPartialTransmission()
+{
+	Mock<Connection> mockConnection;
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, begin)).Return(true);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(7); // One command per packet
+	static uint8_t written[8];
+	static int writeCalled, writeSucceeded;
+	writeCalled = 0;
+	writeSucceeded = 0;
+	When(Method(mockConnection, write))
+		.AlwaysDo([](const void *buffer, size_t length) -> bool
+				  {
+			if (++writeCalled == 3)
+			{
+				return false; // The third packet is not acked
+			}
+			written[writeSucceeded++] = *((const uint8_t *)buffer + 2);
+			return true; });
+	When(Method(mockConnection, available)).AlwaysReturn(false);
+	RemoteController rc(mockConnection.get());
+	rc.begin(nullptr);
+	rc.sendCommand(0x01);
+	rc.sendCommand(0x02);
+	rc.sendCommand(0x03);
+	rc.sendCommand(0x04);
+	TEST_ASSERT_FALSE(rc.run());
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::FailedToTransmitCommands, rc.getErrorCode());
+
+	// New commands can be queued while the rest of the batch is pending
+	rc.sendCommand(0x05);
+	TEST_ASSERT_TRUE(rc.run());
+	TEST_ASSERT_EQUAL_INT_MESSAGE(6, writeCalled, "Only the packets that were not acked should be transmitted again");
+	const uint8_t expected[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+	TEST_ASSERT_EQUAL_INT(5, writeSucceeded);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, written, 5);
+	rc.end();
+}
+
+void test_run_commandQueueWrapsAround()
+{
+	Mock<Connection> mockConnection;
+	Fake(Method(mockConnection, end));
+	When(Method(mockConnection, begin)).Return(true);
+	When(Method(mockConnection, getMaxPackageSize)).AlwaysReturn(7);
+	static uint8_t expectedCommand;
+	expectedCommand = 0;
+	When(Method(mockConnection, write))
+		.AlwaysDo([](const void *buffer, size_t length) -> bool
+				  {
+			TEST_ASSERT_EQUAL_UINT8(expectedCommand, *((const uint8_t *)buffer + 2));
+			expectedCommand++;
+			return true; });
+	When(Method(mockConnection, available)).AlwaysReturn(false);
+	RemoteController rc(mockConnection.get());
+	rc.begin(nullptr);
+	uint8_t command = 0;
+	for (int round = 0; round < 5; round++)
+	{
+		for (int i = 0; i < REMOTECONTROLLER_COMMAND_QUEUE_LENGTH - 3; i++)
+		{
+			rc.sendCommand(command++);
+		}
+		TEST_ASSERT_TRUE(rc.run());
+	}
+	TEST_ASSERT_EQUAL_UINT8(command, expectedCommand);
+	rc.end();
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/SimulatedConnection.h"
+
+// RemoteController::setUseSequenceNumbers() (duplicate suppression) and RemoteController::setDeliveryMode()
+
+typedef RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::SequenceNumbers>> SequencedController; // RemoteController with the default sizes and RemoteController::SequenceNumbers
+
+static const uint8_t ToggleLED = 10; // One-shot command that must not be executed twice
+
+static size_t sequencedCommands[256];
+
+static void countSequencedCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		sequencedCommands[commands[i]]++;
+	}
+}
+
+/**
+ * @brief Sends ToggleLED over a channel that loses the first acknowledgement, the packet arrives but is sent again
+ *
+ * @return size_t how often the receiver got ToggleLED
+ */
+static size_t toggleAfterLostAck(bool useSequenceNumbers)
+{
+	SimulatedConnection senderConnection;
+	SimulatedConnection receiverConnection(senderConnection);
+	SequencedController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	memset(sequencedCommands, 0, sizeof sequencedCommands);
+	sender.begin(nullptr);
+	receiver.begin(countSequencedCommands);
+	receiver.setReceiveBudget(4);
+	sender.setUseSequenceNumbers(useSequenceNumbers);
+
+	SimulatedConnection::Channel channel;
+	channel.ackLoss = 1.0f;
+	senderConnection.setChannel(channel);
+	sender.sendCommand(ToggleLED);
+	TEST_ASSERT_FALSE(sender.run());
+	TEST_ASSERT_EQUAL_UINT32(1, senderConnection.acksLost);
+
+	channel.ackLoss = 0;
+	senderConnection.setChannel(channel);
+	sender.sendCommand(RemoteController::GoForward, 0.5f); // Queued after the failed packet
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(1, sequencedCommands[RemoteController::GoForward]);
+	sender.end();
+	receiver.end();
+	return sequencedCommands[ToggleLED];
+}
+
+void test_sequenceNumbers_duplicateDropped()
+{
+	TEST_ASSERT_EQUAL_size_t_MESSAGE(2, toggleAfterLostAck(false), "Without sequence numbers the retransmission is executed twice!");
+	TEST_ASSERT_EQUAL_size_t(1, toggleAfterLostAck(true));
+}
+
+void test_sequenceNumbers_window()
+{
+	LoopbackConnection connection;
+	RemoteController rc(connection);
+	TEST_ASSERT_TRUE(rc.acceptSequence(0x80 | 10)); // Sync: first packet
+	TEST_ASSERT_FALSE(rc.acceptSequence(0x80 | 10)); // Retransmission of the first packet
+	TEST_ASSERT_TRUE(rc.acceptSequence(12));
+	TEST_ASSERT_TRUE(rc.acceptSequence(11)); // Reordered
+	TEST_ASSERT_FALSE(rc.acceptSequence(11));
+	TEST_ASSERT_FALSE(rc.acceptSequence(12));
+	TEST_ASSERT_TRUE(rc.acceptSequence(127)); // Wraps around from 127 to 0 without the window getting confused
+	TEST_ASSERT_TRUE(rc.acceptSequence(1));
+	TEST_ASSERT_TRUE(rc.acceptSequence(0));
+	TEST_ASSERT_FALSE(rc.acceptSequence(127));
+	TEST_ASSERT_FALSE_MESSAGE(rc.acceptSequence(1 - REMOTECONTROLLER_SEQUENCE_WINDOW + 128), "Too old to tell, dropped!");
+
+	// The sender was reset: its sequence numbers start over and the receiver restarts the window
+	TEST_ASSERT_TRUE(rc.acceptSequence(0x80 | 0));
+	TEST_ASSERT_FALSE(rc.acceptSequence(0x80 | 0));
+	TEST_ASSERT_TRUE(rc.acceptSequence(1));
+}
+
+void test_sequenceNumbers_deliveryModes()
+{
+	SimulatedConnection senderConnection;
+	SimulatedConnection receiverConnection(senderConnection);
+	SequencedController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	memset(sequencedCommands, 0, sizeof sequencedCommands);
+	sender.begin(nullptr);
+	receiver.begin(countSequencedCommands);
+	receiver.setReceiveBudget(4);
+	sender.setUseSequenceNumbers(true);
+	sender.setDeliveryMode(RemoteController::GoForward, RemoteController::AtMostOnce);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::AtMostOnce, sender.getDeliveryMode(RemoteController::GoForward));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::AtLeastOnce, sender.getDeliveryMode(ToggleLED));
+
+	// The packet is lost: the throttle is dropped, the toggle is sent again
+	SimulatedConnection::Channel channel;
+	channel.loss = 1.0f;
+	senderConnection.setChannel(channel);
+	sender.sendCommand(RemoteController::GoForward, 0.25f);
+	sender.sendCommand(ToggleLED);
+	TEST_ASSERT_FALSE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(1, sender.commandQueueLength);
+	TEST_ASSERT_EQUAL_size_t(1, sender.sequenceState->pinnedPackets);
+
+	channel.loss = 0;
+	senderConnection.setChannel(channel);
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(0, sequencedCommands[RemoteController::GoForward]);
+	TEST_ASSERT_EQUAL_size_t(1, sequencedCommands[ToggleLED]);
+
+	// High priority: an at most once command is not queued after a failed write
+	sender.setUseSequenceNumbers(false);
+	channel.loss = 1.0f;
+	senderConnection.setChannel(channel);
+	sender.sendCommand(RemoteController::GoForward, 0.5f, RemoteController::High);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::FailedToTransmitCommands, sender.getErrorCode());
+	TEST_ASSERT_EQUAL_size_t(0, sender.commandQueueLength);
+	sender.end();
+	receiver.end();
+}
+
+void test_sequenceNumbers_exactlyOnceUnderLoss()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection(31);
+	SimulatedConnection receiverConnection(senderConnection, 32);
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.2f;
+	channel.ackLoss = 0.2f;
+	channel.latencyMicros = 200;
+	senderConnection.setChannel(channel);
+	RemoteControllerT<RemoteControllerFeatureConfig<RemoteController::SequenceNumbers>, SimulatedConnection> sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+	memset(sequencedCommands, 0, sizeof sequencedCommands);
+	sender.begin(nullptr);
+	sender.setUseSequenceNumbers(true);
+	sender.setProtocolVersion(RemoteController::ProtocolV2);
+	receiver.begin(countSequencedCommands);
+	receiver.setReceiveBudget(8);
+
+	for (size_t i = 0; i < 200; i++)
+	{
+		sender.sendCommand((uint8_t)i);
+		if (i % 3 == 0)
+		{
+			sender.sendCommand((uint8_t)(i + 1000), RemoteController::High);
+		}
+		sender.run();
+		SimulatedConnection::advance(500);
+		receiver.run();
+	}
+	for (size_t i = 0; i < 100 && sender.commandQueueLength; i++)
+	{
+		sender.run();
+		SimulatedConnection::advance(500);
+		receiver.run();
+	}
+	TEST_ASSERT_TRUE(senderConnection.acksLost > 0);
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_TRUE(receiver.getStatistics().duplicatePackets > 0);
+#endif
+	// Every command arrived exactly once (200 normal, 67 high priority)
+	size_t total = 0;
+	for (size_t command = 0; command < 256; command++)
+	{
+		total += sequencedCommands[command];
+	}
+	TEST_ASSERT_EQUAL_size_t(200 + 67, total);
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+void test_sequenceNumbers_featureDisabled()
+{
+	// Without RemoteController::SequenceNumbers the state is not allocated, every command is sent at least once without a sequence number
+	TEST_ASSERT_TRUE(sizeof(RemoteController) < sizeof(SequencedController));
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteController sender(senderConnection);
+	RemoteControllerBase &base = sender;
+	base.setUseSequenceNumbers(true);
+	TEST_ASSERT_FALSE(base.setDeliveryMode(RemoteController::GoForward, RemoteController::AtMostOnce));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::AtLeastOnce, sender.getDeliveryMode(RemoteController::GoForward));
+	receiverConnection.begin();
+	sender.begin(nullptr);
+	sender.sendCommand(RemoteController::GoForward, 0.5f);
+	TEST_ASSERT_TRUE(sender.run());
+	uint8_t packet[32];
+	TEST_ASSERT_TRUE(receiverConnection.available());
+	receiverConnection.read(packet, sizeof packet);
+	TEST_ASSERT_EQUAL_HEX8(REMOTECONTROLLER_IDENTIFIER_COMMAND & 0xFF, packet[1]); // No sequence number
+	sender.end();
+	receiverConnection.end();
+
+	// The delivery modes of single commands are kept in a short list like the queue policies
+	SequencedController sequenced(senderConnection);
+	for (uint8_t command = 0; command < REMOTECONTROLLER_POLICY_COMMANDS; command++)
+	{
+		TEST_ASSERT_TRUE(sequenced.setDeliveryMode(command, RemoteController::AtMostOnce));
+	}
+	TEST_ASSERT_FALSE(sequenced.setDeliveryMode(0xF0, RemoteController::AtMostOnce));
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::AtLeastOnce, sequenced.getDeliveryMode(0xF0));
+	sequenced.setDeliveryMode(RemoteController::AtMostOnce);
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::AtMostOnce, sequenced.getDeliveryMode(0xF0));
+}
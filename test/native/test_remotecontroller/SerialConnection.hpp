@@ -0,0 +1,208 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "RemoteController.h"
+#include "Connections/SerialConnection.h"
+
+// SerialConnection (COBS framing over a Stream), on a memory stream and on a pseudo-terminal
+
+/**
+ * @brief NativeStream over a byte queue, SerialConnection writes to it and reads from it
+ *
+ */
+class MemoryStream : public NativeStream
+{
+public:
+	int available() { return (int)(length - position); }
+	int read() { return position < length ? bytes[position++] : -1; }
+	size_t write(const uint8_t *buffer, size_t size)
+	{
+		if (position == length)
+			clear(); // Everything was read, start over
+		size = rcmin(size, sizeof bytes - length);
+		memcpy(bytes + length, buffer, size);
+		length += size;
+		return size;
+	}
+	void clear() { position = length = 0; }
+
+	uint8_t bytes[2048];
+	size_t length = 0;
+	size_t position = 0;
+};
+
+/**
+ * @brief Hands the bytes of another MemoryStream out one at a time, like a slow UART
+ *
+ */
+class TrickleStream : public NativeStream
+{
+public:
+	TrickleStream(MemoryStream &source) : source(source) {}
+	int available() { return released; }
+	int read()
+	{
+		if (!released)
+			return -1;
+		released--;
+		return source.read();
+	}
+	size_t write(const uint8_t *buffer, size_t size) { return source.write(buffer, size); }
+	void release() { released += source.available() > released ? 1 : 0; }
+
+	MemoryStream &source;
+	int released = 0;
+};
+
+void test_serialConnection_cobs()
+{
+	uint8_t output[300];
+	const uint8_t zero[1] = {0};
+	TEST_ASSERT_EQUAL_size_t(1, SerialConnection::encode(zero, 0, output));
+	TEST_ASSERT_EQUAL_HEX8(0x01, output[0]);
+	TEST_ASSERT_EQUAL_size_t(2, SerialConnection::encode(zero, 1, output));
+	TEST_ASSERT_EQUAL_HEX8(0x01, output[0]);
+	TEST_ASSERT_EQUAL_HEX8(0x01, output[1]);
+	const uint8_t mixed[4] = {0x11, 0x22, 0x00, 0x33};
+	const uint8_t mixedEncoded[5] = {0x03, 0x11, 0x22, 0x02, 0x33};
+	TEST_ASSERT_EQUAL_size_t(5, SerialConnection::encode(mixed, sizeof mixed, output));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(mixedEncoded, output, 5);
+	uint8_t block[254];
+	memset(block, 0xAB, sizeof block);
+	TEST_ASSERT_EQUAL_size_t(256, SerialConnection::encode(block, sizeof block, output));
+	TEST_ASSERT_EQUAL_HEX8(0xFF, output[0]);
+	TEST_ASSERT_EQUAL_HEX8(0x01, output[255]);
+
+	// Every length up to the maximum, with zeros in between, decoded byte by byte
+	MemoryStream wire;
+	TrickleStream trickle(wire);
+	SerialConnection sender(wire);
+	SerialConnection receiver(trickle);
+	TEST_ASSERT_TRUE(sender.begin());
+	TEST_ASSERT_TRUE(receiver.begin());
+	uint8_t packet[REMOTECONTROLLER_SERIAL_PACKET_SIZE];
+	uint8_t received[REMOTECONTROLLER_SERIAL_PACKET_SIZE];
+	for (size_t length = 1; length <= REMOTECONTROLLER_SERIAL_PACKET_SIZE; length++)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			packet[i] = (uint8_t)(i % 7 == 3 ? 0 : i * 13 + length);
+		}
+		TEST_ASSERT_TRUE(sender.write(packet, length));
+		size_t steps = 0;
+		while (!receiver.available())
+		{
+			trickle.release();
+			TEST_ASSERT_TRUE(steps++ < 2 * length + 10);
+		}
+		TEST_ASSERT_EQUAL_size_t(length, receiver.getPayloadSize());
+		receiver.read(received, sizeof received);
+		TEST_ASSERT_EQUAL_UINT8_ARRAY(packet, received, length);
+		TEST_ASSERT_FALSE(receiver.available());
+	}
+	TEST_ASSERT_EQUAL_UINT32(REMOTECONTROLLER_SERIAL_PACKET_SIZE, receiver.packetsReceived);
+	TEST_ASSERT_EQUAL_UINT32(0, receiver.framingErrors);
+	TEST_ASSERT_FALSE(sender.write(packet, REMOTECONTROLLER_SERIAL_PACKET_SIZE + 1));
+}
+
+void test_serialConnection_resync()
+{
+	MemoryStream wire;
+	SerialConnection sender(wire);
+	SerialConnection receiver(wire);
+	receiver.begin();
+	receiver.setMaxPackageSize(16);
+	const uint8_t packet[4] = {1, 0, 2, 3};
+	uint8_t received[16];
+
+	// Garbage before the first packet (e.g. boot messages) is dropped with the delimiter written by begin()
+	const uint8_t garbage[5] = {'b', 'o', 'o', 't', '\n'};
+	wire.write(garbage, sizeof garbage);
+	sender.begin();
+	sender.write(packet, sizeof packet);
+	TEST_ASSERT_TRUE(receiver.available());
+	receiver.read(received, sizeof received);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(packet, received, sizeof packet);
+	TEST_ASSERT_EQUAL_UINT32(1, receiver.framingErrors);
+
+	// A lost byte breaks one packet, the next one is found at the delimiter
+	sender.write(packet, sizeof packet);
+	wire.length -= 3;
+	wire.bytes[wire.length++] = 0;
+	sender.write(packet, sizeof packet);
+	TEST_ASSERT_TRUE(receiver.available());
+	receiver.read(received, sizeof received);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(packet, received, sizeof packet);
+	TEST_ASSERT_EQUAL_UINT32(2, receiver.framingErrors);
+
+	// Packets above the maximum package size of the receiver are dropped
+	uint8_t large[32] = {};
+	sender.write(large, sizeof large);
+	sender.write(packet, sizeof packet);
+	TEST_ASSERT_TRUE(receiver.available());
+	TEST_ASSERT_EQUAL_size_t(sizeof packet, receiver.getPayloadSize());
+	TEST_ASSERT_EQUAL_UINT32(3, receiver.framingErrors);
+	receiver.read(received, sizeof received);
+	TEST_ASSERT_FALSE(receiver.available());
+}
+
+static uint8_t serialPayload[128];
+static size_t serialPayloadLength = 0;
+static size_t serialCommandCount = 0;
+
+static void recordSerialPayload(const void *buffer, size_t length)
+{
+	memcpy(serialPayload, buffer, rcmin(length, sizeof serialPayload));
+	serialPayloadLength = length;
+}
+
+static void countSerialCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	serialCommandCount += length;
+}
+
+void test_serialConnection_pseudoTerminal()
+{
+	FdStream master, slave;
+	TEST_ASSERT_TRUE_MESSAGE(FdStream::openPtyPair(master, slave), "Failed to open a pseudo-terminal!");
+	SerialConnection senderConnection(master);
+	SerialConnection receiverConnection(slave);
+	RemoteControllerT<RemoteControllerPackageConfig<128>> sender(senderConnection);
+	RemoteControllerT<RemoteControllerPackageConfig<128>> receiver(receiverConnection);
+	serialPayloadLength = 0;
+	serialCommandCount = 0;
+	TEST_ASSERT_TRUE(sender.begin(nullptr));
+	TEST_ASSERT_TRUE(receiver.begin(countSerialCommands, recordSerialPayload));
+	sender.setFrameCheck(RemoteController::Crc16);
+	receiver.setFrameCheck(RemoteController::Crc16);
+	receiver.setReceiveBudget(8);
+
+	// Packets well above 32 bytes: 50 commands fit into the queue of two 128 byte packets, a payload of 120 bytes
+	for (uint8_t command = 0; command < 40; command++)
+	{
+		sender.sendCommand(command, command * 0.5f);
+	}
+	TEST_ASSERT_TRUE(sender.run());
+	uint8_t payload[120];
+	for (size_t i = 0; i < sizeof payload; i++)
+	{
+		payload[i] = (uint8_t)(255 - i);
+	}
+	TEST_ASSERT_TRUE(sender.sendPayload(payload, sizeof payload));
+	for (size_t i = 0; i < 200 && (serialCommandCount < 40 || serialPayloadLength == 0); i++)
+	{
+		TEST_ASSERT_TRUE(receiver.run());
+		usleep(500);
+	}
+	TEST_ASSERT_EQUAL_size_t(40, serialCommandCount);
+	TEST_ASSERT_EQUAL_size_t(sizeof payload, serialPayloadLength);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, serialPayload, sizeof payload);
+	TEST_ASSERT_EQUAL_UINT32(0, receiverConnection.framingErrors);
+
+	sender.end();
+	receiver.end();
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/SimulatedConnection.h"
+
+// SimulatedConnection (deterministic lossy channel on a virtual clock)
+
+static uint32_t lossPattern(uint32_t seed)
+{
+	SimulatedConnection sender(seed);
+	SimulatedConnection receiver(sender);
+	receiver.begin();
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.3f;
+	sender.setChannel(channel);
+
+	// Bit n set = write n was lost
+	uint32_t pattern = 0;
+	const uint8_t packet[4] = {1, 2, 3, 4};
+	for (size_t i = 0; i < 32; i++)
+	{
+		if (!sender.write(packet, sizeof packet))
+		{
+			pattern |= 1UL << i;
+		}
+		while (receiver.available())
+		{
+			uint8_t buffer[4];
+			receiver.read(buffer, sizeof buffer);
+		}
+	}
+	return pattern;
+}
+
+void test_simulatedConnection_deterministic()
+{
+	TEST_ASSERT_EQUAL_HEX32(lossPattern(42), lossPattern(42));
+	TEST_ASSERT_NOT_EQUAL(lossPattern(42), lossPattern(43));
+
+	SimulatedConnection sender(7);
+	SimulatedConnection receiver(sender);
+	receiver.begin();
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.2f;
+	sender.setChannel(channel);
+	const uint8_t packet[4] = {1, 2, 3, 4};
+	for (size_t i = 0; i < 10000; i++)
+	{
+		sender.write(packet, sizeof packet);
+		uint8_t buffer[4];
+		receiver.read(buffer, sizeof buffer);
+	}
+	TEST_ASSERT_UINT32_WITHIN(300, 2000, sender.packetsLost);
+	TEST_ASSERT_EQUAL_UINT32(10000 - sender.packetsLost, receiver.packetsRead);
+}
+
+void test_simulatedConnection_latencyJitterAndBandwidth()
+{
+	SimulatedConnection sender;
+	SimulatedConnection receiver(sender);
+	receiver.begin();
+	SimulatedConnection::Channel channel;
+	channel.latencyMicros = 1000;
+	channel.jitterMicros = 5000;
+	channel.bytesPerSecond = 250000; // 4us per byte
+	sender.setChannel(channel);
+
+	const uint32_t start = SimulatedConnection::now();
+	uint8_t packet[4];
+	for (uint8_t i = 0; i < 20; i++)
+	{
+		packet[0] = i;
+		TEST_ASSERT_TRUE(sender.write(packet, sizeof packet));
+	}
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(20 * 16, SimulatedConnection::now() - start, "Each write blocks for its airtime!");
+	TEST_ASSERT_FALSE_MESSAGE(receiver.available(), "No packet arrives before the latency passed!");
+	TEST_ASSERT_EQUAL_size_t(20, receiver.queuedPackets());
+
+	// Every packet arrives within latency + jitter, some overtake others
+	SimulatedConnection::advance(1000 + 5000);
+	bool reordered = false;
+	int previous = -1;
+	for (size_t i = 0; i < 20; i++)
+	{
+		TEST_ASSERT_TRUE(receiver.available());
+		receiver.read(packet, sizeof packet);
+		reordered |= packet[0] < previous;
+		previous = packet[0];
+	}
+	TEST_ASSERT_FALSE(receiver.available());
+	TEST_ASSERT_TRUE(reordered);
+}
+
+void test_simulatedConnection_ackLossDuplicates()
+{
+	SimulatedConnection sender(3);
+	SimulatedConnection receiver(sender);
+	receiver.begin();
+	SimulatedConnection::Channel channel;
+	channel.ackLoss = 1.0f;
+	channel.duplicate = 1.0f;
+	sender.setChannel(channel);
+
+	const uint8_t packet[4] = {1, 2, 3, 4};
+	TEST_ASSERT_FALSE_MESSAGE(sender.write(packet, sizeof packet), "Without ack the write fails although the packet arrives!");
+	TEST_ASSERT_EQUAL_size_t(2, receiver.queuedPackets());
+	TEST_ASSERT_EQUAL_UINT32(1, sender.acksLost);
+	TEST_ASSERT_EQUAL_UINT32(1, sender.packetsDuplicated);
+}
+
+static size_t simulatedCommands;
+
+void test_simulatedConnection_commandsUnderLoss()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection(11);
+	SimulatedConnection receiverConnection(senderConnection, 12);
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.3f;
+	channel.ackLoss = 0.05f;
+	channel.latencyMicros = 500;
+	channel.jitterMicros = 200;
+	senderConnection.setChannel(channel);
+	RemoteController sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+
+	simulatedCommands = 0;
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { simulatedCommands += length; });
+	receiver.setReceiveBudget(4);
+
+	// Failed writes leave the commands queued, every command arrives at least once
+	for (size_t i = 0; i < 200; i++)
+	{
+		sender.sendCommand((uint8_t)i, 0.5f);
+		for (size_t tries = 0; tries < 50 && !sender.run(); tries++)
+		{
+			SimulatedConnection::advance(100);
+		}
+		SimulatedConnection::advance(1000);
+		receiver.run();
+	}
+	SimulatedConnection::advance(1000);
+	receiver.run();
+	TEST_ASSERT_TRUE(senderConnection.packetsLost > 0);
+	TEST_ASSERT_TRUE(simulatedCommands >= 200);
+	TEST_ASSERT_EQUAL_size_t(200 + senderConnection.acksLost + senderConnection.packetsDuplicated, simulatedCommands);
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
+
+static uint8_t simulatedPayload[2000];
+static uint8_t simulatedReassembled[2000];
+static size_t simulatedPayloadsReceived;
+
+void test_simulatedConnection_largePayloadUnderLoss()
+{
+	SimulatedConnection::useVirtualClock(true);
+	SimulatedConnection senderConnection(21);
+	SimulatedConnection receiverConnection(senderConnection, 22);
+	SimulatedConnection::Channel channel;
+	channel.loss = 0.2f;
+	channel.latencyMicros = 300;
+	channel.jitterMicros = 400; // Fragments arrive out of order
+	senderConnection.setChannel(channel);
+	receiverConnection.setChannel(channel); // Acknowledgements get lost as well
+	LargePayloadController sender(senderConnection);
+	LargePayloadController receiver(receiverConnection);
+
+	for (size_t i = 0; i < sizeof simulatedPayload; i++)
+	{
+		simulatedPayload[i] = (uint8_t)(i * 13);
+	}
+	simulatedPayloadsReceived = 0;
+	sender.begin(nullptr);
+	receiver.begin(nullptr, [](const void *buffer, size_t length) -> void
+				   { simulatedPayloadsReceived++; });
+	receiver.setLargePayloadBuffer(simulatedReassembled, sizeof simulatedReassembled);
+	receiver.setReceiveBudget(REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH);
+	sender.setReceiveBudget(REMOTECONTROLLER_SIMULATED_QUEUE_LENGTH);
+
+	TEST_ASSERT_TRUE(sender.sendLargePayload(simulatedPayload, sizeof simulatedPayload));
+	for (size_t i = 0; i < 10000 && sender.isSendingLargePayload(); i++)
+	{
+		sender.run();
+		SimulatedConnection::advance(100);
+		receiver.run();
+		SimulatedConnection::advance(100);
+	}
+	TEST_ASSERT_FALSE(sender.isSendingLargePayload());
+	TEST_ASSERT_EQUAL_size_t(1, simulatedPayloadsReceived);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(simulatedPayload, simulatedReassembled, sizeof simulatedPayload);
+	TEST_ASSERT_TRUE(sender.getTransferStats().retransmissions > 0);
+	sender.end();
+	receiver.end();
+	SimulatedConnection::useVirtualClock(false);
+}
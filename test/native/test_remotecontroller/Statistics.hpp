@@ -0,0 +1,86 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// RemoteController::getStatistics() (env:test_native is built with REMOTECONTROLLER_STATISTICS, env:test_native_no_statistics without it)
+
+void test_statistics_buckets()
+{
+	TEST_ASSERT_EQUAL_UINT8(0, RemoteController::Statistics::bucket(0));
+	TEST_ASSERT_EQUAL_UINT8(0, RemoteController::Statistics::bucket(15));
+	TEST_ASSERT_EQUAL_UINT8(1, RemoteController::Statistics::bucket(16));
+	TEST_ASSERT_EQUAL_UINT8(2, RemoteController::Statistics::bucket(32));
+	TEST_ASSERT_EQUAL_UINT8(2, RemoteController::Statistics::bucket(63));
+	TEST_ASSERT_EQUAL_UINT8(REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS - 1, RemoteController::Statistics::bucket(UINT32_MAX));
+	for (uint8_t bucket = 0; bucket < REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS; bucket++)
+	{
+		TEST_ASSERT_EQUAL_UINT8(bucket, RemoteController::Statistics::bucket(RemoteController::Statistics::bucketMinMicros(bucket)));
+	}
+}
+
+static uint32_t histogramTotal(const uint16_t histogram[])
+{
+	uint32_t total = 0;
+	for (size_t i = 0; i < REMOTECONTROLLER_STATISTICS_HISTOGRAM_BUCKETS; i++)
+	{
+		total += histogram[i];
+	}
+	return total;
+}
+
+void test_statistics_counters()
+{
+#ifndef REMOTECONTROLLER_STATISTICS
+	TEST_IGNORE_MESSAGE("Needs REMOTECONTROLLER_STATISTICS");
+#endif
+	LoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteControllerT<RemoteControllerPackageConfig<32, 1>> sender(senderConnection); // 6 v1 commands fit into the queue
+	RemoteController receiver(receiverConnection);
+	sender.begin(nullptr);
+
+	// The receiver is not listening: the write fails and is retried
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		sender.sendCommand(i, 0.5f);
+	}
+	TEST_ASSERT_FALSE(sender.run());
+	RemoteController::Statistics statistics = sender.getStatistics();
+	TEST_ASSERT_EQUAL_UINT32(2, statistics.commandsDropped);
+	TEST_ASSERT_EQUAL_UINT16(6, statistics.commandQueueHighWatermark);
+	TEST_ASSERT_EQUAL_UINT32(0, statistics.packetsSent);
+	TEST_ASSERT_EQUAL_UINT32(1, statistics.writeFailures);
+	TEST_ASSERT_EQUAL_UINT32(0, statistics.writeRetries);
+
+	receiver.begin(nullptr);
+	TEST_ASSERT_TRUE(sender.run());
+	statistics = sender.getStatistics();
+	TEST_ASSERT_EQUAL_UINT32(1, statistics.packetsSent);
+	TEST_ASSERT_EQUAL_UINT32(2 + 6 * REMOTECONTROLLER_ENCODED_COMMAND_SIZE, statistics.bytesSent);
+	TEST_ASSERT_EQUAL_UINT32(1, statistics.writeRetries);
+	TEST_ASSERT_EQUAL_UINT32(2, histogramTotal(statistics.runMicros));
+	TEST_ASSERT_EQUAL_UINT32(2, histogramTotal(statistics.writeMicros));
+
+	TEST_ASSERT_TRUE(receiver.run());
+	statistics = receiver.getStatistics();
+	TEST_ASSERT_EQUAL_UINT32(1, statistics.packetsReceived);
+	TEST_ASSERT_EQUAL_UINT32(2 + 6 * REMOTECONTROLLER_ENCODED_COMMAND_SIZE, statistics.bytesReceived);
+
+	// Truncated v2 packet
+	const uint8_t corrupt[] = {(uint8_t)(REMOTECONTROLLER_IDENTIFIER_COMMAND_V2 >> 8), (uint8_t)REMOTECONTROLLER_IDENTIFIER_COMMAND_V2, 0x01, RemoteController::ThrottleFloat, 0x00};
+	TEST_ASSERT_TRUE(sender.sendPayload(corrupt, sizeof corrupt));
+	TEST_ASSERT_FALSE(receiver.run());
+	TEST_ASSERT_EQUAL_UINT32(1, receiver.getStatistics().corruptPackets);
+
+	sender.resetStatistics();
+	statistics = sender.getStatistics();
+	TEST_ASSERT_EQUAL_UINT32(0, statistics.packetsSent);
+	TEST_ASSERT_EQUAL_UINT16(0, statistics.commandQueueHighWatermark);
+	TEST_ASSERT_EQUAL_UINT32(0, histogramTotal(statistics.runMicros));
+	sender.end();
+	receiver.end();
+}
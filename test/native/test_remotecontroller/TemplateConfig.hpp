@@ -0,0 +1,80 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// RemoteControllerT: buffers sized at compile time per RemoteController
+
+typedef RemoteControllerT<RemoteControllerPackageConfig<16, 1>> SmallRemoteController;
+
+void test_templateConfig_constants()
+{
+	static_assert(SmallRemoteController::PackageSize == 16, "package size");
+	static_assert(SmallRemoteController::CommandQueueLength == 2, "two v1 commands fit into 16 bytes");
+	static_assert(RemoteController::CommandQueueLength == REMOTECONTROLLER_COMMAND_QUEUE_LENGTH, "default config");
+	static_assert(RemoteController::OutgoingBufferSize == REMOTECONTROLLER_OUTGOING_BUFFER_SIZE * REMOTECONTROLLER_OUTGOING_BATCH_SIZE, "default config");
+	TEST_ASSERT_TRUE(sizeof(SmallRemoteController) < sizeof(RemoteController));
+}
+
+void test_templateConfig_differentSizesInOneFirmware()
+{
+	LoopbackConnection smallConnection;
+	LoopbackConnection receiverConnection(smallConnection);
+	SmallRemoteController small(smallConnection); // The connection allows 32 byte packets, the configuration only 16
+	RemoteController receiver(receiverConnection);
+
+	static size_t commandsReceived;
+	commandsReceived = 0;
+	small.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { commandsReceived += length; });
+	receiver.setReceiveBudget(2);
+
+	small.sendCommand(1, 0.5f);
+	small.sendCommand(2, 0.5f);
+	small.sendCommand(3, 0.5f); // Does not fit into the queue anymore
+	TEST_ASSERT_EQUAL_UINT8(RemoteController::CommandQueueFull, small.getErrorCode());
+	TEST_ASSERT_FALSE(small.run());
+
+	// Both commands were sent in one packet of at most 16 bytes
+	TEST_ASSERT_EQUAL_size_t(1, receiverConnection.queuedPackets());
+	TEST_ASSERT_EQUAL_size_t(2 + 2 * REMOTECONTROLLER_ENCODED_COMMAND_SIZE, receiverConnection.getPayloadSize());
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(2, commandsReceived);
+	small.end();
+	receiver.end();
+}
+
+/**
+ * @brief LoopbackConnection that can be bound at compile time
+ *
+ */
+class FinalLoopbackConnection final : public LoopbackConnection
+{
+};
+
+void test_templateConfig_staticDispatch()
+{
+	FinalLoopbackConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	RemoteControllerT<RemoteControllerDefaultConfig, FinalLoopbackConnection> sender(senderConnection);
+	RemoteController receiver(receiverConnection);
+
+	static size_t commandsReceived;
+	commandsReceived = 0;
+	sender.begin(nullptr);
+	receiver.begin([](const uint8_t commands[], const float throttles[], size_t length) -> void
+				   { commandsReceived += length; });
+
+	sender.sendCommand(RemoteController::GoForward, 0.5f);
+	sender.sendCommand(RemoteController::GoLeft, RemoteController::High);
+	TEST_ASSERT_TRUE(sender.run());
+	receiver.setReceiveBudget(2);
+	TEST_ASSERT_TRUE(receiver.run());
+	TEST_ASSERT_EQUAL_size_t(2, commandsReceived);
+	sender.end();
+	receiver.end();
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RemoteController.h"
+#include "Connections/UdpConnection.h"
+
+// UdpConnection between two sockets on localhost
+
+static uint8_t udpCommands[256];
+static size_t udpCommandCount = 0;
+static uint8_t udpPayload[1024];
+static size_t udpPayloadLength = 0;
+
+static void recordUdpCommands(const uint8_t commands[], const float throttles[], size_t length)
+{
+	for (size_t i = 0; i < length && udpCommandCount < sizeof udpCommands; i++)
+	{
+		udpCommands[udpCommandCount++] = commands[i];
+	}
+}
+
+static void recordUdpPayload(const void *buffer, size_t length)
+{
+	memcpy(udpPayload, buffer, rcmin(length, sizeof udpPayload));
+	udpPayloadLength = length;
+}
+
+void test_udpConnection_roundTrip()
+{
+	UdpConnection vehicleConnection; // Server: answers whoever sent the last packet
+	UdpConnection remoteConnection;
+	RemoteControllerT<RemoteControllerPackageConfig<1024>> vehicle(vehicleConnection);
+	RemoteControllerT<RemoteControllerPackageConfig<1024>> remote(remoteConnection);
+	udpCommandCount = 0;
+	udpPayloadLength = 0;
+	TEST_ASSERT_TRUE(vehicle.begin(recordUdpCommands, recordUdpPayload));
+	TEST_ASSERT_NOT_EQUAL(0, vehicleConnection.getLocalPort());
+	TEST_ASSERT_TRUE(remoteConnection.setRemote("127.0.0.1", vehicleConnection.getLocalPort()));
+	TEST_ASSERT_TRUE(remote.begin(recordUdpCommands));
+	TEST_ASSERT_TRUE(remoteConnection.hasCapability(Connection::BatchWrite));
+	vehicle.setReceiveBudget(4);
+
+	// 150 commands in one datagram, a payload far above 32 bytes
+	for (size_t command = 0; command < 150; command++)
+	{
+		remote.sendCommand((uint8_t)command, (float)command);
+	}
+	TEST_ASSERT_TRUE(remote.run());
+	TEST_ASSERT_TRUE(vehicleConnection.waitForPacket(1000));
+	TEST_ASSERT_TRUE(vehicle.run());
+	TEST_ASSERT_EQUAL_size_t(150, udpCommandCount);
+	TEST_ASSERT_EQUAL_UINT8(149, udpCommands[149]);
+	uint8_t payload[1000];
+	for (size_t i = 0; i < sizeof payload; i++)
+	{
+		payload[i] = (uint8_t)(i * 7);
+	}
+	TEST_ASSERT_TRUE(remote.sendPayload(payload, sizeof payload));
+	TEST_ASSERT_TRUE(vehicleConnection.waitForPacket(1000));
+	TEST_ASSERT_TRUE(vehicle.run());
+	TEST_ASSERT_EQUAL_size_t(sizeof payload, udpPayloadLength);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, udpPayload, sizeof payload);
+
+	// The vehicle replies to the address it learned
+	udpCommandCount = 0;
+	vehicle.sendCommand(42, RemoteController::High);
+	TEST_ASSERT_TRUE(remoteConnection.waitForPacket(1000));
+	TEST_ASSERT_TRUE(remote.run());
+	TEST_ASSERT_EQUAL_size_t(1, udpCommandCount);
+	TEST_ASSERT_EQUAL_UINT8(42, udpCommands[0]);
+	TEST_ASSERT_EQUAL_UINT32(0, vehicleConnection.datagramsDropped);
+
+	vehicle.end();
+	remote.end();
+}
+
+void test_udpConnection_dropsAndBatches()
+{
+	UdpConnection receiver;
+	UdpConnection sender;
+	UdpConnection stranger;
+	uint8_t packet[100];
+	memset(packet, 0x33, sizeof packet);
+
+	// Nobody to write to yet
+	TEST_ASSERT_TRUE(sender.begin());
+	TEST_ASSERT_FALSE(sender.write(packet, 10));
+
+	TEST_ASSERT_TRUE(receiver.begin());
+	receiver.setMaxPackageSize(64);
+	TEST_ASSERT_EQUAL_size_t(64, receiver.getMaxPackageSize());
+	TEST_ASSERT_TRUE(receiver.setRemote("localhost", sender.getLocalPort()));
+	TEST_ASSERT_TRUE(sender.setRemote("127.0.0.1", receiver.getLocalPort()));
+	TEST_ASSERT_TRUE(stranger.begin());
+	TEST_ASSERT_TRUE(stranger.setRemote("127.0.0.1", receiver.getLocalPort()));
+
+	// Datagrams above the maximum package size and from other addresses are dropped
+	TEST_ASSERT_TRUE(sender.write(packet, sizeof packet));
+	TEST_ASSERT_TRUE(stranger.write(packet, 10));
+	packet[0] = 1;
+	TEST_ASSERT_TRUE(sender.write(packet, 20));
+	TEST_ASSERT_TRUE(receiver.waitForPacket(1000));
+	TEST_ASSERT_EQUAL_size_t(20, receiver.getPayloadSize());
+	TEST_ASSERT_EQUAL_UINT32(2, receiver.datagramsDropped);
+	uint8_t received[64];
+	receiver.read(received, sizeof received);
+	TEST_ASSERT_EQUAL_UINT8(1, received[0]);
+	TEST_ASSERT_FALSE(receiver.available());
+	receiver.setMaxPackageSize(5000);
+	TEST_ASSERT_EQUAL_size_t(REMOTECONTROLLER_UDP_PACKET_SIZE, receiver.getMaxPackageSize());
+
+	// A batch arrives in order, one datagram per packet
+	uint8_t packets[3][8];
+	const void *buffers[3] = {packets[0], packets[1], packets[2]};
+	const size_t lengths[3] = {8, 4, 6};
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		memset(packets[i], i + 10, sizeof packets[i]);
+	}
+	TEST_ASSERT_EQUAL_size_t(3, sender.writeBatch(buffers, lengths, 3));
+	for (size_t i = 0; i < 3; i++)
+	{
+		TEST_ASSERT_TRUE(receiver.waitForPacket(1000));
+		TEST_ASSERT_EQUAL_size_t(lengths[i], receiver.getPayloadSize());
+		receiver.read(received, sizeof received);
+		TEST_ASSERT_EQUAL_UINT8(i + 10, received[0]);
+	}
+	TEST_ASSERT_EQUAL_UINT32(4, receiver.packetsReceived);
+
+	sender.end();
+	TEST_ASSERT_FALSE(sender.write(packet, 10));
+	receiver.end();
+	stranger.end();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <unity.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "RemoteController.h"
+#include "Connections/LoopbackConnection.h"
+
+// Connection::writeBatch() used by RemoteController::run() for connections with Connection::BatchWrite
+
+/**
+ * @brief LoopbackConnection that records the batches and can fail after a number of packets
+ *
+ */
+class BatchRecordingConnection : public LoopbackConnection
+{
+public:
+	size_t batches = 0;
+	size_t batchSizes[16];
+	size_t failAfterPackets = (size_t)-1; // Packets that are transmitted before the next batch fails
+
+	size_t writeBatch(const void *const buffers[], const size_t lengths[], size_t count)
+	{
+		batchSizes[batches++] = count;
+		size_t allowed = count < failAfterPackets ? count : failAfterPackets;
+		failAfterPackets = (size_t)-1;
+		return LoopbackConnection::writeBatch(buffers, lengths, allowed) == count ? count : allowed;
+	}
+};
+
+void test_writeBatch_packetsPerBatch()
+{
+	BatchRecordingConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	senderConnection.setMaxPackageSize(2 + REMOTECONTROLLER_ENCODED_COMMAND_SIZE); // One command per packet
+	RemoteController sender(senderConnection);
+	sender.begin(nullptr);
+	receiverConnection.begin();
+
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		sender.sendCommand(i);
+	}
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(2, senderConnection.batches);
+	TEST_ASSERT_EQUAL_size_t(REMOTECONTROLLER_OUTGOING_BATCH_SIZE, senderConnection.batchSizes[0]);
+	TEST_ASSERT_EQUAL_size_t(4 - REMOTECONTROLLER_OUTGOING_BATCH_SIZE, senderConnection.batchSizes[1]);
+	TEST_ASSERT_EQUAL_size_t(4, receiverConnection.queuedPackets());
+	sender.end();
+}
+
+void test_writeBatch_resumesAfterPartialBatch()
+{
+	BatchRecordingConnection senderConnection;
+	LoopbackConnection receiverConnection(senderConnection);
+	senderConnection.setMaxPackageSize(2 + REMOTECONTROLLER_ENCODED_COMMAND_SIZE);
+	RemoteController sender(senderConnection);
+	sender.begin(nullptr);
+	receiverConnection.begin();
+
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		sender.sendCommand(i);
+	}
+	senderConnection.failAfterPackets = 1;
+	TEST_ASSERT_FALSE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(1, receiverConnection.queuedPackets());
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_EQUAL_UINT32_MESSAGE(1, sender.getStatistics().writeFailures, "Only the second packet failed, the third one was never written!");
+#endif
+	TEST_ASSERT_TRUE(sender.run());
+	TEST_ASSERT_EQUAL_size_t(3, receiverConnection.queuedPackets());
+#ifdef REMOTECONTROLLER_STATISTICS
+	TEST_ASSERT_EQUAL_UINT32(1, sender.getStatistics().writeFailures);
+	TEST_ASSERT_EQUAL_UINT32(1, sender.getStatistics().writeRetries);
+	TEST_ASSERT_EQUAL_UINT32(3, sender.getStatistics().packetsSent);
+#endif
+
+	// The packets arrive in order and exactly once
+	uint8_t packet[8];
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		receiverConnection.read(packet, sizeof packet);
+		TEST_ASSERT_EQUAL_UINT8(i, packet[2]);
+	}
+	sender.end();
+}
@@ -12,6 +12,26 @@
 #include "Run.hpp"
 #include "SendCommand.hpp"
 #include "SendPayload.hpp"
+#include "ProtocolV2.hpp"
+#include "QueuePolicy.hpp"
+#include "CommandView.hpp"
+#include "WriteBatch.hpp"
+#include "AckPayload.hpp"
+#include "InterruptConnection.hpp"
+#include "LargePayload.hpp"
+#include "TemplateConfig.hpp"
+#include "CommandHandlers.hpp"
+#include "Statistics.hpp"
+#include "SimulatedConnection.hpp"
+#include "SequenceNumbers.hpp"
+#include "PriorityAndTtl.hpp"
+#include "AsyncWrite.hpp"
+#include "Pump.hpp"
+#include "MultiPeer.hpp"
+#include "FrameCheck.hpp"
+#include "SerialConnection.hpp"
+#include "UdpConnection.hpp"
+#include "Capture.hpp"
 
 void setUp(void)
 {
@@ -42,8 +62,82 @@ int main(int argc, char **argv)
 	RUN_TEST(test_sendCommandPackageSize);
 	RUN_TEST(test_sendPayload);
 	RUN_TEST(test_run);
+	RUN_TEST(test_run_resumesPartialTransmission);
+	RUN_TEST(test_run_commandQueueWrapsAround);
 	RUN_TEST(test_receiveCommands);
 	RUN_TEST(test_receivePayload);
+	RUN_TEST(test_receiveBudget_packets);
+	RUN_TEST(test_receiveBudget_micros);
+	RUN_TEST(test_receiveBudget_aggregateCommands);
+	RUN_TEST(test_protocolV2_encoding);
+	RUN_TEST(test_protocolV2_packing);
+	RUN_TEST(test_protocolV2_receive);
+	RUN_TEST(test_protocolV2_receiveCorrupt);
+	RUN_TEST(test_protocolV1andV2_loopback);
+	RUN_TEST(test_queuePolicy_default);
+	RUN_TEST(test_queuePolicy_coalesce);
+	RUN_TEST(test_queuePolicy_coalesceDoesNotFillQueue);
+	RUN_TEST(test_commandView_v1);
+	RUN_TEST(test_commandView_v2AndArrayCallback);
+	RUN_TEST(test_writeBatch_packetsPerBatch);
+	RUN_TEST(test_writeBatch_resumesAfterPartialBatch);
+	RUN_TEST(test_ackPayload_payloadReply);
+	RUN_TEST(test_ackPayload_commandReplyAndFullQueue);
+	RUN_TEST(test_packetRing_spscStress);
+	RUN_TEST(test_interruptConnection_overflow);
+	RUN_TEST(test_interruptConnection_producerThread);
+	RUN_TEST(test_interruptConnection_largePackets);
+	RUN_TEST(test_largePayload_transfer);
+	RUN_TEST(test_largePayload_selectiveRetransmit);
+	RUN_TEST(test_largePayload_reordered);
+	RUN_TEST(test_largePayload_failedWriteRetransmit);
+	RUN_TEST(test_largePayload_bufferTooSmall);
+	RUN_TEST(test_largePayload_featureDisabled);
+	RUN_TEST(test_templateConfig_constants);
+	RUN_TEST(test_templateConfig_differentSizesInOneFirmware);
+	RUN_TEST(test_templateConfig_staticDispatch);
+	RUN_TEST(test_commandHandlers_dispatch);
+	RUN_TEST(test_commandHandlers_tableFull);
+	RUN_TEST(test_statistics_buckets);
+	RUN_TEST(test_statistics_counters);
+	RUN_TEST(test_simulatedConnection_deterministic);
+	RUN_TEST(test_simulatedConnection_latencyJitterAndBandwidth);
+	RUN_TEST(test_simulatedConnection_ackLossDuplicates);
+	RUN_TEST(test_simulatedConnection_commandsUnderLoss);
+	RUN_TEST(test_simulatedConnection_largePayloadUnderLoss);
+	RUN_TEST(test_sequenceNumbers_duplicateDropped);
+	RUN_TEST(test_sequenceNumbers_window);
+	RUN_TEST(test_sequenceNumbers_deliveryModes);
+	RUN_TEST(test_sequenceNumbers_exactlyOnceUnderLoss);
+	RUN_TEST(test_sequenceNumbers_featureDisabled);
+	RUN_TEST(test_priority_mostUrgentFirst);
+	RUN_TEST(test_priority_valuesOfOlderVersions);
+	RUN_TEST(test_priority_coalesceKeepsHigherPriority);
+	RUN_TEST(test_ttl_staleCommandsDropped);
+	RUN_TEST(test_ttl_coarseDeadline);
+	RUN_TEST(test_asyncWrite_defaultAdapter);
+	RUN_TEST(test_asyncWrite_runDoesNotWait);
+	RUN_TEST(test_asyncWrite_packetInFlightIsLocked);
+	RUN_TEST(test_asyncWrite_largePayloadUnderLoss);
+	RUN_TEST(test_mpscRing_stress);
+	RUN_TEST(test_pump_multiProducerSendCommand);
+	RUN_TEST(test_pump_stopWhileSending);
+	RUN_TEST(test_pump_needsFeature);
+	RUN_TEST(test_multiPeer_routing);
+	RUN_TEST(test_multiPeer_roundRobin);
+	RUN_TEST(test_multiPeer_unknownAndWaitingPackets);
+	RUN_TEST(test_multiPeer_ackPayloads);
+	RUN_TEST(test_crc_checkValues);
+	RUN_TEST(test_frameCheck_roundTrip);
+	RUN_TEST(test_frameCheck_bitErrorDetected);
+	RUN_TEST(test_serialConnection_cobs);
+	RUN_TEST(test_serialConnection_resync);
+	RUN_TEST(test_serialConnection_pseudoTerminal);
+	RUN_TEST(test_udpConnection_roundTrip);
+	RUN_TEST(test_udpConnection_dropsAndBatches);
+	RUN_TEST(test_captureLog_records);
+	RUN_TEST(test_capture_replayReproducesReceiver);
+	RUN_TEST(test_capture_replayOriginalSpeedAndFailures);
 
 	UNITY_END();
 }